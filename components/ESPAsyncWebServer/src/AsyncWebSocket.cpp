@@ -1292,8 +1292,30 @@ void AsyncWebSocket::handleRequest(AsyncWebServerRequest *request) {
   }
   if (request->hasHeader(WS_STR_PROTOCOL)) {
     const AsyncWebHeader *protocol = request->getHeader(WS_STR_PROTOCOL);
-    // ToDo: check protocol
-    response->addHeader(WS_STR_PROTOCOL, protocol->value());
+    if (_protocols.empty()) {
+      response->addHeader(WS_STR_PROTOCOL, protocol->value());
+    } else {
+      // "a, b, c": the server has to pick exactly one of the offered protocols
+      const String &offered = protocol->value();
+      int start = 0;
+      bool selected = false;
+      while (!selected && start <= (int)offered.length()) {
+        int end = offered.indexOf(',', start);
+        if (end < 0) {
+          end = offered.length();
+        }
+        String candidate = offered.substring(start, end);
+        candidate.trim();
+        for (const String &p : _protocols) {
+          if (candidate == p) {
+            response->addHeader(WS_STR_PROTOCOL, p);
+            selected = true;
+            break;
+          }
+        }
+        start = end + 1;
+      }
+    }
   }
   request->send(response);
 }
@@ -299,6 +299,7 @@ private:
   uint32_t _cNextId;
   AwsEventHandler _eventHandler;
   AwsHandshakeHandler _handshakeHandler;
+  std::vector<String> _protocols;
   bool _enabled;
 #ifdef ESP32
   mutable std::mutex _lock;
@@ -385,6 +386,12 @@ public:
   void handleHandshake(AwsHandshakeHandler handler) {
     _handshakeHandler = handler;
   }
+  // Subprotocols accepted in the handshake. The first one offered by the client that is in
+  // this list is selected; without a match no protocol is echoed. Empty list: echo the
+  // client's header unchanged (previous behaviour).
+  void addProtocol(const String &protocol) {
+    _protocols.push_back(protocol);
+  }
 
   // system callbacks (do not call)
   uint32_t _getNextId() {
@@ -38,15 +38,16 @@ RmtController5::~RmtController5() {
 
 void RmtController5::loadPixelData(PixelIterator &pixels) {
     const bool is_rgbw = pixels.get_rgbw().active();
+    if (mLedStrip && mLedStrip->numPixels() != pixels.size()) {
+        // The controller's length changed (CLEDController::setLeds): rebuild the strip
+        // instead of writing past the end of the RMT pixel buffer.
+        delete mLedStrip;
+        mLedStrip = nullptr;
+    }
     if (!mLedStrip) {
         uint16_t t0h, t0l, t1h, t1l;
         convert_fastled_timings_to_timedeltas(mT1, mT2, mT3, &t0h, &t0l, &t1h, &t1l);
         mLedStrip = IRmtStrip::Create(mPin, pixels.size(), is_rgbw, t0h, t0l, t1h, t1l, 280, IRmtStrip::DMA_AUTO);
-        
-    } else {
-        FASTLED_ASSERT(
-            mLedStrip->numPixels() == pixels.size(),
-            "mLedStrip->numPixels() (" << mLedStrip->numPixels() << ") != pixels.size() (" << pixels.size() << ")");
     }
     if (is_rgbw) {
         uint8_t r, g, b, w;
@@ -69,7 +70,12 @@ void RmtController5::loadPixelData(PixelIterator &pixels) {
 }
 
 void RmtController5::showPixels() {
+#if FASTLED_RMT5_ASYNC_SHOW
+    // Returns once the transfer is started; the next show() waits if it is still running.
     mLedStrip->drawAsync();
+#else
+    mLedStrip->drawSync();
+#endif
 }
 
 FASTLED_NAMESPACE_END
@@ -13,6 +13,7 @@
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_check.h"
+#include "soc/soc_caps.h"
 #include "fl/namespace.h"
 
 FASTLED_NAMESPACE_BEGIN
@@ -63,8 +64,16 @@ led_strip_handle_t configure_led_with_timings(int pin, uint32_t led_count, bool
 
     // LED Strip object handle
     led_strip_handle_t led_strip;
-    ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip));
-    ESP_LOGI(TAG, "Created LED strip object with RMT backend");
+    esp_err_t err = led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip);
+    if (err != ESP_OK && with_dma) {
+        // No free DMA channel: fall back to the plain RMT memory block.
+        ESP_LOGW(TAG, "RMT with DMA failed (%s), retrying without DMA", esp_err_to_name(err));
+        rmt_config.mem_block_symbols = 0;
+        rmt_config.flags.with_dma = false;
+        err = led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip);
+    }
+    ESP_ERROR_CHECK(err);
+    ESP_LOGI(TAG, "Created LED strip object with RMT backend (dma=%d)", (int)rmt_config.flags.with_dma);
     return led_strip;
 }
 
@@ -76,6 +85,9 @@ public:
         : mIsRgbw(is_rgbw), mLedCount(led_count)
     {
         bool with_dma = dma_mode == IRmtStrip::DMA_ENABLED;
+#if SOC_RMT_SUPPORT_DMA
+        with_dma = with_dma || dma_mode == IRmtStrip::DMA_AUTO;
+#endif
         led_strip_handle_t led_strip = configure_led_with_timings(pin, led_count, is_rgbw, th0, tl0, th1, tl1, reset, with_dma, interrupt_priority);
         mStrip = led_strip;
     }
@@ -51,6 +51,14 @@
 #endif
 
 
+// Asynchronous show(): the pixel data is copied into a second buffer that the RMT
+// transmits from, so show() returns as soon as the transfer is started and only the
+// next show() waits if that transfer is still running. Set to 0 to block in show()
+// until the strip has been written.
+#ifndef FASTLED_RMT5_ASYNC_SHOW
+#define FASTLED_RMT5_ASYNC_SHOW 1
+#endif
+
 // Note that FASTLED_RMT5 is a legacy name,
 // so we keep it because "RMT" is specific to ESP32
 #if FASTLED_ESP32_HAS_RMT5 && !defined(FASTLED_RMT5)
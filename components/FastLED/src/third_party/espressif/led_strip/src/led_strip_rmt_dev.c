@@ -55,7 +55,8 @@ typedef struct {
     uint32_t strip_len;
     uint8_t bytes_per_pixel;
     led_color_component_format_t component_fmt;
-    uint8_t pixel_buf[];
+    uint8_t *tx_buf;      // buffer handed to the RMT (== pixel_buf without FASTLED_RMT5_ASYNC_SHOW)
+    uint8_t pixel_buf[];  // written by set_pixel
 } led_strip_rmt_obj;
 
 static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
@@ -102,9 +103,15 @@ static esp_err_t led_strip_rmt_refresh_async(led_strip_t *strip)
         .loop_count = 0,
     };
 
+    size_t len = rmt_strip->strip_len * rmt_strip->bytes_per_pixel;
+    // Callers must wait for the previous transfer before refreshing again, so tx_buf
+    // is idle here. Snapshotting the front buffer lets set_pixel run during the transfer.
+    if (rmt_strip->tx_buf != rmt_strip->pixel_buf) {
+        memcpy(rmt_strip->tx_buf, rmt_strip->pixel_buf, len);
+    }
     ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
-    ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->pixel_buf,
-                                     rmt_strip->strip_len * rmt_strip->bytes_per_pixel, &tx_conf), TAG, "transmit pixels by RMT failed");
+    ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->tx_buf,
+                                     len, &tx_conf), TAG, "transmit pixels by RMT failed");
     return ESP_OK;
 }
 
@@ -166,8 +173,14 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     }
     // TODO: we assume each color component is 8 bits, may need to support other configurations in the future, e.g. 10bits per color component?
     uint8_t bytes_per_pixel = component_fmt.format.num_components;
-    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + led_config->max_leds * bytes_per_pixel);
+#if FASTLED_RMT5_ASYNC_SHOW
+    const size_t num_buffers = 2;
+#else
+    const size_t num_buffers = 1;
+#endif
+    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + num_buffers * led_config->max_leds * bytes_per_pixel);
     ESP_GOTO_ON_FALSE(rmt_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for rmt strip");
+    rmt_strip->tx_buf = rmt_strip->pixel_buf + (num_buffers - 1) * led_config->max_leds * bytes_per_pixel;
     uint32_t resolution = rmt_config->resolution_hz ? rmt_config->resolution_hz : LED_STRIP_RMT_DEFAULT_RESOLUTION;
 
     // for backward compatibility, if the user does not set the clk_src, use the default value
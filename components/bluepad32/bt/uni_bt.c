@@ -81,6 +81,8 @@ bd_addr_t uni_local_bd_addr;
 #define CMD_CALLBACK_MAX 8
 static btstack_context_callback_registration_t cmd_callback_registration[CMD_CALLBACK_MAX];
 static int cmd_callback_idx = 0;
+// Arguments that don't fit in the context, same index as the registration
+static bd_addr_t cmd_callback_addr[CMD_CALLBACK_MAX];
 
 static bool bt_scanning_enabled;
 static bool bt_allow_incoming_connections = true;
@@ -97,6 +99,11 @@ enum {
     CMD_DISCONNECT_DEVICE,
     CMD_BLE_SERVICE_ENABLE,
     CMD_BLE_SERVICE_DISABLE,
+    CMD_LINKS_ACTIVE,
+    CMD_LINKS_IDLE,
+    CMD_PAGE_SCAN_FAST,
+    CMD_PAGE_SCAN_DEFAULT,
+    CMD_RECONNECT,
 };
 
 static void bluetooth_del_keys(void) {
@@ -218,6 +225,26 @@ static void cmd_callback(void* context) {
         case CMD_BLE_SERVICE_DISABLE:
             uni_bt_service_set_enabled(false);
             break;
+        case CMD_LINKS_ACTIVE:
+            if (IS_ENABLED(UNI_ENABLE_BREDR))
+                uni_bt_bredr_set_links_active(true);
+            break;
+        case CMD_LINKS_IDLE:
+            if (IS_ENABLED(UNI_ENABLE_BREDR))
+                uni_bt_bredr_set_links_active(false);
+            break;
+        case CMD_PAGE_SCAN_FAST:
+            if (IS_ENABLED(UNI_ENABLE_BREDR))
+                uni_bt_bredr_set_fast_page_scan(true);
+            break;
+        case CMD_PAGE_SCAN_DEFAULT:
+            if (IS_ENABLED(UNI_ENABLE_BREDR))
+                uni_bt_bredr_set_fast_page_scan(false);
+            break;
+        case CMD_RECONNECT:
+            if (IS_ENABLED(UNI_ENABLE_BREDR) && args < CMD_CALLBACK_MAX)
+                uni_bt_bredr_reconnect(cmd_callback_addr[args]);
+            break;
         default:
             loge("Unknown command: %#x\n", cmd);
             break;
@@ -328,6 +355,29 @@ void uni_bt_enable_service_safe(bool enabled) {
     btstack_run_loop_execute_on_main_thread(cmd);
 }
 
+void uni_bt_set_links_active_safe(bool active) {
+    btstack_context_callback_registration_t* cmd = get_next_callback_registration();
+    cmd->callback = &cmd_callback;
+    cmd->context = (void*)(active ? (intptr_t)CMD_LINKS_ACTIVE : (intptr_t)CMD_LINKS_IDLE);
+    btstack_run_loop_execute_on_main_thread(cmd);
+}
+
+void uni_bt_set_fast_page_scan_safe(bool fast) {
+    btstack_context_callback_registration_t* cmd = get_next_callback_registration();
+    cmd->callback = &cmd_callback;
+    cmd->context = (void*)(fast ? (intptr_t)CMD_PAGE_SCAN_FAST : (intptr_t)CMD_PAGE_SCAN_DEFAULT);
+    btstack_run_loop_execute_on_main_thread(cmd);
+}
+
+void uni_bt_reconnect_safe(const bd_addr_t addr) {
+    btstack_context_callback_registration_t* cmd = get_next_callback_registration();
+    unsigned long idx = (unsigned long)cmd_callback_idx;
+    bd_addr_copy(cmd_callback_addr[idx], addr);
+    cmd->callback = &cmd_callback;
+    cmd->context = (void*)(CMD_RECONNECT | (idx << 16));
+    btstack_run_loop_execute_on_main_thread(cmd);
+}
+
 void uni_bt_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packet, uint16_t size) {
     uint8_t event;
     uni_hid_device_t* device;
@@ -451,6 +501,18 @@ void uni_bt_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packe
                     break;
                 case HCI_EVENT_ROLE_CHANGE:
                     logi("--> HCI_EVENT_ROLE_CHANGE\n");
+                    if (IS_ENABLED(UNI_ENABLE_BREDR))
+                        uni_bt_bredr_on_hci_role_change(channel, packet, size);
+                    break;
+                case HCI_EVENT_MODE_CHANGE:
+                    logd("--> HCI_EVENT_MODE_CHANGE\n");
+                    if (IS_ENABLED(UNI_ENABLE_BREDR))
+                        uni_bt_bredr_on_hci_mode_change(channel, packet, size);
+                    break;
+                case HCI_EVENT_QOS_SETUP_COMPLETE:
+                    logd("--> HCI_EVENT_QOS_SETUP_COMPLETE\n");
+                    if (IS_ENABLED(UNI_ENABLE_BREDR))
+                        uni_bt_bredr_on_hci_qos_setup_complete(channel, packet, size);
                     break;
                 case HCI_EVENT_SYNCHRONOUS_CONNECTION_COMPLETE:
                     logi("--> HCI_EVENT_SYNCHRONOUS_CONNECTION_COMPLETE\n");
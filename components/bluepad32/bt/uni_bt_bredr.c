@@ -45,6 +45,158 @@ static inline bool is_ps3_clone(const uni_hid_device_t* d) {
 
 static bool bt_bredr_enabled = true;
 
+// Link policy
+// -----------
+// While the robot drives, every slot the controller gets to send an input report counts, and
+// Wi-Fi coexistence already takes a share of them. So once a controller is ready we:
+//   - ask to become master: only the master sets the poll interval
+//   - do not allow sniff mode, and leave it if the controller is already in it
+//   - ask for a short poll interval with QoS Setup (guaranteed service, latency in us)
+// When the robot is idle (uni_bt_bredr_set_links_active(false)) the links fall back to best-effort
+// QoS and sniff, which saves airtime for Wi-Fi and battery on the controller.
+// Per-link report timing is tracked in uni_bt_conn_on_report().
+
+// Writes "Link Supervision Timeout" when we become master of a link, in slots (0.625 ms).
+// BTstack's default is 20 s, too long for a robot that should stop when its controller is gone.
+#define LINK_SUPERVISION_TIMEOUT 0x0C80  // 2 s
+// Idle sniff parameters, in slots
+#define LINK_IDLE_SNIFF_MIN_INTERVAL 0x0030  // 30 ms
+#define LINK_IDLE_SNIFF_MAX_INTERVAL 0x0050  // 50 ms
+#define LINK_IDLE_SNIFF_ATTEMPT 4
+#define LINK_IDLE_SNIFF_TIMEOUT 1
+// Retry when the HCI command buffer is busy
+#define LINK_POLICY_RETRY_MS 10
+// HCI Mode Change: current mode
+#define LINK_MODE_SNIFF 2
+
+typedef struct {
+    bool request_master;
+    bool periodic_reports;   // Sends input reports at a fixed rate, even without input
+    bool idle_sniff;         // Allowed to enter sniff mode when idle
+    uint32_t poll_latency_us;  // QoS Setup while active, 0: leave the poll interval alone
+} link_profile_t;
+
+// DS4, DualSense, DS3: high, fixed report rate
+static const link_profile_t link_profile_sony = {true, true, true, 5000};
+// Switch controllers are put into "standard full" mode (0x30): one report every 15 ms
+static const link_profile_t link_profile_switch = {true, true, true, 7500};
+// Wii remotes report on change only. Not tested in sniff, so keep them out of it
+static const link_profile_t link_profile_wii = {true, false, false, 7500};
+// PS3 clones: no role switch and no sniff, they drop the link on anything unusual (see is_ps3_clone)
+static const link_profile_t link_profile_ps3_clone = {false, true, false, 0};
+static const link_profile_t link_profile_default = {true, false, true, 10000};
+
+static bool links_active = true;
+static btstack_timer_source_t link_policy_timer;
+
+// Page scan activity, in slots. Fast while a known controller is expected back: most controllers
+// reconnect by paging us, so this is what decides how quickly they get through.
+// The page scan is interlaced (see uni_bt_bredr_setup()), so it listens twice per window.
+#define PAGE_SCAN_FAST_INTERVAL 0x0200     // 320 ms
+#define PAGE_SCAN_FAST_WINDOW 0x0024       // 22.5 ms
+#define PAGE_SCAN_DEFAULT_INTERVAL 0x0800  // 1.28 s, controller default
+#define PAGE_SCAN_DEFAULT_WINDOW 0x0012    // 11.25 ms, controller default
+
+static const link_profile_t* get_link_profile(const uni_hid_device_t* d) {
+    if (is_ps3_clone(d))
+        return &link_profile_ps3_clone;
+
+    switch (d->controller_type) {
+        case CONTROLLER_TYPE_PS3Controller:
+        case CONTROLLER_TYPE_PS4Controller:
+        case CONTROLLER_TYPE_PS5Controller:
+            return &link_profile_sony;
+        case CONTROLLER_TYPE_SwitchProController:
+        case CONTROLLER_TYPE_SwitchJoyConLeft:
+        case CONTROLLER_TYPE_SwitchJoyConRight:
+        case CONTROLLER_TYPE_SwitchJoyConPair:
+            return &link_profile_switch;
+        case CONTROLLER_TYPE_WiiController:
+            return &link_profile_wii;
+        default:
+            return &link_profile_default;
+    }
+}
+
+static bool is_link_managed(const uni_hid_device_t* d) {
+    return d->conn.protocol == UNI_BT_CONN_PROTOCOL_BR_EDR && d->conn.handle != UNI_BT_CONN_HANDLE_INVALID &&
+           d->conn.link_state != UNI_BT_CONN_LINK_NONE;
+}
+
+static void link_policy_run(void);
+
+static void link_policy_timer_callback(btstack_timer_source_t* ts) {
+    ARG_UNUSED(ts);
+    link_policy_run();
+}
+
+static void link_policy_schedule(void) {
+    btstack_run_loop_remove_timer(&link_policy_timer);
+    btstack_run_loop_set_timer_handler(&link_policy_timer, link_policy_timer_callback);
+    btstack_run_loop_set_timer(&link_policy_timer, LINK_POLICY_RETRY_MS);
+    btstack_run_loop_add_timer(&link_policy_timer);
+}
+
+// Sends one pending "raw" HCI command per call. QoS, sniff and role requests go through BTstack's
+// own per-connection queue (gap_*), but there is no GAP call for per-link policy settings.
+static void link_policy_run(void) {
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        uni_hid_device_t* d = uni_hid_device_get_instance_for_idx(i);
+        if (!d || !d->conn.link_pending || !is_link_managed(d))
+            continue;
+
+        if (!hci_can_send_command_packet_now()) {
+            link_policy_schedule();
+            return;
+        }
+
+        const link_profile_t* profile = get_link_profile(d);
+        if (d->conn.link_pending & UNI_BT_CONN_LINK_PENDING_POLICY) {
+            d->conn.link_pending &= ~UNI_BT_CONN_LINK_PENDING_POLICY;
+            bool sniff = d->conn.link_state == UNI_BT_CONN_LINK_IDLE && profile->idle_sniff;
+            // Profiles that stay slave also don't get role switch: the write overrides the default
+            // link policy, which allows it
+            uint16_t settings = (profile->request_master ? LM_LINK_POLICY_ENABLE_ROLE_SWITCH : 0) |
+                                (sniff ? LM_LINK_POLICY_ENABLE_SNIFF_MODE : 0);
+            hci_send_cmd(&hci_write_link_policy_settings, d->conn.handle, settings);
+            // Queued by BTstack behind the policy write
+            if (sniff && d->conn.mode != LINK_MODE_SNIFF)
+                gap_sniff_mode_enter(d->conn.handle, LINK_IDLE_SNIFF_MIN_INTERVAL, LINK_IDLE_SNIFF_MAX_INTERVAL,
+                                     LINK_IDLE_SNIFF_ATTEMPT, LINK_IDLE_SNIFF_TIMEOUT);
+        } else if (d->conn.link_pending & UNI_BT_CONN_LINK_PENDING_SUPERVISION_TIMEOUT) {
+            d->conn.link_pending &= ~UNI_BT_CONN_LINK_PENDING_SUPERVISION_TIMEOUT;
+            // Only the master may write it
+            if (d->conn.role == HCI_ROLE_MASTER)
+                hci_send_cmd(&hci_write_link_supervision_timeout, d->conn.handle, LINK_SUPERVISION_TIMEOUT);
+        }
+        // Come back for the rest once this command is out
+        link_policy_schedule();
+        return;
+    }
+}
+
+static void link_policy_apply(uni_hid_device_t* d, uni_bt_conn_link_state_t state) {
+    const link_profile_t* profile = get_link_profile(d);
+    hci_con_handle_t handle = d->conn.handle;
+
+    d->conn.link_state = state;
+    d->conn.link_pending |= UNI_BT_CONN_LINK_PENDING_POLICY;
+
+    if (state == UNI_BT_CONN_LINK_ACTIVE) {
+        if (d->conn.mode == LINK_MODE_SNIFF)
+            gap_sniff_mode_exit(handle);
+        if (profile->poll_latency_us) {
+            // Token rate and peak bandwidth: 0, not specified. Delay variation: don't care.
+            gap_qos_set(handle, HCI_SERVICE_TYPE_GUARANTEED, 0, 0, profile->poll_latency_us, 0xffffffff);
+        }
+    } else if (profile->poll_latency_us) {
+        gap_qos_set(handle, HCI_SERVICE_TYPE_BEST_EFFORT, 0, 0, 0xffffffff, 0xffffffff);
+    }
+    logi("Link policy for %s: %s\n", bd_addr_to_str(d->conn.btaddr), uni_bt_conn_link_state_name(state));
+
+    link_policy_run();
+}
+
 static void l2cap_create_control_connection(uni_hid_device_t* d) {
     uint8_t status;
     status = l2cap_create_channel(uni_bt_packet_handler, d->conn.btaddr, BLUETOOTH_PSM_HID_CONTROL,
@@ -69,6 +221,13 @@ static void l2cap_create_interrupt_connection(uni_hid_device_t* d) {
 
 static void inquiry_remote_name_timeout_callback(btstack_timer_source_t* ts) {
     uni_hid_device_t* d = btstack_run_loop_get_timer_context(ts);
+    if (d->conn.direct_reconnect && uni_bt_conn_get_state(&d->conn) == UNI_BT_CONN_STATE_REMOTE_NAME_INQUIRED) {
+        // Not there. Don't page it a second time for the L2CAP connection.
+        logi("Direct reconnect to %s: no answer\n", bd_addr_to_str(d->conn.btaddr));
+        uni_hid_device_delete(d);
+        /* 'd' is destroyed after this call, don't use it */
+        return;
+    }
     loge("Failed to inquiry name for %s, using a fake one\n", bd_addr_to_str(d->conn.btaddr));
     // The device has no name. Just fake one
     uni_hid_device_set_name(d, "Controller without name");
@@ -192,6 +351,9 @@ void uni_bt_bredr_setup(void) {
     // try to become master on incoming connections
     hci_set_master_slave_policy(HCI_ROLE_MASTER);
 
+    // Written by BTstack on links where we are master from the start, see link_policy_run() for the others
+    gap_set_link_supervision_timeout(LINK_SUPERVISION_TIMEOUT);
+
     logi("Gap security level: %d\n", security_level);
     logi("Periodic Inquiry: max=%d, min=%d, len=%d\n", uni_bt_get_gap_max_periodic_length(),
          uni_bt_get_gap_min_periodic_length(), uni_bt_get_gap_inquiry_length());
@@ -205,6 +367,69 @@ bool uni_bt_bredr_is_enabled(void) {
     return bt_bredr_enabled;
 }
 
+void uni_bt_bredr_on_device_ready(uni_hid_device_t* d) {
+    const link_profile_t* profile = get_link_profile(d);
+
+    d->conn.role = gap_get_role(d->conn.handle);
+    uni_bt_conn_reset_reports(&d->conn, profile->periodic_reports);
+    if (profile->request_master && d->conn.role == HCI_ROLE_SLAVE) {
+        logi("Requesting master role for %s\n", bd_addr_to_str(d->conn.btaddr));
+        gap_request_role(d->conn.btaddr, HCI_ROLE_MASTER);
+    }
+    link_policy_apply(d, links_active ? UNI_BT_CONN_LINK_ACTIVE : UNI_BT_CONN_LINK_IDLE);
+}
+
+void uni_bt_bredr_set_links_active(bool active) {
+    if (links_active == active)
+        return;
+    links_active = active;
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        uni_hid_device_t* d = uni_hid_device_get_instance_for_idx(i);
+        if (d && is_link_managed(d))
+            link_policy_apply(d, active ? UNI_BT_CONN_LINK_ACTIVE : UNI_BT_CONN_LINK_IDLE);
+    }
+}
+
+bool uni_bt_bredr_links_active(void) {
+    return links_active;
+}
+
+void uni_bt_bredr_set_fast_page_scan(bool fast) {
+    if (fast)
+        gap_set_page_scan_activity(PAGE_SCAN_FAST_INTERVAL, PAGE_SCAN_FAST_WINDOW);
+    else
+        gap_set_page_scan_activity(PAGE_SCAN_DEFAULT_INTERVAL, PAGE_SCAN_DEFAULT_WINDOW);
+    logi("BR/EDR page scan -> %s\n", fast ? "fast" : "default");
+}
+
+bool uni_bt_bredr_reconnect(bd_addr_t addr) {
+    link_key_t link_key;
+    link_key_type_t link_key_type;
+    uni_hid_device_t* d;
+
+    d = uni_hid_device_get_instance_for_address(addr);
+    if (d) {
+        logi("Direct reconnect to %s: already connecting (state=0x%02x)\n", bd_addr_to_str(addr), d->conn.state);
+        return false;
+    }
+    // Without a link key this would be a new pairing: that is what the inquiry is for
+    if (!gap_get_link_key_for_bd_addr(addr, link_key, &link_key_type)) {
+        logi("Direct reconnect to %s: not bonded\n", bd_addr_to_str(addr));
+        return false;
+    }
+    d = uni_hid_device_create(addr);
+    if (d == NULL) {
+        loge("Direct reconnect to %s: no more available slots\n", bd_addr_to_str(addr));
+        return false;
+    }
+    logi("Direct reconnect to %s\n", bd_addr_to_str(addr));
+    d->conn.direct_reconnect = true;
+    uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_DEVICE_DISCOVERED);
+    // Same path as an inquiry result: the remote name request is the first page
+    uni_bt_bredr_process_fsm(d);
+    return true;
+}
+
 void uni_bt_bredr_process_fsm(uni_hid_device_t* d) {
     // TODO: Move to uni_bt_bredr.c
 
@@ -454,8 +679,11 @@ void uni_bt_bredr_on_l2cap_channel_opened(uint16_t channel, const uint8_t* packe
         if (status == L2CAP_CONNECTION_RESPONSE_RESULT_REFUSED_SECURITY) {
             logi("Probably GAP-security-related issues. Set GAP security to 2\n");
         }
-        logi("Removing key for device: %s.\n", bd_addr_to_str(address));
-        gap_drop_link_key_for_bd_addr(device->conn.btaddr);
+        // A direct reconnect that failed only means the controller was not there: keep the bonding
+        if (!device->conn.direct_reconnect) {
+            logi("Removing key for device: %s.\n", bd_addr_to_str(address));
+            gap_drop_link_key_for_bd_addr(device->conn.btaddr);
+        }
         uni_hid_device_disconnect(device);
         uni_hid_device_delete(device);
         /* 'device' is destroyed, don't use */
@@ -556,6 +784,7 @@ void uni_bt_bredr_on_l2cap_data_packet(uint16_t channel, const uint8_t* packet,
         // Accept them as regular input reports by skipping the non-standard first byte.
         if (packet[0] == 0x00) {
             logd("on_l2cap_data_packet: DS3 quirk – accepting 0x00 packet as input report\n");
+            uni_bt_conn_on_report(&d->conn, btstack_run_loop_get_time_ms());
             uni_hid_parse_input_report(d, &packet[1], size - 1);
             uni_hid_device_process_controller(d);
         } else {
@@ -566,6 +795,7 @@ void uni_bt_bredr_on_l2cap_data_packet(uint16_t channel, const uint8_t* packet,
     }
 
     // Skip the first byte, which is always 0xa1
+    uni_bt_conn_on_report(&d->conn, btstack_run_loop_get_time_ms());
     uni_hid_parse_input_report(d, &packet[1], size - 1);
     uni_hid_device_process_controller(d);
 }
@@ -655,6 +885,8 @@ void uni_bt_bredr_on_hci_connection_request(uint16_t channel, const uint8_t* pac
     }
     uni_hid_device_set_cod(d, cod);
     uni_hid_device_set_incoming(d, true);
+    // The controller was faster than our page
+    d->conn.direct_reconnect = false;
     logi("on_hci_connection_request from: address = %s, cod=0x%04x\n", bd_addr_to_str(event_addr), cod);
 }
 
@@ -713,6 +945,78 @@ void uni_bt_bredr_on_hci_disconnection_complete(uint16_t channel, const uint8_t*
     // Do something ???
 }
 
+void uni_bt_bredr_on_hci_role_change(uint16_t channel, const uint8_t* packet, uint16_t size) {
+    bd_addr_t event_addr;
+    uni_hid_device_t* d;
+    uint8_t status;
+    uint8_t role;
+
+    ARG_UNUSED(channel);
+    ARG_UNUSED(size);
+
+    hci_event_role_change_get_bd_addr(packet, event_addr);
+    status = hci_event_role_change_get_status(packet);
+    role = hci_event_role_change_get_role(packet);
+    d = uni_hid_device_get_instance_for_address(event_addr);
+    if (d == NULL)
+        return;
+    if (status) {
+        // Not fatal: the controller keeps the role it has, only the poll interval is up to it
+        logi("Role change for %s failed: 0x%02x\n", bd_addr_to_str(event_addr), status);
+        return;
+    }
+    logi("Role change for %s: %s\n", bd_addr_to_str(event_addr), role == HCI_ROLE_MASTER ? "master" : "slave");
+    d->conn.role = role;
+    if (role == HCI_ROLE_MASTER) {
+        d->conn.link_pending |= UNI_BT_CONN_LINK_PENDING_SUPERVISION_TIMEOUT;
+        link_policy_run();
+    }
+}
+
+void uni_bt_bredr_on_hci_mode_change(uint16_t channel, const uint8_t* packet, uint16_t size) {
+    uni_hid_device_t* d;
+
+    ARG_UNUSED(channel);
+    ARG_UNUSED(size);
+
+    if (hci_event_mode_change_get_status(packet))
+        return;
+    d = uni_hid_device_get_instance_for_connection_handle(hci_event_mode_change_get_handle(packet));
+    if (d == NULL)
+        return;
+    d->conn.mode = hci_event_mode_change_get_mode(packet);
+    d->conn.sniff_interval = d->conn.mode == LINK_MODE_SNIFF ? hci_event_mode_change_get_interval(packet) : 0;
+    logi("Mode change for %s: mode=%d, interval=%d\n", bd_addr_to_str(d->conn.btaddr), d->conn.mode,
+         d->conn.sniff_interval);
+
+    // Entered sniff before the policy got written, or asked for it anyway
+    if (d->conn.mode == LINK_MODE_SNIFF && d->conn.link_state == UNI_BT_CONN_LINK_ACTIVE)
+        gap_sniff_mode_exit(d->conn.handle);
+}
+
+void uni_bt_bredr_on_hci_qos_setup_complete(uint16_t channel, const uint8_t* packet, uint16_t size) {
+    uni_hid_device_t* d;
+    uint8_t status;
+
+    ARG_UNUSED(channel);
+
+    // There are no getters for this event in btstack_event.h:
+    // status(1), handle(2), flags(1), service type(1), token rate(4), peak bandwidth(4), latency(4), ...
+    if (size < 19)
+        return;
+    status = packet[2];
+    d = uni_hid_device_get_instance_for_connection_handle(little_endian_read_16(packet, 3) & 0x0fff);
+    if (d == NULL)
+        return;
+    if (status) {
+        logi("QoS setup for %s failed: 0x%02x\n", bd_addr_to_str(d->conn.btaddr), status);
+        return;
+    }
+    d->conn.poll_latency_us = little_endian_read_32(packet, 15);
+    logi("QoS setup for %s: service type=%d, latency=%" PRIu32 " us\n", bd_addr_to_str(d->conn.btaddr),
+         packet[6], d->conn.poll_latency_us);
+}
+
 void uni_bt_bredr_on_hci_pin_code_request(uint16_t channel, const uint8_t* packet, uint16_t size) {
     // gap_pin_code_response_binary() does not copy the data, and data
     // must be valid until the next hci_send_cmd is called.
@@ -774,6 +1078,15 @@ void uni_bt_bredr_on_hci_remote_name_request_complete(uint16_t channel, const ui
     if (d != NULL) {
         const char* name = NULL;
         status = hci_event_remote_name_request_complete_get_status(packet);
+        // Unless the controller paged us in the meantime, the connection is still ours to give up
+        if (status && d->conn.direct_reconnect &&
+            uni_bt_conn_get_state(&d->conn) == UNI_BT_CONN_STATE_REMOTE_NAME_INQUIRED) {
+            logi("Direct reconnect to %s failed: 0x%02x\n", bd_addr_to_str(event_addr), status);
+            btstack_run_loop_remove_timer(&d->inquiry_remote_name_timer);
+            uni_hid_device_delete(d);
+            /* 'd' is destroyed after this call, don't use it */
+            return;
+        }
         if (status) {
             // Failed to get the name, just fake one
             logi("Failed to fetch name for %s, error = 0x%02x\n", bd_addr_to_str(event_addr), status);
@@ -8,9 +8,17 @@
 
 #include "uni_log.h"
 
+// Reports needed before the average interval is trusted
+#define REPORTS_WARMUP 16
+// A gap longer than this many average intervals counts as lost reports...
+#define REPORTS_GAP_FACTOR 3
+// ...but never one shorter than this: Wi-Fi coexistence alone causes that much jitter
+#define REPORTS_GAP_MIN_MS 20
+
 void uni_bt_conn_init(uni_bt_conn_t* conn) {
     memset(conn, 0, sizeof(*conn));
     conn->handle = UNI_BT_CONN_HANDLE_INVALID;
+    conn->role = HCI_ROLE_INVALID;
 }
 
 void uni_bt_conn_set_state(uni_bt_conn_t* conn, uni_bt_conn_state_t state) {
@@ -48,3 +56,54 @@ bool uni_bt_conn_is_connected(const uni_bt_conn_t* conn) {
 void uni_bt_conn_disconnect(uni_bt_conn_t* conn) {
     uni_bt_conn_set_connected(conn, false);
 }
+
+void uni_bt_conn_reset_reports(uni_bt_conn_t* conn, bool periodic) {
+    memset(&conn->reports, 0, sizeof(conn->reports));
+    conn->reports.periodic = periodic;
+}
+
+void uni_bt_conn_on_report(uni_bt_conn_t* conn, uint32_t now_ms) {
+    uni_bt_conn_reports_t* r = &conn->reports;
+
+    if (r->count++ == 0) {
+        r->last_ms = now_ms;
+        return;
+    }
+    uint32_t gap_ms = now_ms - r->last_ms;
+    uint32_t gap_us = gap_ms * 1000;
+    r->last_ms = now_ms;
+
+    // Event-driven controllers are silent while nobody touches them: their gaps say nothing
+    if (r->periodic && gap_ms > r->max_gap_ms)
+        r->max_gap_ms = gap_ms;
+
+    if (r->avg_interval_us == 0) {
+        r->avg_interval_us = gap_us;
+        return;
+    }
+
+    uint32_t avg_us = r->avg_interval_us < 1000 ? 1000 : r->avg_interval_us;
+    uint32_t limit_ms = avg_us * REPORTS_GAP_FACTOR / 1000;
+    if (limit_ms < REPORTS_GAP_MIN_MS)
+        limit_ms = REPORTS_GAP_MIN_MS;
+    if (r->count > REPORTS_WARMUP && gap_ms > limit_ms) {
+        // Keep the gap out of the average, otherwise a few dropouts hide the next ones
+        if (r->periodic)
+            r->missed += gap_us / avg_us - 1;
+        return;
+    }
+
+    // Moving average, 1/16 weight for the new interval
+    r->avg_interval_us = r->avg_interval_us - r->avg_interval_us / 16 + gap_us / 16;
+}
+
+const char* uni_bt_conn_link_state_name(uni_bt_conn_link_state_t state) {
+    switch (state) {
+        case UNI_BT_CONN_LINK_ACTIVE:
+            return "active";
+        case UNI_BT_CONN_LINK_IDLE:
+            return "idle";
+        default:
+            return "none";
+    }
+}
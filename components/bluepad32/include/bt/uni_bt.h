@@ -58,6 +58,14 @@ void uni_bt_enable_service_safe(bool enabled);
 // Disconnects a device
 void uni_bt_disconnect_device_safe(int device_idx);
 
+// BR/EDR link policy for connected controllers.
+// Active: short poll interval, no sniff. Idle: best-effort QoS and sniff to save airtime and battery.
+void uni_bt_set_links_active_safe(bool active);
+// Reconnecting known controllers: faster page scan while one is expected back, and paging a
+// bonded controller directly instead of waiting for it in an inquiry.
+void uni_bt_set_fast_page_scan_safe(bool fast);
+void uni_bt_reconnect_safe(const bd_addr_t addr);
+
 // Get local BD address
 void uni_bt_get_local_bd_addr_safe(bd_addr_t addr);
 
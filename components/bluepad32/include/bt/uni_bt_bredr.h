@@ -31,6 +31,20 @@ void uni_bt_bredr_setup(void);
 void uni_bt_bredr_set_enabled(bool enabled);
 bool uni_bt_bredr_is_enabled(void);
 
+// Link policy: short poll interval and no sniff while active, power saving while idle.
+// Must be called from BTthread, see uni_bt_set_links_active_safe().
+void uni_bt_bredr_set_links_active(bool active);
+bool uni_bt_bredr_links_active(void);
+// Called from uni_hid_device_set_ready_complete()
+void uni_bt_bredr_on_device_ready(uni_hid_device_t* d);
+
+// Reconnect to known controllers. Must be called from BTthread, see uni_bt_reconnect_safe().
+// Fast page scan while a lost controller is expected back.
+void uni_bt_bredr_set_fast_page_scan(bool fast);
+// Pages a bonded controller instead of waiting for it to show up in an inquiry.
+// Returns false if it is not bonded, already connecting, or there is no free slot.
+bool uni_bt_bredr_reconnect(bd_addr_t addr);
+
 void uni_bt_bredr_l2cap_create_control_connection(uni_hid_device_t* d);
 void uni_bt_bredr_process_fsm(uni_hid_device_t* d);
 
@@ -42,6 +56,9 @@ void uni_bt_bredr_on_gap_inquiry_result(uint16_t channel, const uint8_t* packet,
 void uni_bt_bredr_on_hci_connection_request(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_hci_connection_complete(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_hci_disconnection_complete(uint16_t channel, const uint8_t* packet, uint16_t size);
+void uni_bt_bredr_on_hci_role_change(uint16_t channel, const uint8_t* packet, uint16_t size);
+void uni_bt_bredr_on_hci_mode_change(uint16_t channel, const uint8_t* packet, uint16_t size);
+void uni_bt_bredr_on_hci_qos_setup_complete(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_hci_pin_code_request(uint16_t channel, const uint8_t* packet, uint16_t size);
 void uni_bt_bredr_on_hci_remote_name_request_complete(uint16_t channel, const uint8_t* packet, uint16_t size);
 
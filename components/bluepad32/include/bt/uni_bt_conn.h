@@ -5,6 +5,10 @@
 #ifndef UNI_BT_CONN_H
 #define UNI_BT_CONN_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -41,6 +45,26 @@ typedef enum {
     UNI_BT_CONN_STATE_DEVICE_READY,
 } uni_bt_conn_state_t;
 
+// Link policy of a ready BR/EDR link, see uni_bt_bredr.c
+typedef enum {
+    UNI_BT_CONN_LINK_NONE,    // Not applied yet: link still being set up
+    UNI_BT_CONN_LINK_ACTIVE,  // Driving: master, no sniff, short poll interval
+    UNI_BT_CONN_LINK_IDLE,    // Robot idle: sniff allowed, best-effort QoS
+} uni_bt_conn_link_state_t;
+
+// HCI commands that still need to be sent for the link policy
+#define UNI_BT_CONN_LINK_PENDING_POLICY (1 << 0)
+#define UNI_BT_CONN_LINK_PENDING_SUPERVISION_TIMEOUT (1 << 1)
+
+typedef struct {
+    uint32_t count;
+    uint32_t missed;          // Estimated from gaps in periodic reports
+    uint32_t last_ms;         // Arrival time of the last report
+    uint32_t avg_interval_us;  // Moving average, gaps counted as missed are left out
+    uint32_t max_gap_ms;
+    bool periodic;  // Controller sends reports at a fixed rate, so gaps mean lost reports
+} uni_bt_conn_reports_t;
+
 typedef struct {
     bd_addr_t btaddr;
     hci_con_handle_t handle;
@@ -57,9 +81,19 @@ typedef struct {
 
     bool incoming;
     bool connected;
+    bool direct_reconnect;  // We paged a known controller, see uni_bt_bredr_reconnect()
 
     uni_bt_conn_state_t state;
     uni_bt_conn_protocol_t protocol;
+
+    // BR/EDR link policy
+    uint8_t role;              // HCI_ROLE_MASTER, HCI_ROLE_SLAVE or HCI_ROLE_INVALID
+    uint8_t mode;              // From HCI Mode Change: 0 active, 2 sniff
+    uint16_t sniff_interval;   // In slots, valid in sniff mode
+    uint32_t poll_latency_us;  // Granted by QoS Setup, 0 if never set
+    uni_bt_conn_link_state_t link_state;
+    uint8_t link_pending;  // UNI_BT_CONN_LINK_PENDING_*
+    uni_bt_conn_reports_t reports;
 } uni_bt_conn_t;
 
 void uni_bt_conn_init(uni_bt_conn_t* conn);
@@ -72,4 +106,13 @@ void uni_bt_conn_set_connected(uni_bt_conn_t* conn, bool connected);
 bool uni_bt_conn_is_connected(const uni_bt_conn_t* conn);
 void uni_bt_conn_disconnect(uni_bt_conn_t* conn);
 
+// Input report timing, called for every input report
+void uni_bt_conn_on_report(uni_bt_conn_t* conn, uint32_t now_ms);
+void uni_bt_conn_reset_reports(uni_bt_conn_t* conn, bool periodic);
+const char* uni_bt_conn_link_state_name(uni_bt_conn_link_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif  // UNI_BT_CONN_H
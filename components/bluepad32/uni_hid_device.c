@@ -256,6 +256,9 @@ bool uni_hid_device_set_ready_complete(uni_hid_device_t* d) {
     uni_bt_service_on_device_ready(d);
 
     uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_DEVICE_READY);
+
+    if (IS_ENABLED(UNI_ENABLE_BREDR) && d->conn.protocol == UNI_BT_CONN_PROTOCOL_BR_EDR)
+        uni_bt_bredr_on_device_ready(d);
     return true;
 }
 
@@ -22,6 +22,8 @@ function connectWebSocket() {
     console.log("WebSocket verbunden");
     reconnectAttempts = 0; // Zurücksetzen der Versuche nach erfolgreicher Verbindung
     updateConnectionStatus("verbunden");
+    // Die Seite braucht nur die Neustart-Meldung, keine Statuswerte
+    socket.send(JSON.stringify({ subscribe: {} }));
   };
 
   socket.onmessage = function(event) {
@@ -286,6 +288,10 @@ async function loadConfig() {
     toggleWifiFields();
     document.getElementById('wifi_ssid').value = data.wifi_ssid;
     document.getElementById('wifi_password').value = data.wifi_password;
+    document.getElementById('wifi_static_ip').value = data.wifi_static_ip || '';
+    document.getElementById('wifi_gateway').value = data.wifi_gateway || '';
+    document.getElementById('wifi_netmask').value = data.wifi_netmask || '255.255.255.0';
+    document.getElementById('wifi_dns').value = data.wifi_dns || '';
     document.getElementById('hotspot_ssid').value = data.hotspot_ssid;
     document.getElementById('hotspot_password').value = data.hotspot_password;
     updateWifiDisableUI(!!data.wifi_disabled_until_restart);
@@ -365,6 +371,33 @@ async function loadConfig() {
     const syncLed = (fromSlider)=>{ if (fromSlider) ledNum.value = ledSl.value; else ledSl.value = ledNum.value; ledLbl.textContent = ledNum.value; };
     ledNum.addEventListener('input', ()=>syncLed(false));
     ledSl.addEventListener('input', ()=>syncLed(true));
+    const ledOutDiv = document.getElementById('led-outputs');
+    if (ledOutDiv && Array.isArray(data.led_outputs)) {
+      ledOutDiv.innerHTML = '';
+      const orders = ['GRB', 'RGB', 'BRG', 'BGR', 'RBG', 'GBR'];
+      data.led_outputs.forEach((o, i) => {
+        const row = document.createElement('div');
+        row.classList.add('row');
+        row.style.cssText = 'display:flex; gap:8px; align-items:center; flex-wrap:wrap;';
+        const countField = i === 0
+          ? ''
+          : `<label for="led_count_${i}">Anzahl:</label>
+             <input type="number" id="led_count_${i}" name="led_count_${i}" min="0" max="300" style="width:80px;" value="${o.count}">`;
+        row.innerHTML = `
+          <span style="min-width:80px;">Ausgang ${i}</span>
+          <label for="led_pin_${i}">GPIO:</label>
+          <input type="number" id="led_pin_${i}" name="led_pin_${i}" min="-1" max="48" style="width:70px;" value="${o.pin}">
+          ${countField}
+          <label for="led_order_${i}">Farbfolge:</label>
+          <select id="led_order_${i}" name="led_order_${i}">
+            ${orders.map(x => `<option value="${x}" ${x === o.order ? 'selected' : ''}>${x}</option>`).join('')}
+          </select>`;
+        ledOutDiv.appendChild(row);
+      });
+    }
+    if (data.led_power_limit_mw !== undefined) {
+      document.getElementById('led_power_limit_mw').value = data.led_power_limit_mw;
+    }
 
     // OTA
     document.getElementById('ota_enabled').checked = data.ota_enabled;
@@ -391,6 +424,8 @@ async function loadConfig() {
       document.getElementById('bt_scan_on_ap_ms').value = data.bt_scan_on_ap_ms;
       document.getElementById('bt_scan_off_ap_ms').value = data.bt_scan_off_ap_ms;
     }
+    document.getElementById('bt_scan_policy').value = data.bt_scan_policy || 'fixed';
+    document.getElementById('bt_reconnect_ms').value = data.bt_reconnect_ms !== undefined ? data.bt_reconnect_ms : 15000;
 
     // Servos
     const servosDiv = document.getElementById('servos');
@@ -507,6 +542,32 @@ function reboot() {
   });
 }
 
+// Komplette Konfiguration als config.json herunterladen bzw. wieder einspielen
+function exportConfig() {
+  window.location.href = "/config.json";
+}
+
+async function importConfig(input) {
+  const file = input.files[0];
+  input.value = '';
+  if (!file) return;
+  if (!confirm(`Konfiguration aus "${file.name}" übernehmen? Alle Einstellungen werden ersetzt.`)) return;
+  try {
+    const text = await file.text();
+    JSON.parse(text); // ungültige Dateien gar nicht erst senden
+    const res = await fetch('/config.json', {
+      method: 'POST',
+      headers: { 'Content-Type': 'application/json' },
+      body: text
+    });
+    if (!res.ok) throw new Error('HTTP ' + res.status);
+    alert('Konfiguration importiert. WLAN-Einstellungen werden nach einem Neustart wirksam.');
+    window.location.reload();
+  } catch (e) {
+    alert('Import fehlgeschlagen: ' + e.message);
+  }
+}
+
 // Funktion zum Schließen des Popups
 function closePopup() {
   document.getElementById('restartPopup').style.display = 'none';
@@ -662,15 +662,18 @@
   function connectLiveWS() {
     const ws = new WebSocket(`ws://${window.location.hostname}/ws`);
     liveWS = ws;
+    // Nur Controller-Eingaben; unverändert kommen sie nur mit dem Keyframe (alle 2 s)
+    ws.onopen = () => ws.send(JSON.stringify({ subscribe: { controllers: 10 } }));
     ws.onmessage = (event) => {
       let msg;
       try { msg = JSON.parse(event.data); } catch (_) { return; }
       const ctrls = msg.controllers;
+      if (ctrls === undefined) return;
       if (!Array.isArray(ctrls) || ctrls.length === 0) { setLiveStatus(false); return; }
       setLiveStatus(true);
       applyLive(ctrls[0]);
       if (liveTimeout) clearTimeout(liveTimeout);
-      liveTimeout = setTimeout(() => setLiveStatus(false), 1500);
+      liveTimeout = setTimeout(() => setLiveStatus(false), 3000);
     };
     ws.onclose = () => { setLiveStatus(false); setTimeout(connectLiveWS, 1000); };
     ws.onerror = () => { try { ws.close(); } catch (_) {} };
@@ -748,17 +751,23 @@
   }
 
   // ── Live-Werkzeuge: Motoren (roh) ─────────────────────────
+  // Auch motor_raw unterliegt dem Befehls-Timeout (500 ms): gehaltene Werte alle 200 ms wiederholen
   const motorTest = document.getElementById('motorTest');
+  const rawPwm = [0, 0, 0, 0];
+  setInterval(() => {
+    rawPwm.forEach((pwm, i) => { if (pwm) liveSend({motor_raw:{motor:i, pwm}}); });
+  }, 200);
   for (let i = 0; i < 4; i++) {
     const lbl = document.createElement('label'); lbl.textContent = `Motor ${i}:`;
     const sl = document.createElement('input');
     sl.type = 'range'; sl.min = '-255'; sl.max = '255'; sl.value = '0';
     const val = document.createElement('span'); val.textContent = '0';
-    sl.addEventListener('input', () => { val.textContent = sl.value; liveSend({motor_raw:{motor:i, pwm:parseInt(sl.value,10)}}); });
-    sl.addEventListener('change', () => { sl.value = '0'; val.textContent = '0'; liveSend({motor_raw:{motor:i, pwm:0}}); }); // Loslassen → stop
+    sl.addEventListener('input', () => { val.textContent = sl.value; rawPwm[i] = parseInt(sl.value,10); liveSend({motor_raw:{motor:i, pwm:rawPwm[i]}}); });
+    sl.addEventListener('change', () => { sl.value = '0'; val.textContent = '0'; rawPwm[i] = 0; liveSend({motor_raw:{motor:i, pwm:0}}); }); // Loslassen → stop
     motorTest.append(lbl, sl, val, document.createTextNode(' '));
   }
   document.getElementById('motorStopAll').addEventListener('click', () => {
+    rawPwm.fill(0);
     for (let i = 0; i < 4; i++) liveSend({motor_raw:{motor:i, pwm:0}});
     motorTest.querySelectorAll('input[type="range"]').forEach(sl => sl.value = '0');
   });
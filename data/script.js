@@ -2,6 +2,9 @@
 const batteryVoltageElem = document.getElementById('batteryVoltage');
 const batteryPercentageElem = document.getElementById('batteryPercentage');
 const servoAnglesElem = document.getElementById('servoAngles');
+const linkRttElem = document.getElementById('linkRtt');
+const linkOwdElem = document.getElementById('linkOwd');
+const linkRateDivElem = document.getElementById('linkRateDiv');
 
 const motor0PWMElem = document.getElementById('motor0PWM');
 const motor1PWMElem = document.getElementById('motor1PWM');
@@ -75,7 +78,18 @@ let touchX = centerX;
 let touchY = centerY;
 let isMouseDown = false;
 
-let lastSentData = { x: 0, y: 0, servo: 90 };
+let lastSentData = {};
+
+// Joystick-Streaming: pro Animationsframe senden, wenn sich etwas geändert hat (höchstens
+// JOYSTICK_MAX_HZ). Gehaltene Eingaben werden alle KEEPALIVE_MS wiederholt, sonst greift der
+// Befehls-Timeout der Firmware (500 ms). Im Hintergrund-Tab ruht requestAnimationFrame –
+// dann stoppt die Firmware die Motoren von selbst.
+const JOYSTICK_MAX_HZ = 50;
+const KEEPALIVE_MS = 200;
+let nextSendMs = 0;
+let lastSendMs = 0;
+const heldMotors = [null, null];   // 'forward' | 'backward' | null je Motortaste
+let lastMotorSendMs = 0;
 
 // WebSocket Verbindung aufbauen
 let socket;
@@ -83,6 +97,69 @@ let reconnectInterval = 1000; // Initialer Rekonnektion-Intervall in ms
 const maxReconnectInterval = 30000; // Maximales Rekonnektion-Intervall in ms
 let reconnectAttempts = 0;
 
+// Binäres Steuerprotokoll (Format siehe main/WSControl.h); aktiv, wenn der Server
+// den Subprotocol bestätigt – sonst wird wie bisher JSON gesendet.
+const WS_BINARY_PROTOCOL = 'tt-ctl.1';
+const CTL = { DRIVE: 0x01, MOTOR: 0x02, MOTOR_STOP: 0x03, MOTOR_RAW: 0x04, SERVO: 0x05, LED_RANGE: 0x06, LED_BRIGHTNESS: 0x07 };
+const CTL_PAYLOAD = { 0x01: 4, 0x02: 3, 0x03: 1, 0x04: 3, 0x05: 2, 0x06: 8, 0x07: 1 };
+let ctlSeq = 0;
+
+function useBinaryControl() {
+  return socket && socket.protocol === WS_BINARY_PROTOCOL;
+}
+
+function clampInt(v, lo, hi) {
+  return Math.max(lo, Math.min(hi, Math.round(v)));
+}
+
+// records: [{ tag: CTL.DRIVE, x, y }, { tag: CTL.SERVO, servo, angle }, ...]
+function sendControlFrame(records) {
+  let size = 8;
+  records.forEach(r => { size += 1 + CTL_PAYLOAD[r.tag]; });
+  const buf = new ArrayBuffer(size);
+  const v = new DataView(buf);
+  v.setUint8(0, 0x43); // 'C'
+  v.setUint8(1, 1);    // Version
+  v.setUint16(2, ctlSeq, true);
+  ctlSeq = (ctlSeq + 1) & 0xFFFF;
+  v.setUint32(4, Math.floor(performance.now()) >>> 0, true);
+  let o = 8;
+  for (const r of records) {
+    v.setUint8(o++, r.tag);
+    switch (r.tag) {
+      case CTL.DRIVE:
+        v.setInt16(o, clampInt(r.x, -512, 512), true);
+        v.setInt16(o + 2, clampInt(r.y, -512, 512), true);
+        break;
+      case CTL.MOTOR:
+      case CTL.MOTOR_RAW:
+        v.setUint8(o, r.motor);
+        v.setInt16(o + 1, clampInt(r.pwm, -255, 255), true);
+        break;
+      case CTL.MOTOR_STOP:
+        v.setUint8(o, r.motor);
+        break;
+      case CTL.SERVO:
+        v.setUint8(o, r.servo);
+        v.setUint8(o + 1, clampInt(r.angle, 0, 180));
+        break;
+      case CTL.LED_RANGE:
+        v.setUint8(o, r.output === undefined ? 0xFF : r.output);
+        v.setUint16(o + 1, r.start, true);
+        v.setUint16(o + 3, r.count, true);
+        v.setUint8(o + 5, r.r);
+        v.setUint8(o + 6, r.g);
+        v.setUint8(o + 7, r.b);
+        break;
+      case CTL.LED_BRIGHTNESS:
+        v.setUint8(o, clampInt(r.value, 0, 255));
+        break;
+    }
+    o += CTL_PAYLOAD[r.tag];
+  }
+  socket.send(buf);
+}
+
 // Funktion zum Senden von Nachrichten über WebSocket
 function sendWebSocketMessage(message) {
   //if (socket && socket.readyState === WebSocket.OPEN) {
@@ -95,16 +172,30 @@ function sendWebSocketMessage(message) {
 // Funktion zum Herstellen der WebSocket-Verbindung
 function connectWebSocket() {
   const wsUrl = `ws://${window.location.hostname}/ws`;
-  socket = new WebSocket(wsUrl);
+  socket = new WebSocket(wsUrl, [WS_BINARY_PROTOCOL]);
 
   socket.onopen = function() {
-    console.log("WebSocket verbunden");
+    console.log("WebSocket verbunden" + (useBinaryControl() ? " (binär)" : " (JSON)"));
     reconnectAttempts = 0; // Zurücksetzen der Versuche nach erfolgreicher Verbindung
     updateConnectionStatus("verbunden");
+    lastSentData = {};   // aktuellen Stand nach (Re-)Connect einmal vollständig senden
+    // Nur die angezeigten Werte abonnieren; zwischen den Keyframes kommen nur Änderungen
+    socket.send(JSON.stringify({ subscribe: { power: 1, motors: 5, servos: 5, leds: 2 } }));
   };
 
   socket.onmessage = (event) => {
+    const receivedMs = performance.now();
     const data = JSON.parse(event.data);
+    if (data.ping !== undefined) {
+        // Laufzeitmessung der Firmware: sofort mit eigener Empfangs- und Sendezeit antworten
+        socket.send(JSON.stringify({ pong: [data.ping, receivedMs, performance.now()] }));
+        if (data.link) {
+            linkRttElem.textContent = data.link.rttMs.toFixed(1);
+            linkOwdElem.textContent = data.link.owdMs.toFixed(1);
+            linkRateDivElem.textContent = data.link.rateDiv;
+        }
+        return;
+    }
     if (data.batteryVoltage !== undefined) {
         batteryVoltageElem.textContent = data.batteryVoltage.toFixed(2);
     }
@@ -284,14 +375,16 @@ function handleMouseLeave() {
     handleTouchEnd();
 }
 
-// Slider-Event
+// Slider-Event: Änderung wird im nächsten Animationsframe gesendet
 function handleSliderChange() {
-    sendData();
+    nextSendMs = 0;
 }
 
-// Daten senden an den Server
-function sendData() {
-    console.log("SendData: " + socket.readyStat);
+// Joystick und Servo senden: bei Änderung, bei ausgelenktem Joystick zusätzlich als Keepalive
+function sendData(now) {
+    if (!socket || socket.readyState !== WebSocket.OPEN) {
+        return;
+    }
     const normalizedHorizontal = (touchX - centerX) / (canvasSize / 2 - 15);
     const normalizedVertical = (centerY - touchY) / (canvasSize / 2 - 15);
     const servoAngle = parseInt(servoSlider.value);
@@ -302,17 +395,45 @@ function sendData() {
         servo0: servoAngle
     };
 
-    //if (socket.readyState === WebSocket.OPEN) {
-        if (
-            currentData.x !== lastSentData.x ||
-            currentData.y !== lastSentData.y ||
-            currentData.servo0 !== lastSentData.servo0
-        ) {
-            console.log(JSON.stringify(currentData));
-            socket.send(JSON.stringify(currentData));
-            lastSentData = currentData;
-        }
-    //}
+    const changed =
+        currentData.x !== lastSentData.x ||
+        currentData.y !== lastSentData.y ||
+        currentData.servo0 !== lastSentData.servo0;
+    const deflected = currentData.x !== 0 || currentData.y !== 0;
+    if (!changed && !(deflected && now - lastSendMs >= KEEPALIVE_MS)) {
+        return;
+    }
+    if (useBinaryControl()) {
+        sendControlFrame([
+            { tag: CTL.DRIVE, x: currentData.x * 512, y: currentData.y * 512 },
+            { tag: CTL.SERVO, servo: 0, angle: currentData.servo0 }
+        ]);
+    } else {
+        // ts (Uhr wie im Binär-Header) erlaubt der Firmware die Einweglatenz zu schätzen
+        socket.send(JSON.stringify({ ...currentData, ts: Math.floor(performance.now()) >>> 0 }));
+    }
+    lastSentData = currentData;
+    lastSendMs = now;
+}
+
+// Gehaltene Motortasten wiederholen, solange sie gedrückt sind
+function sendMotorKeepalive(now) {
+    if (now - lastMotorSendMs < KEEPALIVE_MS || !socket || socket.readyState !== WebSocket.OPEN) {
+        return;
+    }
+    if (heldMotors[0]) controlMotorA(heldMotors[0]);
+    if (heldMotors[1]) controlMotorB(heldMotors[1]);
+}
+
+function controlLoop(now) {
+    const interval = 1000 / JOYSTICK_MAX_HZ;
+    if (now >= nextSendMs) {
+        // Nach einer Pause (Hintergrund-Tab) nicht nachholen, sondern neu takten
+        nextSendMs = (now - nextSendMs > interval) ? now + interval : nextSendMs + interval;
+        sendData(now);
+        sendMotorKeepalive(now);
+    }
+    requestAnimationFrame(controlLoop);
 }
 
 function hexToRgb(hex) {
@@ -329,31 +450,54 @@ function sendLedColor(hex) {
     const rgb = hexToRgb(hex);
     if (!rgb) return;
     const range = getLedRange();
+    if (useBinaryControl()) {
+        sendControlFrame([{ tag: CTL.LED_RANGE, start: range.start, count: range.count, r: rgb.r, g: rgb.g, b: rgb.b }]);
+        return;
+    }
     const data = {
         led_set: { start: range.start, count: range.count, color: hex.toLowerCase() }
     };
     socket.send(JSON.stringify(data));
 }
 
+// Motortasten binär: forward/backward = ±255, stop = MOTOR_STOP
+function sendMotorCommand(index, direction) {
+    if (direction === 'stop') {
+        sendControlFrame([{ tag: CTL.MOTOR_STOP, motor: index }]);
+    } else {
+        sendControlFrame([{ tag: CTL.MOTOR, motor: index, pwm: direction === 'backward' ? -255 : 255 }]);
+    }
+}
+
 // Motor C Steuerung
 function controlMotorA(direction) {
+    heldMotors[0] = direction === 'stop' ? null : direction;
+    lastMotorSendMs = performance.now();
+    if (useBinaryControl()) {
+        sendMotorCommand(0, direction);
+        return;
+    }
     //if (socket.readyState === WebSocket.OPEN) {
         const data = {
             motorA: direction
         };
         socket.send(JSON.stringify(data));
-        console.log('Sent motorA command:', data);
     //}
 }
 
 // Motor C Steuerung
 function controlMotorB(direction) {
+    heldMotors[1] = direction === 'stop' ? null : direction;
+    lastMotorSendMs = performance.now();
+    if (useBinaryControl()) {
+        sendMotorCommand(1, direction);
+        return;
+    }
     //if (socket.readyState === WebSocket.OPEN) {
         const data = {
             motorB: direction
         };
         socket.send(JSON.stringify(data));
-        console.log('Sent motorB command:', data);
     //}
 }
 
@@ -558,8 +702,8 @@ window.onload = function() {
     }
     // Initiales Zeichnen des Joysticks
     draw();
-    // Regelmäßig Daten senden (alle 200 ms)
-    setInterval(sendData, 200);
+    // Joystick pro Animationsframe streamen (Sendeschritt siehe controlLoop)
+    requestAnimationFrame(controlLoop);
 };
 
 
@@ -31,6 +31,8 @@ function connectWebSocket() {
         console.log("WebSocket connected");
         reconnectDelayMs = 1000;
         updateConnectionStatus("verbunden");
+        // Setup zeigt keine Statuswerte an
+        ws.send(JSON.stringify({ subscribe: {} }));
     };
     ws.onmessage = (event) => {
         console.log("WS Message:", event.data);
@@ -98,17 +100,44 @@ function applyDeviceName(cfg) {
     document.title = `${name} Setup`;
 }
 
+// Testlauf: Befehl alle MOTOR_TEST_REPEAT_MS wiederholen, sonst stoppt der Befehls-Timeout der
+// Firmware (500 ms) den Motor mitten im Test; nach MOTOR_TEST_MS stoppen
+const MOTOR_TEST_MS = 1000;
+const MOTOR_TEST_REPEAT_MS = 200;
+let motorTestTimer = null;
+
+function runMotorTest(cmd, stopCmd, done) {
+    stopMotorTest();
+    const started = Date.now();
+    sendWS(cmd);
+    motorTestTimer = setInterval(()=>{
+        if (Date.now() - started < MOTOR_TEST_MS) {
+            sendWS(cmd);
+            return;
+        }
+        stopMotorTest();
+        sendWS(stopCmd);
+        if (done) done();
+    }, MOTOR_TEST_REPEAT_MS);
+}
+
+function stopMotorTest() {
+    if (motorTestTimer) {
+        clearInterval(motorTestTimer);
+        motorTestTimer = null;
+    }
+}
+
 function testMotor(letter) {
-    // Motor starten (vorwärts) für max. 1s
-    sendWS({["motor"+letter]:"forward"});
-    setTimeout(()=>{
-        sendWS({["motor"+letter]:"stop"});
+    // Motor 1s vorwärts laufen lassen, dann fragen, welche Seite sich bewegt hat
+    runMotorTest({["motor"+letter]:"forward"}, {["motor"+letter]:"stop"}, ()=>{
         document.getElementById('motor'+letter+'Question').style.display='block';
-    },1000);
+    });
 }
 
 function motorMoved(letter, side) {
     // Motor stoppen
+    stopMotorTest();
     sendWS({["motor"+letter]:"stop"});
     motorSettings[letter].side = side;
     // Weiter
@@ -130,27 +159,22 @@ function directionChosen(letter, dir) {
 
 function testDirection(letter, dir) {
     // Richtung 1s testen (vorwärts/rückwärts)
-    sendWS({["motor"+letter]: dir});
-    setTimeout(()=>{
-        sendWS({["motor"+letter]:"stop"});
-    },1000);
+    runMotorTest({["motor"+letter]: dir}, {["motor"+letter]:"stop"});
 }
 
 function testDeadband(letter) {
     const slider = document.getElementById('db_slider_'+letter);
     let val = slider ? slider.value : 0;
     let idx = letterToIndex(letter);
-    // Raw PWM senden (Deadband soll nicht dazwischenfunken)
-    sendWS({"motor_raw":{"motor":idx,"pwm":parseInt(val, 10)}});
-    setTimeout(()=>{
-        sendWS({"motor_raw":{"motor":idx,"pwm":0}});
-    },1000);
+    // Raw PWM senden (Deadband soll nicht dazwischenfunken), 1s lang
+    runMotorTest({"motor_raw":{"motor":idx,"pwm":parseInt(val, 10)}}, {"motor_raw":{"motor":idx,"pwm":0}});
 }
 
 function confirmDeadband(letter) {
     let val = document.getElementById('db_slider_'+letter).value;
     motorSettings[letter].deadband = parseInt(val);
     // Motor stoppen
+    stopMotorTest();
     let idx = letterToIndex(letter);
     sendWS({"motor":idx,"pwm":0});
 
@@ -9,10 +9,10 @@ public:
     void init();
     float readVoltage();
     float readPercentage();
+    float mapVoltageToPercent(float voltage);
     
 private:
     int pin;
-    float mapVoltageToPercent(float voltage);
 
     // Divider ratio: Vbat = Vpin * dividerRatio
     // Adjust if resistor values differ.
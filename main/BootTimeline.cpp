@@ -0,0 +1,50 @@
+#include "BootTimeline.h"
+#include <atomic>
+#include <cstring>
+#include <esp_timer.h>
+
+namespace {
+struct Phase {
+    const char* name;
+    uint32_t startUs;
+    std::atomic<uint32_t> endUs;   // 0 = läuft noch
+};
+
+Phase phases[BootTimeline::MAX_PHASES];
+std::atomic<int> phaseCount{0};
+
+int usedPhases() {
+    int n = phaseCount.load();
+    return n < BootTimeline::MAX_PHASES ? n : BootTimeline::MAX_PHASES;
+}
+}
+
+extern "C" void boot_phase_begin(const char* name) {
+    int i = phaseCount.fetch_add(1);
+    if (i >= BootTimeline::MAX_PHASES) return;
+    phases[i].name = name;
+    phases[i].startUs = (uint32_t)esp_timer_get_time();
+    phases[i].endUs = 0;
+}
+
+extern "C" void boot_phase_end(const char* name) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    for (int i = usedPhases() - 1; i >= 0; i--) {
+        if (phases[i].name && !strcmp(phases[i].name, name) && phases[i].endUs == 0) {
+            phases[i].endUs = now ? now : 1;
+            return;
+        }
+    }
+}
+
+void BootTimeline::toJson(JsonArray out) {
+    for (int i = 0; i < usedPhases(); i++) {
+        if (!phases[i].name) continue;
+        JsonObject p = out.add<JsonObject>();
+        p["phase"] = phases[i].name;
+        p["start_us"] = phases[i].startUs;
+        uint32_t end = phases[i].endUs;
+        if (end) p["us"] = end - phases[i].startUs;
+        else p["running"] = true;
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+
+// Zeitleiste der Startphasen (µs seit Start der App, esp_timer_get_time). Phasen dürfen sich
+// überlappen – der WLAN-Start läuft z. B. im eigenen Task weiter, während setup() fertig wird.
+// Auch aus C aufrufbar (main.c markiert die BTstack-Initialisierung vor setup()).
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void boot_phase_begin(const char* name);   // name muss dauerhaft gültig sein (Literal)
+void boot_phase_end(const char* name);     // beendet die zuletzt begonnene Phase dieses Namens
+
+#ifdef __cplusplus
+}
+
+#include <ArduinoJson.h>
+
+namespace BootTimeline {
+    static constexpr int MAX_PHASES = 16;
+
+    // [{"phase":"config","start_us":412000,"us":8123}, ...]; laufende Phasen mit "running":true
+    void toJson(JsonArray out);
+}
+#endif
+
+#endif
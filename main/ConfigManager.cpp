@@ -1,4 +1,35 @@
 #include "ConfigManager.h"
+#include <esp_system.h>
+#include <esp_rom_crc.h>
+#include <memory>
+
+static ConfigManager* shutdownInstance = nullptr;
+
+#define CFG_DEFAULT_BOOL(d)  ((d) ? 1.0f : 0.0f), nullptr
+#define CFG_DEFAULT_INT(d)   (float)(d), nullptr
+#define CFG_DEFAULT_FLOAT(d) (float)(d), nullptr
+#define CFG_DEFAULT_STR(d)   0.0f, d
+#define CFG_DEFAULT_ENUM(d)  0.0f, d
+#define CFG_FIELD_DESC(T, key, count, min, max, def, section, flags) \
+    { #key, configKeyHash(#key, sizeof(#key) - 1), CFG_##T, count, flags, CFG_##section, \
+      (float)(min), (float)(max), CFG_DEFAULT_##T(def) },
+
+const ConfigField CONFIG_FIELDS[CONFIG_FIELD_COUNT] = { TT_CONFIG_FIELDS(CFG_FIELD_DESC) };
+
+// value in "a|b|c" suchen und nach out übernehmen; value == nullptr liefert den ersten (Standard)
+static bool enumMatch(const char* choices, const char* value, String* out) {
+    for (const char* c = choices; *c;) {
+        const char* end = strchr(c, '|');
+        size_t n = end ? (size_t)(end - c) : strlen(c);
+        if (!value || (strlen(value) == n && !strncmp(c, value, n))) {
+            *out = String(c).substring(0, n);
+            return true;
+        }
+        if (!end) break;
+        c = end + 1;
+    }
+    return false;
+}
 
 ConfigManager::ConfigManager() {
     setDefaults();
@@ -10,50 +41,81 @@ bool ConfigManager::init() {
         return false;
     }
     // Laden oder bei Fehlen defaults speichern
-    if (!fileExists("/config.json")) {
+    if (!loadConfig()) {
         saveConfig();
-    } else {
-        loadConfig();
+    }
+
+    // Ab hier speichern Änderungen über requestSave() verzögert im Hintergrund
+    if (!persistTask) {
+        xTaskCreatePinnedToCore([](void* obj) {
+            static_cast<ConfigManager*>(obj)->persistLoop();
+        }, "ConfigPersist", 4096, this, 1, &persistTask, 1);
+        shutdownInstance = this;
+        esp_register_shutdown_handler(&ConfigManager::flushOnShutdown);
     }
     return true;
 }
 
+void ConfigManager::requestSave() {
+    saveRequests++;
+    dirty = true;
+    if (persistTask) xTaskNotifyGive(persistTask);
+    else saveConfig();   // vor init(): synchron wie bisher
+}
+
+void ConfigManager::persistLoop() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t first = millis();
+        // Jede weitere Änderung im Fenster verschiebt den Schreibzeitpunkt, aber nicht endlos
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SAVE_DEBOUNCE_MS)) > 0) {
+            if (millis() - first >= SAVE_MAX_DELAY_MS) break;
+        }
+        if (dirty) saveConfig();
+    }
+}
+
+bool ConfigManager::flush() {
+    // saveMutex zuerst: läuft gerade ein Schreibvorgang des Tasks, erst dessen Ende abwarten
+    xSemaphoreTakeRecursive(saveMutex, portMAX_DELAY);
+    bool ok = dirty ? saveConfig() : true;
+    xSemaphoreGiveRecursive(saveMutex);
+    return ok;
+}
+
+void ConfigManager::flushOnShutdown() {
+    if (shutdownInstance && shutdownInstance->hasPendingSave()) {
+        Serial.println("ConfigManager: ausstehende Änderungen vor dem Neustart speichern");
+        shutdownInstance->flush();
+    }
+}
+
 void ConfigManager::setDefaults() {
-    wifi_mode = "AP";
-    wifi_ssid = "fablab";
-    wifi_password = "fablabfdm";
-    hotspot_ssid = "TinkerThinkerAP";
-    hotspot_password = "";
-    for (int i = 0; i < 4; i++) motor_invert[i] = false;
-    motor_swap = false;
-    motorLeftGUI = 2;
-    motorRightGUI = 3;
-    for (int i = 0; i < 4; i++) motor_deadband[i] = 50;
-    led_count = 30;
-    led_brightness = 50;
-    led_gamma = false;
-    ws_invert_x = false;
-    ws_invert_y = false;
-    ws_swap_sides = false;
-    bt_invert_x = false;
-    bt_invert_y = false;
-    bt_swap_axes = false;
-    ota_enabled = false;
-    for (int i=0; i<4; i++) motor_frequency[i] = 5000;
-    for (int i=0; i<7; i++) {
+    for (int id = 0; id < CONFIG_FIELD_COUNT; id++) {
+        const ConfigField& f = CONFIG_FIELDS[id];
+        for (int i = 0; i < f.count; i++) {
+            switch (f.type) {
+                case CFG_BOOL:  fieldRef<bool>(id, i) = f.defNum != 0; break;
+                case CFG_INT:   fieldRef<int>(id, i) = (int)f.defNum; break;
+                case CFG_FLOAT: fieldRef<float>(id, i) = f.defNum; break;
+                case CFG_STR:   fieldRef<String>(id, i) = f.defStr; break;
+                case CFG_ENUM:  enumMatch(f.defStr, nullptr, &fieldRef<String>(id, i)); break;
+            }
+        }
+    }
+    for (int i = 0; i < LED_OUTPUTS; i++) {
+        led_outputs[i].pin = (i == 0) ? 2 : -1;
+        led_outputs[i].count = (i == 0) ? 30 : 0;
+        led_outputs[i].order = "GRB";
+    }
+    for (int i = 0; i < SERVO_COUNT; i++) {
         servos[i].min_pw = 500;
         servos[i].max_pw = 2500;
     }
-    drive_mixer = "arcade";
-    drive_turn_gain = 1.0f;
-    drive_axis_deadband = 16;
-    motor_curve_type = "linear";
-    motor_curve_strength = 0.0f;
-    // BT scan defaults already initialized in header
     // Control bindings default: mirrors current hardcoded behavior
     control_bindings_json = String(getDefaultControlBindingsJson());
-    bt_whitelist_enabled = false;
     bt_whitelist.clear();
+    generation++;
 }
 
 bool ConfigManager::fileExists(const char* path) {
@@ -61,11 +123,56 @@ bool ConfigManager::fileExists(const char* path) {
 }
 
 bool ConfigManager::loadConfig() {
-    File file = LittleFS.open("/config.json", "r");
-    if (!file) {
-        Serial.println("Failed to open config file for reading");
+    uint32_t start = micros();
+    if (loadBinary()) {
+        loadUs = micros() - start;
+        loadSource = "bin";
+    } else if (loadJsonFile()) {
+        loadUs = micros() - start;
+        loadSource = "json";
+        // Einmalige Übernahme: binär sichern, danach gibt es /config.json nur noch als Export
+        if (saveConfig()) LittleFS.remove(CONFIG_JSON_PATH);
+    } else {
+        return false;
+    }
+    Serial.printf("loadConfig: %s in %u us\n", loadSource, (unsigned)loadUs);
+    return true;
+}
+
+bool ConfigManager::loadBinary() {
+    File file = LittleFS.open(CONFIG_BIN_PATH, "r");
+    if (!file) return false;
+    BinHeader h;
+    size_t size = file.size();
+    if (file.read((uint8_t*)&h, sizeof(h)) != sizeof(h) || h.magic != CONFIG_BIN_MAGIC ||
+        h.version != CONFIG_BIN_VERSION || h.headerSize != sizeof(h) || h.payloadLen != size - sizeof(h)) {
+        Serial.println("config.bin: unbekanntes Format oder abgeschnitten");
+        file.close();
         return false;
     }
+    std::unique_ptr<uint8_t[]> payload(new (std::nothrow) uint8_t[h.payloadLen]);
+    bool ok = payload && file.read(payload.get(), h.payloadLen) == h.payloadLen;
+    file.close();
+    if (!ok) return false;
+    if (esp_rom_crc32_le(0, payload.get(), h.payloadLen) != h.crc) {
+        Serial.println("config.bin: CRC-Fehler");
+        return false;
+    }
+    JsonDocument doc;
+    DeserializationError err = deserializeMsgPack(doc, payload.get(), h.payloadLen);
+    payload.reset();
+    if (err) {
+        Serial.printf("config.bin: %s\n", err.c_str());
+        return false;
+    }
+    setDefaults();
+    applyDocument(doc.as<JsonObjectConst>(), true);
+    return true;
+}
+
+bool ConfigManager::loadJsonFile() {
+    File file = LittleFS.open(CONFIG_JSON_PATH, "r");
+    if (!file) return false;
     JsonDocument doc;
     DeserializationError err = deserializeJson(doc, file);
     file.close();
@@ -73,183 +180,501 @@ bool ConfigManager::loadConfig() {
         Serial.println("Failed to parse config.json");
         return false;
     }
+    setDefaults();
+    applyDocument(doc.as<JsonObjectConst>(), false);
+    return true;
+}
 
-    wifi_mode = doc["wifi_mode"] | "AP";
-    wifi_ssid = doc["wifi_ssid"] | "MyAP";
-    wifi_password = doc["wifi_password"] | "Password";
-    hotspot_ssid = doc["hotspot_ssid"] | "TinkerThinkerAP";
-    hotspot_password = doc["hotspot_password"] | "";
+void ConfigManager::importJson(JsonObjectConst in) {
+    lockData();
+    setDefaults();
+    applyDocument(in, false);
+    unlockData();
+    requestSave();
+}
 
-    JsonArray motorInvertArr = doc["motor_invert"].as<JsonArray>();
-    for (int i=0; i<4; i++) {
-        motor_invert[i] = motorInvertArr[i] | false;
-    }
+void ConfigManager::exportJson(JsonObject out) {
+    lockData();
+    fillDocument(out, false);
+    unlockData();
+}
 
-    motor_swap = doc["motor_swap"] | false;
-    // Motor GUI
-    motorLeftGUI = doc["motor_left_gui"] | 2;
-    motorRightGUI = doc["motor_right_gui"] | 3;
-    led_count = doc["led_count"] | 30;
-    led_brightness = doc["led_brightness"] | 50;
-    led_gamma = doc["led_gamma"] | false;
-    ws_invert_x = doc["ws_invert_x"] | false;
-    ws_invert_y = doc["ws_invert_y"] | false;
-    ws_swap_sides = doc["ws_swap_sides"] | false;
-    bt_invert_x = doc["bt_invert_x"] | false;
-    bt_invert_y = doc["bt_invert_y"] | false;
-    bt_swap_axes = doc["bt_swap_axes"] | false;
-    ota_enabled = doc["ota_enabled"] | false;
-    JsonArray motorDeadbandArr = doc["motor_deadband"].as<JsonArray>();
-    for (int i=0; i<4; i++) {
-        motor_deadband[i] = motorDeadbandArr[i] | 50;
+// Text als JSON-String mit Escapes
+static void printJsonString(Print& out, const char* s) {
+    out.print('"');
+    for (; *s; s++) {
+        char c = *s;
+        if (c == '"' || c == '\\') {
+            out.print('\\');
+            out.print(c);
+        } else if ((uint8_t)c < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)(uint8_t)c);
+            out.print(esc);
+        } else {
+            out.print(c);
+        }
     }
+    out.print('"');
+}
 
-    JsonArray motorFreqArr = doc["motor_frequency"].as<JsonArray>();
-    for (int i=0; i<4; i++) {
-        motor_frequency[i] = motorFreqArr[i] | 5000;
-    }
+static void printJsonKey(Print& out, bool first, const char* key) {
+    if (!first) out.print(',');
+    printJsonString(out, key);
+    out.print(':');
+}
 
-    JsonArray servoArr = doc["servo_settings"].as<JsonArray>();
-    for (int i=0; i<7; i++) {
-        servos[i].min_pw = servoArr[i]["min_pulsewidth"] | 500;
-        servos[i].max_pw = servoArr[i]["max_pulsewidth"] | 2500;
+void ConfigManager::printField(Print& out, int id, int index) {
+    switch (CONFIG_FIELDS[id].type) {
+        case CFG_BOOL:  out.print(fieldRef<bool>(id, index) ? "true" : "false"); break;
+        case CFG_INT:   out.print(fieldRef<int>(id, index)); break;
+        case CFG_FLOAT: {
+            char num[24];
+            snprintf(num, sizeof(num), "%g", (double)fieldRef<float>(id, index));
+            out.print(num);
+            break;
+        }
+        default:        printJsonString(out, fieldRef<String>(id, index).c_str()); break;
     }
+}
 
-    // Optional: BT scan settings
-    bt_scan_on_normal_ms  = doc["bt_scan_on_normal_ms"]  | bt_scan_on_normal_ms;
-    bt_scan_off_normal_ms = doc["bt_scan_off_normal_ms"] | bt_scan_off_normal_ms;
-    bt_scan_on_sta_ms     = doc["bt_scan_on_sta_ms"]     | bt_scan_on_sta_ms;
-    bt_scan_off_sta_ms    = doc["bt_scan_off_sta_ms"]    | bt_scan_off_sta_ms;
-    bt_scan_on_ap_ms      = doc["bt_scan_on_ap_ms"]      | bt_scan_on_ap_ms;
-    bt_scan_off_ap_ms     = doc["bt_scan_off_ap_ms"]     | bt_scan_off_ap_ms;
+void ConfigManager::exportJson(Print& out, const char* extraMembers) {
+    lockData();
+    printExport(out, extraMembers);
+    unlockData();
+}
 
-    if (!doc["drive_mixer"].isNull()) {
-        setDriveMixer(String((const char*)doc["drive_mixer"]));
+bool ConfigManager::exportJson(Print& out, const char* extraMembers, uint32_t gen) {
+    lockData();
+    bool unchanged = generation == gen;
+    if (unchanged) printExport(out, extraMembers);
+    unlockData();
+    return unchanged;
+}
+
+// Gleicher Inhalt wie fillDocument(doc, false), aber Feld für Feld geschrieben. Nur unter lockData().
+void ConfigManager::printExport(Print& out, const char* extraMembers) {
+    out.print('{');
+    for (int id = 0; id < CONFIG_FIELD_COUNT; id++) {
+        if (out.getWriteError()) return;
+        const ConfigField& f = CONFIG_FIELDS[id];
+        printJsonKey(out, id == 0, f.key);
+        if (f.count == 1) {
+            printField(out, id, 0);
+        } else {
+            out.print('[');
+            for (int i = 0; i < f.count; i++) {
+                if (i) out.print(',');
+                printField(out, id, i);
+            }
+            out.print(']');
+        }
     }
-    if (!doc["drive_turn_gain"].isNull()) {
-        setDriveTurnGain(doc["drive_turn_gain"].as<float>());
+
+    if (out.getWriteError()) return;
+    printJsonKey(out, false, "led_count");
+    out.print(led_outputs[0].count);
+    printJsonKey(out, false, "led_outputs");
+    out.print('[');
+    for (int i = 0; i < LED_OUTPUTS; i++) {
+        out.printf("%s{\"pin\":%d,\"count\":%d,\"order\":", i ? "," : "", led_outputs[i].pin, led_outputs[i].count);
+        printJsonString(out, led_outputs[i].order.c_str());
+        out.print('}');
     }
-    if (!doc["drive_axis_deadband"].isNull()) {
-        setDriveAxisDeadband(doc["drive_axis_deadband"].as<int>());
+    out.print(']');
+    printJsonKey(out, false, "servo_settings");
+    out.print('[');
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        out.printf("%s{\"min_pulsewidth\":%d,\"max_pulsewidth\":%d}", i ? "," : "", servos[i].min_pw, servos[i].max_pw);
     }
-    if (!doc["motor_curve_type"].isNull()) {
-        setMotorCurveType(String((const char*)doc["motor_curve_type"]));
+    out.print(']');
+
+    // Gespeichert ist normalisiertes JSON: unverändert ausgeben
+    if (out.getWriteError()) return;
+    printJsonKey(out, false, "control_bindings");
+    out.print(control_bindings_json.length() > 0 ? control_bindings_json.c_str() : getDefaultControlBindingsJson());
+
+    if (out.getWriteError()) return;
+    printJsonKey(out, false, "bt_whitelist");
+    out.print('[');
+    for (size_t i = 0; i < bt_whitelist.size(); i++) {
+        if (i) out.print(',');
+        printJsonString(out, bt_whitelist[i].c_str());
     }
-    if (!doc["motor_curve_strength"].isNull()) {
-        setMotorCurveStrength(doc["motor_curve_strength"].as<float>());
+    out.print(']');
+
+    if (extraMembers && *extraMembers) {
+        out.print(',');
+        out.print(extraMembers);
     }
+    out.print('}');
+}
+
+ConfigManager::ConfigChange ConfigManager::applyJson(JsonObjectConst in) {
+    lockData();
+    ConfigChange change = applyDocument(in, false);
+    unlockData();
+    return change;
+}
+
+void ConfigManager::exportFields(JsonObject out) {
+    lockData();
+    fillFields(out);
+    unlockData();
+}
 
-    // Control bindings (store raw JSON)
-    if (!doc["control_bindings"].isNull()) {
-        String tmp;
-        serializeJson(doc["control_bindings"], tmp);
-        control_bindings_json = tmp;
+int ConfigManager::findField(const char* key, size_t len) {
+    uint32_t h = configKeyHash(key, len);
+    for (int id = 0; id < CONFIG_FIELD_COUNT; id++) {
+        const ConfigField& f = CONFIG_FIELDS[id];
+        if (f.hash == h && !strncmp(f.key, key, len) && f.key[len] == '\0') return id;
     }
+    return -1;
+}
 
-    // Bluetooth Whitelist
-    bt_whitelist_enabled = doc["bt_whitelist_enabled"] | false;
-    bt_whitelist.clear();
-    if (!doc["bt_whitelist"].isNull()) {
-        JsonArray wlArr = doc["bt_whitelist"].as<JsonArray>();
-        for (JsonVariant v : wlArr) {
-            String mac = v.as<String>();
-            if (mac.length() == 17) bt_whitelist.push_back(mac);
-        }
+uint16_t ConfigManager::storeBool(int id, int index, bool value) {
+    bool& dst = fieldRef<bool>(id, index);
+    if (dst == value) return 0;
+    lockData();
+    dst = value;
+    generation++;
+    unlockData();
+    return CONFIG_FIELDS[id].section;
+}
+
+uint16_t ConfigManager::storeNumber(int id, int index, float value) {
+    const ConfigField& f = CONFIG_FIELDS[id];
+    if (isnan(value)) return 0;
+    if (value < f.min) value = f.min;
+    if (value > f.max) value = f.max;
+    if (f.type == CFG_INT) {
+        int& dst = fieldRef<int>(id, index);
+        if (dst == (int)value) return 0;
+        lockData();
+        dst = (int)value;
+    } else if (f.type == CFG_FLOAT) {
+        float& dst = fieldRef<float>(id, index);
+        if (dst == value) return 0;
+        lockData();
+        dst = value;
+    } else {
+        return storeBool(id, index, value != 0);
     }
+    generation++;
+    unlockData();
+    return f.section;
+}
 
-    return true;
+uint16_t ConfigManager::storeString(int id, int index, const char* value) {
+    const ConfigField& f = CONFIG_FIELDS[id];
+    String v(value);
+    if (f.type == CFG_ENUM) {
+        if (!enumMatch(f.defStr, value, &v)) enumMatch(f.defStr, nullptr, &v);
+    } else {
+        v.replace("\r", "");
+        v.replace("\n", "");
+        if (f.flags & CF_TRIM) v.trim();
+        if (f.max > 0 && v.length() > (unsigned)f.max) v.remove((unsigned)f.max);
+        if ((f.flags & CF_NONEMPTY) && !v.length()) return 0;
+    }
+    String& dst = fieldRef<String>(id, index);
+    if (dst == v) return 0;
+    lockData();
+    dst = v;
+    generation++;
+    unlockData();
+    return f.section;
 }
 
-bool ConfigManager::saveConfig() {
-    JsonDocument doc;
-    doc["wifi_mode"] = wifi_mode;
-    doc["wifi_ssid"] = wifi_ssid;
-    doc["wifi_password"] = wifi_password;
-    doc["hotspot_ssid"] = hotspot_ssid;
-    doc["hotspot_password"] = hotspot_password;
-
-    JsonArray invArr = doc["motor_invert"].to<JsonArray>();
-    for (int i=0; i<4; i++) invArr.add(motor_invert[i]);
-
-    doc["motor_swap"] = motor_swap;
-
-    // Motor GUI
-    doc["motor_left_gui"] = motorLeftGUI;
-    doc["motor_right_gui"] = motorRightGUI;
-
-    JsonArray dbArr = doc["motor_deadband"].to<JsonArray>();
-    for (int i=0; i<4; i++) dbArr.add(motor_deadband[i]);
-
-    JsonArray freqArr = doc["motor_frequency"].to<JsonArray>();
-    for (int i=0; i<4; i++) freqArr.add(motor_frequency[i]);
-
-    doc["led_count"] = led_count;
-    doc["led_brightness"] = led_brightness;
-    doc["led_gamma"] = led_gamma;
-    doc["ws_invert_x"] = ws_invert_x;
-    doc["ws_invert_y"] = ws_invert_y;
-    doc["ws_swap_sides"] = ws_swap_sides;
-    doc["bt_invert_x"] = bt_invert_x;
-    doc["bt_invert_y"] = bt_invert_y;
-    doc["bt_swap_axes"] = bt_swap_axes;
-    doc["ota_enabled"] = ota_enabled;
+// Formularwerte: Checkbox "on", Zahlen als Text (leer = unverändert)
+uint16_t ConfigManager::storeText(int id, int index, const char* text) {
+    switch (CONFIG_FIELDS[id].type) {
+        case CFG_BOOL:
+            return storeBool(id, index, !strcmp(text, "on") || !strcmp(text, "true") || !strcmp(text, "1"));
+        case CFG_INT:
+        case CFG_FLOAT: {
+            char* end;
+            float v = strtof(text, &end);
+            if (end == text) return 0;
+            return storeNumber(id, index, v);
+        }
+        default:
+            return storeString(id, index, text);
+    }
+}
 
-    JsonArray servoArr = doc["servo_settings"].to<JsonArray>();
-    for (int i=0; i<7; i++){
-        JsonObject sObj = servoArr.add<JsonObject>();
-        sObj["min_pulsewidth"] = servos[i].min_pw;
-        sObj["max_pulsewidth"] = servos[i].max_pw;
+uint16_t ConfigManager::storeVariant(int id, int index, JsonVariantConst value) {
+    if (value.is<const char*>()) return storeText(id, index, value.as<const char*>());
+    switch (CONFIG_FIELDS[id].type) {
+        case CFG_BOOL:  return value.is<bool>() || value.is<float>() ? storeBool(id, index, value.as<bool>()) : 0;
+        case CFG_INT:
+        case CFG_FLOAT: return value.is<float>() ? storeNumber(id, index, value.as<float>()) : 0;
+        default:        return 0;
     }
+}
 
-    // Drive profile & motor curve
-    doc["drive_mixer"] = drive_mixer;
-    doc["drive_turn_gain"] = drive_turn_gain;
-    doc["drive_axis_deadband"] = drive_axis_deadband;
-    doc["motor_curve_type"] = motor_curve_type;
-    doc["motor_curve_strength"] = motor_curve_strength;
+void ConfigManager::writeField(JsonVariant out, int id, int index) {
+    switch (CONFIG_FIELDS[id].type) {
+        case CFG_BOOL:  out.set(fieldRef<bool>(id, index)); break;
+        case CFG_INT:   out.set(fieldRef<int>(id, index)); break;
+        case CFG_FLOAT: out.set(fieldRef<float>(id, index)); break;
+        default:        out.set(fieldRef<String>(id, index)); break;
+    }
+}
 
-    // BT scan settings
-    doc["bt_scan_on_normal_ms"]  = bt_scan_on_normal_ms;
-    doc["bt_scan_off_normal_ms"] = bt_scan_off_normal_ms;
-    doc["bt_scan_on_sta_ms"]     = bt_scan_on_sta_ms;
-    doc["bt_scan_off_sta_ms"]    = bt_scan_off_sta_ms;
-    doc["bt_scan_on_ap_ms"]      = bt_scan_on_ap_ms;
-    doc["bt_scan_off_ap_ms"]     = bt_scan_off_ap_ms;
+uint16_t ConfigManager::storeLedOutput(int index, int pin, int count, const String& order) {
+    LedOutputConfig before = led_outputs[index];
+    setLedOutput(index, pin, count, order);
+    const LedOutputConfig& o = led_outputs[index];
+    return (o.pin != before.pin || o.count != before.count || o.order != before.order) ? CFG_LED : 0;
+}
 
-    // Control bindings: embed stored JSON
-    if (control_bindings_json.length() > 0) {
-        JsonDocument binds;
-        DeserializationError err = deserializeJson(binds, control_bindings_json);
-        if (!err) {
-            doc["control_bindings"] = binds;
+uint16_t ConfigManager::storeServo(int index, int min_pw, int max_pw) {
+    min_pw = constrain(min_pw, SERVO_PW_MIN, SERVO_PW_MAX);
+    max_pw = constrain(max_pw, SERVO_PW_MIN, SERVO_PW_MAX);
+    if (servos[index].min_pw == min_pw && servos[index].max_pw == max_pw) return 0;
+    lockData();
+    servos[index].min_pw = min_pw;
+    servos[index].max_pw = max_pw;
+    generation++;
+    unlockData();
+    return CFG_SERVO;
+}
+
+// Ein Durchlauf über die Eingabe; Schema-Felder per Hash, der Rest von Hand.
+// rawBindings: Bindings liegen als fertiger JSON-Text vor (Binärformat) statt als verschachteltes JSON
+ConfigManager::ConfigChange ConfigManager::applyDocument(JsonObjectConst doc, bool rawBindings) {
+    ConfigChange change;
+    for (JsonPairConst kv : doc) {
+        const char* key = kv.key().c_str();
+        JsonVariantConst value = kv.value();
+        int id = findField(key, kv.key().size());
+        if (id >= 0) {
+            change.fields++;
+            if (CONFIG_FIELDS[id].count == 1) {
+                change.sections |= storeVariant(id, 0, value);
+            } else {
+                JsonArrayConst arr = value.as<JsonArrayConst>();
+                for (int i = 0; i < CONFIG_FIELDS[id].count && i < (int)arr.size(); i++) {
+                    change.sections |= storeVariant(id, i, arr[i]);
+                }
+            }
+            continue;
+        }
+
+        if (!strcmp(key, "led_count")) {
+            // Ausgang 0; led_outputs (falls vorhanden) gilt ebenso
+            if (value.is<int>()) change.sections |= storeLedOutput(0, led_outputs[0].pin, value.as<int>(), led_outputs[0].order);
+        } else if (!strcmp(key, "led_outputs")) {
+            // {"led_outputs":[{"pin":2,"count":30,"order":"GRB"}, ...]} – fehlende Felder bleiben unverändert
+            JsonArrayConst arr = value.as<JsonArrayConst>();
+            for (int i = 0; i < LED_OUTPUTS && i < (int)arr.size(); i++) {
+                JsonObjectConst o = arr[i];
+                change.sections |= storeLedOutput(i, o["pin"] | led_outputs[i].pin, o["count"] | led_outputs[i].count,
+                                                  String(o["order"] | led_outputs[i].order.c_str()));
+            }
+        } else if (!strcmp(key, "servo_settings")) {
+            JsonArrayConst arr = value.as<JsonArrayConst>();
+            for (int i = 0; i < SERVO_COUNT && i < (int)arr.size(); i++) {
+                change.sections |= storeServo(i, arr[i]["min_pulsewidth"] | servos[i].min_pw,
+                                              arr[i]["max_pulsewidth"] | servos[i].max_pw);
+            }
+        } else if (!strcmp(key, rawBindings ? "control_bindings_json" : "control_bindings")) {
+            // Control bindings (store raw JSON)
+            String tmp;
+            if (rawBindings) tmp = value.as<const char*>();
+            else serializeJson(value, tmp);
+            if (tmp != control_bindings_json) {
+                change.sections |= CFG_BINDINGS;
+                control_bindings_json = tmp;
+                generation++;
+            }
+        } else if (!strcmp(key, "bt_whitelist")) {
+            std::vector<String> list;
+            for (JsonVariantConst v : value.as<JsonArrayConst>()) {
+                String mac = v.as<String>();
+                if (mac.length() == 17) list.push_back(mac);
+            }
+            if (list != bt_whitelist) {
+                change.sections |= CFG_BT;
+                bt_whitelist = list;
+                generation++;
+            }
+        } else {
+            continue;
+        }
+        change.fields++;
+    }
+    return change;
+}
+
+ConfigManager::ConfigChange ConfigManager::applyForm(const FormField* params, size_t count) {
+    ConfigChange change;
+    uint8_t seen[CONFIG_FIELD_COUNT] = {};   // je Feld ein Bit pro Index, für die Checkboxen
+    lockData();
+    for (size_t p = 0; p < count; p++) {
+        const char* name = params[p].name;
+        const char* value = params[p].value;
+        size_t len = strlen(name);
+        int index = 0;
+        int id = findField(name, len);
+        if (id < 0) {
+            // Arrays: motor_invert_2 -> motor_invert[2]
+            const char* us = strrchr(name, '_');
+            if (us && isdigit((unsigned char)us[1])) {
+                index = atoi(us + 1);
+                id = findField(name, us - name);
+                if (id >= 0 && index >= CONFIG_FIELDS[id].count) id = -1;
+            }
+        }
+        if (id >= 0) {
+            seen[id] |= 1 << index;
+            change.sections |= storeText(id, index, value);
+            change.fields++;
+            continue;
+        }
+
+        // LED-Ausgänge (led_pin_<i>, led_count_<i>, led_order_<i>), led_count = Ausgang 0, servo<i>_min/_max
+        int i = -1;
+        char part[8];
+        if (!strcmp(name, "led_count")) {
+            if (*value) change.sections |= storeLedOutput(0, led_outputs[0].pin, atoi(value), led_outputs[0].order);
+        } else if (sscanf(name, "led_%7[a-z]_%d", part, &i) == 2 && i >= 0 && i < LED_OUTPUTS) {
+            LedOutputConfig o = led_outputs[i];
+            if (!strcmp(part, "pin")) o.pin = atoi(value);
+            else if (!strcmp(part, "count")) o.count = atoi(value);
+            else if (!strcmp(part, "order")) o.order = value;
+            else continue;
+            change.sections |= storeLedOutput(i, o.pin, o.count, o.order);
+        } else if (sscanf(name, "servo%d_%3s", &i, part) == 2 && i >= 0 && i < SERVO_COUNT && *value) {
+            if (!strcmp(part, "min")) change.sections |= storeServo(i, atoi(value), servos[i].max_pw);
+            else if (!strcmp(part, "max")) change.sections |= storeServo(i, servos[i].min_pw, atoi(value));
+            else continue;
+        } else {
+            continue;
+        }
+        change.fields++;
+    }
+    // Nicht angehakte Checkboxen schickt der Browser gar nicht mit
+    for (int id = 0; id < CONFIG_FIELD_COUNT; id++) {
+        if (!(CONFIG_FIELDS[id].flags & CF_CHECKBOX)) continue;
+        for (int i = 0; i < CONFIG_FIELDS[id].count; i++) {
+            if (!(seen[id] & (1 << i))) change.sections |= storeBool(id, i, false);
         }
     }
+    unlockData();
+    return change;
+}
 
-    // Bluetooth Whitelist
-    doc["bt_whitelist_enabled"] = bt_whitelist_enabled;
-    JsonArray wlArr = doc["bt_whitelist"].to<JsonArray>();
-    for (const auto& mac : bt_whitelist) wlArr.add(mac);
+bool ConfigManager::saveConfig() {
+    xSemaphoreTakeRecursive(saveMutex, portMAX_DELAY);
+    lockData();
+    // Stand ab hier ist erfasst; spätere Änderungen lösen einen neuen Schreibvorgang aus
+    dirty = false;
+    JsonDocument doc;
+    fillDocument(doc.to<JsonObject>(), true);
+    unlockData();
 
     if (doc.overflowed()) {
         Serial.println("saveConfig: JSON-Dokument zu klein (overflow) – NICHT gespeichert");
+        xSemaphoreGiveRecursive(saveMutex);
+        return false;
+    }
+
+    bool ok = writeBinary(doc);
+    if (ok) saveWrites++;
+    else dirty = true;   // beim nächsten flush() erneut versuchen
+    xSemaphoreGiveRecursive(saveMutex);
+    return ok;
+}
+
+// Erst vollständig in eine Temp-Datei schreiben, dann per rename ersetzen: ein Stromausfall
+// mittendrin hinterlässt die alte oder die neue Datei, nie eine halbe.
+bool ConfigManager::writeBinary(JsonDocument& doc) {
+    BinHeader h = {CONFIG_BIN_MAGIC, CONFIG_BIN_VERSION, sizeof(BinHeader), 0, 0};
+    h.payloadLen = measureMsgPack(doc);
+    std::unique_ptr<uint8_t[]> payload(new (std::nothrow) uint8_t[h.payloadLen]);
+    if (!payload) {
+        Serial.println("saveConfig: kein Speicher");
         return false;
     }
+    serializeMsgPack(doc, payload.get(), h.payloadLen);
+    h.crc = esp_rom_crc32_le(0, payload.get(), h.payloadLen);
 
-    File file = LittleFS.open("/config.json", "w");
+    static const char* tmpPath = "/config.bin.tmp";
+    File file = LittleFS.open(tmpPath, "w");
     if (!file) {
         Serial.println("Failed to open config file for writing");
         return false;
     }
-
-    size_t written = serializeJson(doc, file);
+    bool ok = file.write((const uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+              file.write(payload.get(), h.payloadLen) == h.payloadLen;
     file.close();
-    Serial.printf("saveConfig: %u Bytes nach /config.json geschrieben\n", (unsigned)written);
+    if (!ok || !LittleFS.rename(tmpPath, CONFIG_BIN_PATH)) {
+        Serial.println("saveConfig: Schreiben fehlgeschlagen");
+        LittleFS.remove(tmpPath);
+        return false;
+    }
+    Serial.printf("saveConfig: %u Bytes nach %s geschrieben (%u/%u Anforderungen)\n",
+                  (unsigned)(sizeof(h) + h.payloadLen), CONFIG_BIN_PATH,
+                  (unsigned)saveWrites.load() + 1, (unsigned)saveRequests.load());
     return true;
 }
 
+void ConfigManager::fillFields(JsonObject doc) {
+    for (int id = 0; id < CONFIG_FIELD_COUNT; id++) {
+        const ConfigField& f = CONFIG_FIELDS[id];
+        // Schlüssel liegen in der Tabelle und werden nicht ins Dokument kopiert
+        JsonString key(f.key, true);
+        if (f.count == 1) {
+            writeField(doc[key].to<JsonVariant>(), id, 0);
+        } else {
+            JsonArray arr = doc[key].to<JsonArray>();
+            for (int i = 0; i < f.count; i++) writeField(arr.add<JsonVariant>(), id, i);
+        }
+    }
+
+    doc["led_count"] = led_outputs[0].count;
+    JsonArray ledOutArr = doc["led_outputs"].to<JsonArray>();
+    for (int i=0; i<LED_OUTPUTS; i++){
+        JsonObject oObj = ledOutArr.add<JsonObject>();
+        oObj["pin"] = led_outputs[i].pin;
+        oObj["count"] = led_outputs[i].count;
+        oObj["order"] = led_outputs[i].order;
+    }
+
+    JsonArray servoArr = doc["servo_settings"].to<JsonArray>();
+    for (int i=0; i<SERVO_COUNT; i++){
+        JsonObject sObj = servoArr.add<JsonObject>();
+        sObj["min_pulsewidth"] = servos[i].min_pw;
+        sObj["max_pulsewidth"] = servos[i].max_pw;
+    }
+}
+
+// rawBindings: Bindings als fertigen JSON-Text ablegen (Binärformat), sonst als verschachteltes JSON
+void ConfigManager::fillDocument(JsonObject doc, bool rawBindings) {
+    fillFields(doc);
+
+    // Control bindings: gespeichert ist immer normalisiertes JSON, daher ohne erneutes Parsen
+    // übernehmen (als String bzw. als Rohtext im exportierten JSON)
+    if (control_bindings_json.length() > 0) {
+        if (rawBindings) doc["control_bindings_json"] = control_bindings_json;
+        else doc["control_bindings"] = serialized(control_bindings_json);
+    }
+
+    // Bluetooth Whitelist
+    JsonArray wlArr = doc["bt_whitelist"].to<JsonArray>();
+    for (const auto& mac : bt_whitelist) wlArr.add(mac);
+}
+
 bool ConfigManager::resetConfig() {
+    xSemaphoreTakeRecursive(saveMutex, portMAX_DELAY);
+    lockData();
     setDefaults();
-    return saveConfig();
+    unlockData();
+    bool ok = saveConfig();
+    xSemaphoreGiveRecursive(saveMutex);
+    return ok;
 }
 
 const char* ConfigManager::getDefaultControlBindingsJson() {
@@ -283,13 +708,21 @@ String ConfigManager::getWifiSSID() { return wifi_ssid; }
 String ConfigManager::getWifiPassword() { return wifi_password; }
 String ConfigManager::getHotspotSSID() { return hotspot_ssid; }
 String ConfigManager::getHotspotPassword() { return hotspot_password; }
+String ConfigManager::getWifiStaticIp() { return wifi_static_ip; }
+String ConfigManager::getWifiGateway() { return wifi_gateway; }
+String ConfigManager::getWifiNetmask() { return wifi_netmask; }
+String ConfigManager::getWifiDns() { return wifi_dns; }
 bool ConfigManager::getMotorInvert(int index) { return motor_invert[index]; }
 bool ConfigManager::getMotorSwap() { return motor_swap; }
-int ConfigManager::getMotorLeftGUI() { return motorLeftGUI; }
-int ConfigManager::getMotorRightGUI() { return motorRightGUI; }
-int ConfigManager::getLedCount() { return led_count; }
+int ConfigManager::getMotorLeftGUI() { return motor_left_gui; }
+int ConfigManager::getMotorRightGUI() { return motor_right_gui; }
+int ConfigManager::getLedCount() { return led_outputs[0].count; }
+int ConfigManager::getLedOutputPin(int index) { return (index >= 0 && index < LED_OUTPUTS) ? led_outputs[index].pin : -1; }
+int ConfigManager::getLedOutputCount(int index) { return (index >= 0 && index < LED_OUTPUTS) ? led_outputs[index].count : 0; }
+String ConfigManager::getLedOutputOrder(int index) { return (index >= 0 && index < LED_OUTPUTS) ? led_outputs[index].order : String("GRB"); }
 int ConfigManager::getLedBrightness() { return led_brightness; }
 bool ConfigManager::getLedGamma() { return led_gamma; }
+int ConfigManager::getLedPowerLimitMw() { return led_power_limit_mw; }
 bool ConfigManager::getWsInvertX() { return ws_invert_x; }
 bool ConfigManager::getWsInvertY() { return ws_invert_y; }
 bool ConfigManager::getWsSwapSides() { return ws_swap_sides; }
@@ -310,71 +743,58 @@ int ConfigManager::getBtScanOffSta()    { return bt_scan_off_sta_ms; }
 int ConfigManager::getBtScanOnAp()      { return bt_scan_on_ap_ms; }
 int ConfigManager::getBtScanOffAp()     { return bt_scan_off_ap_ms; }
 
-// Setter
-void ConfigManager::setWifiMode(const String &mode) { wifi_mode = mode; }
-void ConfigManager::setWifiSSID(const String &ssid) { wifi_ssid = ssid; }
-void ConfigManager::setWifiPassword(const String &pass) { wifi_password = pass; }
-void ConfigManager::setHotspotSSID(const String &ssid){ hotspot_ssid = ssid; }
-void ConfigManager::setHotspotPassword(const String &pass){ hotspot_password = pass; }
-void ConfigManager::setMotorInvert(int index, bool inv) { motor_invert[index] = inv; }
-void ConfigManager::setMotorSwap(bool swap) { motor_swap = swap; }
-void ConfigManager::setMotorLeftGUI(int motorIndex){ motorLeftGUI = motorIndex; }
-void ConfigManager::setMotorRightGUI(int motorIndex){ motorRightGUI = motorIndex; }
-void ConfigManager::setLedCount(int count){ led_count = count; }
-void ConfigManager::setLedBrightness(int value){
-    if (value < 0) value = 0;
-    if (value > 255) value = 255;
-    led_brightness = value;
-}
-void ConfigManager::setLedGamma(bool enabled){ led_gamma = enabled; }
-void ConfigManager::setWsInvertX(bool v){ ws_invert_x = v; }
-void ConfigManager::setWsInvertY(bool v){ ws_invert_y = v; }
-void ConfigManager::setWsSwapSides(bool v){ ws_swap_sides = v; }
-void ConfigManager::setBtInvertX(bool v){ bt_invert_x = v; }
-void ConfigManager::setBtInvertY(bool v){ bt_invert_y = v; }
-void ConfigManager::setBtSwapAxes(bool v){ bt_swap_axes = v; }
-void ConfigManager::setOTAEnabled(bool enabled){ ota_enabled = enabled; }
-void ConfigManager::setServoPulsewidthRange(int index, int min_pw, int max_pw){
-    servos[index].min_pw = min_pw;
-    servos[index].max_pw = max_pw;
-}
-void ConfigManager::setMotorDeadband(int index, int val){ motor_deadband[index] = val;}
-void ConfigManager::setMotorFrequency(int index, int val){ motor_frequency[index]=val;}
-void ConfigManager::setDriveMixer(const String& mixer){
-    if (mixer == "tank") {
-        drive_mixer = "tank";
-    } else {
-        drive_mixer = "arcade";
-    }
-}
-void ConfigManager::setDriveTurnGain(float gain){
-    if (gain < 0.0f) gain = 0.0f;
-    if (gain > 2.5f) gain = 2.5f;
-    drive_turn_gain = gain;
+// Setter: gleiche Begrenzung wie Formular und set_config, siehe ConfigSchema.h
+// (String-Setter sperren dataMutex: der ConfigPersist-Task kann gerade dieselben Strings kopieren)
+void ConfigManager::setWifiMode(const String &mode) { storeString(CFG_F_wifi_mode, 0, mode.c_str()); }
+void ConfigManager::setWifiSSID(const String &ssid) { storeString(CFG_F_wifi_ssid, 0, ssid.c_str()); }
+void ConfigManager::setWifiPassword(const String &pass) { storeString(CFG_F_wifi_password, 0, pass.c_str()); }
+void ConfigManager::setHotspotSSID(const String &ssid){ storeString(CFG_F_hotspot_ssid, 0, ssid.c_str()); }
+void ConfigManager::setHotspotPassword(const String &pass){ storeString(CFG_F_hotspot_password, 0, pass.c_str()); }
+void ConfigManager::setMotorInvert(int index, bool inv) { storeBool(CFG_F_motor_invert, index, inv); }
+void ConfigManager::setMotorSwap(bool swap) { storeBool(CFG_F_motor_swap, 0, swap); }
+void ConfigManager::setMotorLeftGUI(int motorIndex){ storeNumber(CFG_F_motor_left_gui, 0, motorIndex); }
+void ConfigManager::setMotorRightGUI(int motorIndex){ storeNumber(CFG_F_motor_right_gui, 0, motorIndex); }
+void ConfigManager::setLedCount(int count){ setLedOutput(0, led_outputs[0].pin, count, led_outputs[0].order); }
+void ConfigManager::setLedOutput(int index, int pin, int count, const String& order){
+    if (index < 0 || index >= LED_OUTPUTS) return;
+    if (pin < -1 || pin > 48) pin = -1;
+    if (count < 0) count = 0;
+    if (count > 300) count = 300;
+    String o = order;
+    o.toUpperCase();
+    if (o != "RGB" && o != "RBG" && o != "GRB" && o != "GBR" && o != "BRG" && o != "BGR") o = "GRB";
+    lockData();
+    led_outputs[index].pin = pin;
+    led_outputs[index].count = count;
+    led_outputs[index].order = o;
+    generation++;
+    unlockData();
 }
-void ConfigManager::setDriveAxisDeadband(int deadband){
-    if (deadband < 0) deadband = 0;
-    if (deadband > 256) deadband = 256;
-    drive_axis_deadband = deadband;
-}
-void ConfigManager::setMotorCurveType(const String& type){
-    if (type == "expo") {
-        motor_curve_type = "expo";
-    } else {
-        motor_curve_type = "linear";
-    }
-}
-void ConfigManager::setMotorCurveStrength(float strength){
-    if (strength < -0.8f) strength = -0.8f;
-    if (strength > 3.0f) strength = 3.0f;
-    motor_curve_strength = strength;
+void ConfigManager::setLedBrightness(int value){ storeNumber(CFG_F_led_brightness, 0, value); }
+void ConfigManager::setLedGamma(bool enabled){ storeBool(CFG_F_led_gamma, 0, enabled); }
+void ConfigManager::setLedPowerLimitMw(int milliwatts){ storeNumber(CFG_F_led_power_limit_mw, 0, milliwatts); }
+void ConfigManager::setWsInvertX(bool v){ storeBool(CFG_F_ws_invert_x, 0, v); }
+void ConfigManager::setWsInvertY(bool v){ storeBool(CFG_F_ws_invert_y, 0, v); }
+void ConfigManager::setWsSwapSides(bool v){ storeBool(CFG_F_ws_swap_sides, 0, v); }
+void ConfigManager::setBtInvertX(bool v){ storeBool(CFG_F_bt_invert_x, 0, v); }
+void ConfigManager::setBtInvertY(bool v){ storeBool(CFG_F_bt_invert_y, 0, v); }
+void ConfigManager::setBtSwapAxes(bool v){ storeBool(CFG_F_bt_swap_axes, 0, v); }
+void ConfigManager::setOTAEnabled(bool enabled){ storeBool(CFG_F_ota_enabled, 0, enabled); }
+void ConfigManager::setServoPulsewidthRange(int index, int min_pw, int max_pw){
+    if (index >= 0 && index < SERVO_COUNT) storeServo(index, min_pw, max_pw);
 }
+void ConfigManager::setMotorDeadband(int index, int val){ storeNumber(CFG_F_motor_deadband, index, val); }
+void ConfigManager::setMotorFrequency(int index, int val){ storeNumber(CFG_F_motor_frequency, index, val); }
+void ConfigManager::setDriveMixer(const String& mixer){ storeString(CFG_F_drive_mixer, 0, mixer.c_str()); }
+void ConfigManager::setDriveTurnGain(float gain){ storeNumber(CFG_F_drive_turn_gain, 0, gain); }
+void ConfigManager::setDriveAxisDeadband(int deadband){ storeNumber(CFG_F_drive_axis_deadband, 0, deadband); }
+void ConfigManager::setMotorCurveType(const String& type){ storeString(CFG_F_motor_curve_type, 0, type.c_str()); }
+void ConfigManager::setMotorCurveStrength(float strength){ storeNumber(CFG_F_motor_curve_strength, 0, strength); }
 
 // BT scan setters
-void ConfigManager::setBtScanOnNormal(int v)  { bt_scan_on_normal_ms  = v; }
-void ConfigManager::setBtScanOffNormal(int v) { bt_scan_off_normal_ms = v; }
-void ConfigManager::setBtScanOnSta(int v)     { bt_scan_on_sta_ms     = v; }
-void ConfigManager::setBtScanOffSta(int v)    { bt_scan_off_sta_ms    = v; }
-void ConfigManager::setBtScanOnAp(int v)      { bt_scan_on_ap_ms      = v; }
-void ConfigManager::setBtScanOffAp(int v)     { bt_scan_off_ap_ms     = v; }
-
+void ConfigManager::setBtScanOnNormal(int v)  { storeNumber(CFG_F_bt_scan_on_normal_ms, 0, v); }
+void ConfigManager::setBtScanOffNormal(int v) { storeNumber(CFG_F_bt_scan_off_normal_ms, 0, v); }
+void ConfigManager::setBtScanOnSta(int v)     { storeNumber(CFG_F_bt_scan_on_sta_ms, 0, v); }
+void ConfigManager::setBtScanOffSta(int v)    { storeNumber(CFG_F_bt_scan_off_sta_ms, 0, v); }
+void ConfigManager::setBtScanOnAp(int v)      { storeNumber(CFG_F_bt_scan_on_ap_ms, 0, v); }
+void ConfigManager::setBtScanOffAp(int v)     { storeNumber(CFG_F_bt_scan_off_ap_ms, 0, v); }
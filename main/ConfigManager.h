@@ -4,29 +4,87 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <LittleFS.h>
+#include <atomic>
 #include <vector>
+#include "ConfigSchema.h"
 
 class ConfigManager {
 public:
+    static const int LED_OUTPUTS = 4; // WS2812-Ausgänge; Ausgang 0 ist der bisherige Streifen (led_count)
+
     ConfigManager();
     bool init();
     bool loadConfig();
-    bool saveConfig();
+    bool saveConfig();   // sofort und synchron schreiben
     bool resetConfig();
 
+    // Gespeichert wird binär (CONFIG_BIN_PATH: Kopf mit Version und CRC32, danach MessagePack,
+    // Bindings als fertiger JSON-Text). JSON bleibt Austauschformat: ein /config.json auf LittleFS
+    // (z. B. frisch per uploadfs) wird beim Start einmal übernommen, Web-UI und Seriell exportieren
+    // und importieren darüber.
+    static constexpr const char* CONFIG_BIN_PATH = "/config.bin";
+    static constexpr const char* CONFIG_JSON_PATH = "/config.json";
+    void exportJson(JsonObject out);
+    // Derselbe Export als Text direkt nach out, ohne JsonDocument. Bindings kommen unverändert als
+    // gespeicherter Text. extraMembers: fertiges JSON ("key":wert,...), das mit ins Objekt kommt.
+    void exportJson(Print& out, const char* extraMembers = nullptr);
+    // Für Exporte in Stücken: nur exportieren, solange getGeneration() noch gen ist (sonst false).
+    // Meldet out einen Schreibfehler (getWriteError(), z. B. Sendepuffer voll), bricht der Export
+    // beim nächsten Feld ab.
+    bool exportJson(Print& out, const char* extraMembers, uint32_t gen);
+    // Zählt jede Änderung der Daten (unter dataMutex), auch ohne Speichern
+    uint32_t getGeneration() const { return generation.load(); }
+    void importJson(JsonObjectConst in);   // ersetzt die ganze Konfiguration, fehlende Felder = Standard
+    uint32_t getLoadUs() const { return loadUs; }
+    const char* getLoadSource() const { return loadSource; }
+
+    // Teiländerungen über das Schema (ConfigSchema.h): nur enthaltene Felder, ein Durchlauf über
+    // die Eingabe. Werte werden wie in den Settern begrenzt; nicht gespeichert (requestSave()).
+    struct ConfigChange {
+        uint16_t sections = 0;   // ConfigSection-Bits der tatsächlich geänderten Werte
+        uint16_t fields = 0;     // erkannte Felder
+    };
+    ConfigChange applyJson(JsonObjectConst in);
+    // /config-Formular: Werte als Text, Arrays als <key>_<i>; fehlende Checkboxen sind aus
+    struct FormField {
+        const char* name;
+        const char* value;
+    };
+    ConfigChange applyForm(const FormField* params, size_t count);
+    // Alle Einstellungen außer control_bindings und Whitelist (serielles get_config)
+    void exportFields(JsonObject out);
+
+    // Write-behind: Änderung nur vormerken und sofort zurückkehren. Der ConfigPersist-Task fasst
+    // Serien (Schieberegler, wiederholtes Umschalten) zusammen und schreibt die Datei einmal,
+    // sobald SAVE_DEBOUNCE_MS Ruhe herrscht, spätestens SAVE_MAX_DELAY_MS nach der ersten Änderung.
+    void requestSave();
+    // Vorgemerkte Änderungen jetzt schreiben; läuft auch automatisch bei jedem esp_restart()
+    bool flush();
+    bool hasPendingSave() const { return dirty.load(); }
+    uint32_t getSaveRequests() const { return saveRequests.load(); }
+    uint32_t getSaveWrites() const { return saveWrites.load(); }
+
     // Getter
     String getWifiMode();
     String getWifiSSID();
     String getWifiPassword();
     String getHotspotSSID();
     String getHotspotPassword();
+    String getWifiStaticIp();   // leer = DHCP
+    String getWifiGateway();
+    String getWifiNetmask();
+    String getWifiDns();        // leer = Gateway
     bool getMotorInvert(int index);
     bool getMotorSwap();
     int getMotorLeftGUI();
     int getMotorRightGUI();
-    int getLedCount();
+    int getLedCount(); // Ausgang 0
+    int getLedOutputPin(int index);   // -1 = Ausgang aus
+    int getLedOutputCount(int index);
+    String getLedOutputOrder(int index);
     int getLedBrightness();
     bool getLedGamma();
+    int getLedPowerLimitMw();
     bool getWsInvertX();
     bool getWsInvertY();
     bool getWsSwapSides();
@@ -53,6 +111,8 @@ public:
     int getBtScanOffSta();
     int getBtScanOnAp();
     int getBtScanOffAp();
+    bool getBtScanAdaptive() const { return bt_scan_policy == "adaptive"; }   // sonst "fixed"
+    int getBtReconnectMs() const { return bt_reconnect_ms; }   // 0 = verlorene Controller nicht zurückerwarten
 
     // Setter (aufgerufen wenn config-Seite geändert wird)
     void setWifiMode(const String &mode);
@@ -64,8 +124,10 @@ public:
     void setMotorInvert(int index, bool inv);
     void setMotorSwap(bool swap);
     void setLedCount(int count);
+    void setLedOutput(int index, int pin, int count, const String& order);
     void setLedBrightness(int value);
     void setLedGamma(bool enabled);
+    void setLedPowerLimitMw(int milliwatts);
     void setWsInvertX(bool v);
     void setWsInvertY(bool v);
     void setWsSwapSides(bool v);
@@ -98,65 +160,94 @@ public:
     const bool* getMotorInvertArray() { return motor_invert; }
     // Control bindings JSON (raw). Stored as JSON array/object string.
     String getControlBindingsJson() const { return control_bindings_json; }
-    void setControlBindingsJson(const String &json) { control_bindings_json = json; }
+    void setControlBindingsJson(const String &json) { lockData(); control_bindings_json = json; generation++; unlockData(); }
     static const char* getDefaultControlBindingsJson();
 
     // Bluetooth Whitelist
     bool getBtWhitelistEnabled() const { return bt_whitelist_enabled; }
     const std::vector<String>& getBtWhitelist() const { return bt_whitelist; }
-    void setBtWhitelistEnabled(bool enabled) { bt_whitelist_enabled = enabled; }
-    void setBtWhitelist(const std::vector<String>& addrs) { bt_whitelist = addrs; }
+    void setBtWhitelistEnabled(bool enabled) { lockData(); bt_whitelist_enabled = enabled; generation++; unlockData(); }
+    void setBtWhitelist(const std::vector<String>& addrs) { lockData(); bt_whitelist = addrs; generation++; unlockData(); }
 
 private:
-    bool motor_invert[4];
-    bool motor_swap;
-    int motor_deadband[4];
-    int motor_frequency[4];
-    int motorLeftGUI = 2;
-    int motorRightGUI = 3;
-    String wifi_mode;
-    String wifi_ssid;
-    String wifi_password;
-    String hotspot_ssid;
-    String hotspot_password;
-    int led_count;
-    int led_brightness = 50;   // 0..255 globale FastLED-Helligkeit
-    bool led_gamma = false;    // Gamma-Korrektur an/aus
-    // Website-Joystick-Steuerung (komplett unabhängig von den BT-Controller-Bindings)
-    bool ws_invert_x = false;
-    bool ws_invert_y = false;
-    bool ws_swap_sides = false;
-    // BT-Controller-Joystick (eigene Kalibrierung, unabhängig von Web)
-    bool bt_invert_x = false;
-    bool bt_invert_y = false;
-    bool bt_swap_axes = false;
-    bool ota_enabled;
+    static constexpr int SERVO_COUNT = 7;
+    static constexpr int SERVO_PW_MIN = 100;
+    static constexpr int SERVO_PW_MAX = 3000;
+
+    static constexpr uint32_t SAVE_DEBOUNCE_MS = 1000;
+    static constexpr uint32_t SAVE_MAX_DELAY_MS = 5000;
+
+    // dataMutex schützt Strings/Vektoren, solange saveConfig() sie ins Dokument kopiert (Setter
+    // laufen im AsyncTCP- oder loop-Task); saveMutex hält gleichzeitige Schreibvorgänge auseinander.
+    SemaphoreHandle_t dataMutex = xSemaphoreCreateRecursiveMutex();
+    SemaphoreHandle_t saveMutex = xSemaphoreCreateRecursiveMutex();
+    TaskHandle_t persistTask = nullptr;
+    std::atomic<bool> dirty{false};
+    std::atomic<uint32_t> saveRequests{0};
+    std::atomic<uint32_t> saveWrites{0};
+    std::atomic<uint32_t> generation{0};
+
+    void lockData() { xSemaphoreTakeRecursive(dataMutex, portMAX_DELAY); }
+    void unlockData() { xSemaphoreGiveRecursive(dataMutex); }
+    void persistLoop();
+    static void flushOnShutdown();
+
+    static constexpr uint32_t CONFIG_BIN_MAGIC = 0x46435454; // "TTCF"
+    static constexpr uint16_t CONFIG_BIN_VERSION = 1;
+    struct BinHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t headerSize;
+        uint32_t payloadLen;
+        uint32_t crc;   // CRC32 über die Nutzdaten
+    };
+    uint32_t loadUs = 0;
+    const char* loadSource = "defaults";
+
+    bool loadBinary();
+    bool loadJsonFile();
+    bool writeBinary(JsonDocument& doc);
+    ConfigChange applyDocument(JsonObjectConst doc, bool rawBindings);
+    void fillDocument(JsonObject doc, bool rawBindings);
+    void fillFields(JsonObject doc);
+
+    // Schema-Zugriff; Strings nur unter lockData() schreiben
+    static int findField(const char* key, size_t len);
+    template<typename V> V& fieldRef(int id, int index) { return static_cast<V*>(fieldPtr[id])[index]; }
+    uint16_t storeBool(int id, int index, bool value);
+    uint16_t storeNumber(int id, int index, float value);
+    uint16_t storeString(int id, int index, const char* value);
+    uint16_t storeText(int id, int index, const char* text);
+    uint16_t storeVariant(int id, int index, JsonVariantConst value);
+    void writeField(JsonVariant out, int id, int index);
+    void printField(Print& out, int id, int index);
+    void printExport(Print& out, const char* extraMembers);
+    uint16_t storeLedOutput(int index, int pin, int count, const String& order);
+    uint16_t storeServo(int index, int min_pw, int max_pw);
+
+    TT_CONFIG_FIELDS(CFG_FIELD_MEMBER)
+
+    struct LedOutputConfig {
+        int pin;
+        int count;
+        String order; // "GRB", "RGB", ...
+    };
+    LedOutputConfig led_outputs[LED_OUTPUTS];
 
     struct ServoConfig {
         int min_pw;
         int max_pw;
     };
-    ServoConfig servos[7];
-
-    String drive_mixer = "arcade";
-    float drive_turn_gain = 1.0f;
-    int drive_axis_deadband = 16;
-    String motor_curve_type = "linear";
-    float motor_curve_strength = 0.0f;
-
-    // Bluetooth scan duty-cycle settings
-    int bt_scan_on_normal_ms = 500;
-    int bt_scan_off_normal_ms = 500;
-    int bt_scan_on_sta_ms = 150;
-    int bt_scan_off_sta_ms = 850;
-    int bt_scan_on_ap_ms = 100;
-    int bt_scan_off_ap_ms = 1900;
+    ServoConfig servos[SERVO_COUNT];
 
     String control_bindings_json; // raw JSON string for control mappings
 
-    bool bt_whitelist_enabled = false;
     std::vector<String> bt_whitelist;
 
+#define CFG_FIELD_PTR(T, key, ...) (void*)&key,
+    void* const fieldPtr[CONFIG_FIELD_COUNT] = { TT_CONFIG_FIELDS(CFG_FIELD_PTR) };
+#undef CFG_FIELD_PTR
+
     void setDefaults();
 };
 
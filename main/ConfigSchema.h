@@ -0,0 +1,122 @@
+#ifndef CONFIG_SCHEMA_H
+#define CONFIG_SCHEMA_H
+
+#include <Arduino.h>
+
+// Abschnitte einer Änderung: der Aufrufer entscheidet daran, was danach zu tun ist
+enum ConfigSection : uint16_t {
+    CFG_WIFI     = 1 << 0,   // wirkt erst nach einem Neustart
+    CFG_MOTOR    = 1 << 1,
+    CFG_LED      = 1 << 2,
+    CFG_DRIVE    = 1 << 3,
+    CFG_SERVO    = 1 << 4,
+    CFG_INPUT    = 1 << 5,   // Joystick-Kalibrierung Web/BT, wird bei jeder Eingabe gelesen
+    CFG_BT       = 1 << 6,   // Scan-Timing, Whitelist
+    CFG_SYSTEM   = 1 << 7,
+    CFG_BINDINGS = 1 << 8,
+};
+static constexpr uint16_t CFG_REBOOT = CFG_WIFI;
+static constexpr uint16_t CFG_HARDWARE = CFG_MOTOR | CFG_LED | CFG_DRIVE | CFG_SERVO; // -> reApplyConfig()
+
+enum ConfigFieldType : uint8_t { CFG_BOOL, CFG_INT, CFG_FLOAT, CFG_STR, CFG_ENUM };
+
+enum ConfigFieldFlags : uint8_t {
+    CF_TRIM     = 1 << 0,   // Leerzeichen am Rand entfernen
+    CF_NONEMPTY = 1 << 1,   // leerer Text wird ignoriert
+    CF_CHECKBOX = 1 << 2,   // Formular: fehlt das Feld, ist die Checkbox aus
+};
+
+// Alle einfachen Einstellungen an einer Stelle. Daraus entstehen die Member von ConfigManager,
+// Standardwerte, Laden/Speichern, Export, /config-Formular und serielles get/set_config.
+//   Schlüssel = Membername = JSON-Key; Anzahl > 1 ist ein Array (Formular: <key>_<i>)
+//   INT/FLOAT: Werte werden auf Min..Max begrenzt; STR: Max = maximale Länge
+//   ENUM: Standard = "a|b|c", erlaubte Werte, der erste ist Standard und Ersatz für Unbekanntes
+// Zusammengesetztes (led_outputs, servo_settings, control_bindings, bt_whitelist) bleibt handgeschrieben.
+#define TT_CONFIG_FIELDS(X) \
+    /* Typ   Schlüssel             Anz Min    Max     Standard            Abschnitt  Flags */ \
+    X(ENUM,  wifi_mode,             1, 0,     0,      "AP|STA",           WIFI,      0) \
+    X(STR,   wifi_ssid,             1, 0,     32,     "fablab",           WIFI,      CF_TRIM) \
+    X(STR,   wifi_password,         1, 0,     64,     "fablabfdm",        WIFI,      CF_TRIM) \
+    X(STR,   hotspot_ssid,          1, 0,     32,     "TinkerThinkerAP",  WIFI,      CF_TRIM | CF_NONEMPTY) \
+    X(STR,   hotspot_password,      1, 0,     64,     "",                 WIFI,      0) \
+    X(STR,   wifi_static_ip,        1, 0,     15,     "",                 WIFI,      CF_TRIM) \
+    X(STR,   wifi_gateway,          1, 0,     15,     "",                 WIFI,      CF_TRIM) \
+    X(STR,   wifi_netmask,          1, 0,     15,     "255.255.255.0",    WIFI,      CF_TRIM | CF_NONEMPTY) \
+    X(STR,   wifi_dns,              1, 0,     15,     "",                 WIFI,      CF_TRIM) \
+    X(BOOL,  motor_invert,          4, 0,     1,      false,              MOTOR,     CF_CHECKBOX) \
+    X(BOOL,  motor_swap,            1, 0,     1,      false,              MOTOR,     CF_CHECKBOX) \
+    X(INT,   motor_deadband,        4, 0,     255,    50,                 MOTOR,     0) \
+    X(INT,   motor_frequency,       4, 100,   100000, 5000,               MOTOR,     0) \
+    X(INT,   motor_left_gui,        1, 0,     3,      2,                  MOTOR,     0) \
+    X(INT,   motor_right_gui,       1, 0,     3,      3,                  MOTOR,     0) \
+    X(INT,   led_brightness,        1, 0,     255,    50,                 LED,       0) \
+    X(BOOL,  led_gamma,             1, 0,     1,      false,              LED,       0) \
+    X(INT,   led_power_limit_mw,    1, 0,     50000,  2500,               LED,       0) \
+    X(BOOL,  ws_invert_x,           1, 0,     1,      false,              INPUT,     0) \
+    X(BOOL,  ws_invert_y,           1, 0,     1,      false,              INPUT,     0) \
+    X(BOOL,  ws_swap_sides,         1, 0,     1,      false,              INPUT,     0) \
+    X(BOOL,  bt_invert_x,           1, 0,     1,      false,              INPUT,     0) \
+    X(BOOL,  bt_invert_y,           1, 0,     1,      false,              INPUT,     0) \
+    X(BOOL,  bt_swap_axes,          1, 0,     1,      false,              INPUT,     0) \
+    X(BOOL,  ota_enabled,           1, 0,     1,      false,              SYSTEM,    CF_CHECKBOX) \
+    X(ENUM,  drive_mixer,           1, 0,     0,      "arcade|tank",      DRIVE,     0) \
+    X(FLOAT, drive_turn_gain,       1, 0,     2.5,    1.0,                DRIVE,     0) \
+    X(INT,   drive_axis_deadband,   1, 0,     256,    16,                 DRIVE,     0) \
+    X(ENUM,  motor_curve_type,      1, 0,     0,      "linear|expo",      DRIVE,     0) \
+    X(FLOAT, motor_curve_strength,  1, -0.8,  3.0,    0.0,                DRIVE,     0) \
+    X(INT,   bt_scan_on_normal_ms,  1, 0,     5000,   500,                BT,        0) \
+    X(INT,   bt_scan_off_normal_ms, 1, 0,     5000,   500,                BT,        0) \
+    X(INT,   bt_scan_on_sta_ms,     1, 0,     5000,   150,                BT,        0) \
+    X(INT,   bt_scan_off_sta_ms,    1, 0,     5000,   850,                BT,        0) \
+    X(INT,   bt_scan_on_ap_ms,      1, 0,     5000,   100,                BT,        0) \
+    X(INT,   bt_scan_off_ap_ms,     1, 0,     5000,   1900,               BT,        0) \
+    X(ENUM,  bt_scan_policy,        1, 0,     0,      "fixed|adaptive",   BT,        0) \
+    X(INT,   bt_reconnect_ms,       1, 0,     60000,  15000,              BT,        0) \
+    X(BOOL,  bt_whitelist_enabled,  1, 0,     1,      false,              BT,        0)
+
+// FNV-1a; für die Tabelle zur Compile-Zeit, beim Import einmal je Schlüssel
+constexpr uint32_t configKeyHash(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+struct ConfigField {
+    const char* key;
+    uint32_t hash;
+    ConfigFieldType type;
+    uint8_t count;
+    uint8_t flags;
+    uint16_t section;
+    float min, max;
+    float defNum;
+    const char* defStr;   // STR: Standard; ENUM: erlaubte Werte
+};
+
+enum ConfigFieldId : uint8_t {
+#define CFG_FIELD_ID(T, key, ...) CFG_F_##key,
+    TT_CONFIG_FIELDS(CFG_FIELD_ID)
+#undef CFG_FIELD_ID
+    CONFIG_FIELD_COUNT
+};
+
+extern const ConfigField CONFIG_FIELDS[CONFIG_FIELD_COUNT];
+
+// Speichertyp eines Felds: bool/int/float/String, bei Anzahl > 1 als Array
+template<ConfigFieldType T> struct ConfigValueType;
+template<> struct ConfigValueType<CFG_BOOL>  { typedef bool type; };
+template<> struct ConfigValueType<CFG_INT>   { typedef int type; };
+template<> struct ConfigValueType<CFG_FLOAT> { typedef float type; };
+template<> struct ConfigValueType<CFG_STR>   { typedef String type; };
+template<> struct ConfigValueType<CFG_ENUM>  { typedef String type; };
+
+template<typename V, int N> struct ConfigStorage { typedef V type[N]; };
+template<typename V> struct ConfigStorage<V, 1> { typedef V type; };
+
+#define CFG_FIELD_MEMBER(T, key, count, ...) \
+    ConfigStorage<ConfigValueType<CFG_##T>::type, count>::type key;
+
+#endif
@@ -81,13 +81,17 @@ void InputBindingManager::applyAction(JsonObject action, ControllerPtr ctl) {
         board->setServoAngle(idx, board->getServoAngle(idx) + delta);
     } else if (!strcmp(type, "led_set")) {
         const char* color = action["color"] | "#000000";
+        int output = action["output"] | -1; // -1: start ist globaler Index über alle Ausgänge
         int start = action["start"] | 0;
         int count = action["count"] | 1;
         long rgb = strtol(color+1, nullptr, 16);
         uint8_t r = (rgb >> 16) & 0xFF;
         uint8_t g = (rgb >> 8) & 0xFF;
         uint8_t b = (rgb) & 0xFF;
-        for (int i= start; i< start+count; ++i) board->setLED(i, r,g,b);
+        for (int i= start; i< start+count; ++i) {
+            if (output >= 0) board->setOutputLED(output, i, r,g,b);
+            else board->setLED(i, r,g,b);
+        }
         board->showLEDs();
     } else if (!strcmp(type, "gpio_set")) {
         int pin = action["pin"] | -1;
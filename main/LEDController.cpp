@@ -1,44 +1,281 @@
 #include "LEDController.h"
+#include "driver/gpio.h"
+#include "platforms/esp/32/rmt_5/idf5_rmt.h"
 
-LEDController::LEDController(int count)
-: ledCount(count) 
-{
-    ledsArray = new CRGB[ledCount];
+#if !FASTLED_RMT5
+#error "LEDController benötigt den FastLED-RMT5-Treiber (ESP-IDF 5)"
+#endif
+
+// WS2812-Ausgang mit Pin und Farbreihenfolge aus der Config. FastLEDs ClocklessController
+// erwartet beides als Template-Parameter, deshalb wird RmtController5 hier direkt benutzt.
+class LEDOutput : public CLEDController {
+public:
+    ~LEDOutput() { delete rmt; }
+
+    void configure(int pin, EOrder colorOrder) {
+        if (!rmt || pin != rmtPin) {
+            delete rmt; // wartet auf eine laufende Übertragung und gibt den RMT-Kanal frei
+            rmt = new RmtController5(pin,
+                C_NS_WS2812(FASTLED_WS2812_T1), C_NS_WS2812(FASTLED_WS2812_T2), C_NS_WS2812(FASTLED_WS2812_T3),
+                RmtController5::DMA_AUTO);
+            rmtPin = pin;
+        }
+        order = colorOrder;
+        setEnabled(true);
+    }
+
+    void release() {
+        setEnabled(false);
+        delete rmt;
+        rmt = nullptr;
+        rmtPin = -1;
+        loaded = false;
+    }
+
+    void init() override {}
+
+    void showColor(const CRGB& data, int nLeds, uint8_t brightness) override {
+        load(&data, nLeds, brightness, true);
+    }
+
+    void show(const CRGB* data, int nLeds, uint8_t brightness) override {
+        load(data, nLeds, brightness, false);
+    }
+
+    void endShowLeds(void* data) override {
+        CLEDController::endShowLeds(data);
+        // FastLED lädt erst alle Controller und startet dann nacheinander die Übertragungen;
+        // mit FASTLED_RMT5_ASYNC_SHOW laufen die RMT-Kanäle dadurch parallel.
+        if (loaded) rmt->showPixels();
+        loaded = false;
+    }
+
+private:
+    RmtController5* rmt = nullptr;
+    int rmtPin = -1;
+    EOrder order = GRB;
+    bool loaded = false;
+
+    template <EOrder ORDER>
+    void loadAs(const CRGB* data, int nLeds, uint8_t brightness, bool solid) {
+        PixelController<ORDER> pixels(data, nLeds < 0 ? -nLeds : nLeds, getAdjustmentData(brightness), getDither());
+        if (solid) pixels.mAdvance = 0;
+        else if (nLeds < 0) pixels.mAdvance = -pixels.mAdvance;
+        PixelIterator it = pixels.as_iterator(getRgbw());
+        rmt->loadPixelData(it);
+    }
+
+    void load(const CRGB* data, int nLeds, uint8_t brightness, bool solid) {
+        if (!rmt || nLeds == 0) return;
+        switch (order) {
+            case RGB: loadAs<RGB>(data, nLeds, brightness, solid); break;
+            case RBG: loadAs<RBG>(data, nLeds, brightness, solid); break;
+            case GBR: loadAs<GBR>(data, nLeds, brightness, solid); break;
+            case BRG: loadAs<BRG>(data, nLeds, brightness, solid); break;
+            case BGR: loadAs<BGR>(data, nLeds, brightness, solid); break;
+            default:  loadAs<GRB>(data, nLeds, brightness, solid); break;
+        }
+        loaded = true;
+    }
+};
+
+LEDController::LEDController() {
+    for (int i = 0; i < LED_MAX_COUNT; i++) ledsArray[i] = CRGB::Black;
 }
 
-void LEDController::init() {
-    FastLED.addLeds<WS2812, 2, GRB>(ledsArray, ledCount).setCorrection(TypicalLEDStrip);
-    FastLED.clear();
-    FastLED.show();
+void LEDController::configureOutputs(const LEDOutputConfig* cfg, int count) {
+    // Unter dem Lock: configure()/release() löschen RMT-Kanäle, die sonst gerade ein anderer
+    // Task in showPixels() benutzen könnte
+    lock();
+    configureOutputsLocked(cfg, count);
+    unlock();
+}
+
+void LEDController::reservePin(int pin, const char* owner) {
+    if (pin < 0 || reservedCount >= MAX_RESERVED_PINS) return;
+    lock();
+    reserved[reservedCount++] = {pin, owner};
+    unlock();
+}
+
+void LEDController::configureOutputsLocked(const LEDOutputConfig* cfg, int count) {
+    LEDOutputConfig next[LED_MAX_OUTPUTS];
+    int total = 0;
+    for (int i = 0; i < LED_MAX_OUTPUTS && i < count; i++) {
+        LEDOutputConfig c = cfg[i];
+        if (c.pin >= 0 && !isValidOutputPin(c.pin)) {
+            Serial.printf("LED output %d: GPIO%d cannot drive LEDs, output disabled\n", i, c.pin);
+            c.pin = -1;
+        }
+        for (int k = 0; k < reservedCount && c.pin >= 0; k++) {
+            if (reserved[k].pin == c.pin) {
+                Serial.printf("LED output %d: GPIO%d already used by %s, output disabled\n", i, c.pin, reserved[k].owner);
+                c.pin = -1;
+            }
+        }
+        for (int k = 0; k < i && c.pin >= 0; k++) {
+            if (next[k].pin == c.pin) {
+                Serial.printf("LED output %d: GPIO%d already used by output %d, output disabled\n", i, c.pin, k);
+                c.pin = -1;
+            }
+        }
+        if (c.pin >= 0 && total + c.count > LED_MAX_COUNT) {
+            Serial.printf("LED outputs exceed LED_MAX_COUNT (%d), output %d truncated\n", LED_MAX_COUNT, i);
+            c.count = LED_MAX_COUNT - total;
+        }
+        if (c.pin < 0 || c.count <= 0) {
+            c.pin = -1;
+            c.count = 0;
+        }
+        total += c.count;
+        next[i] = c;
+    }
+
+    bool changed = false;
+    for (int i = 0; i < LED_MAX_OUTPUTS; i++) {
+        if (next[i].pin != active[i].pin || next[i].count != active[i].count || next[i].order != active[i].order) {
+            changed = true;
+        }
+    }
+    if (!changed) return;
+
+    // Alte Belegung einmal dunkel schalten – danach verschieben sich die Bereiche im Puffer
+    if (ledCount > 0) {
+        for (int i = 0; i < ledCount; i++) ledsArray[i] = CRGB::Black;
+        FastLED.show();
+    }
+
+    int start = 0;
+    for (int i = 0; i < LED_MAX_OUTPUTS; i++) {
+        const LEDOutputConfig& c = next[i];
+        outputStart[i] = start;
+        outputLen[i] = c.count;
+        if (c.pin < 0) {
+            if (outputs[i]) outputs[i]->release();
+        } else {
+            // FastLED kennt kein Entfernen von Controllern: ein Objekt pro Ausgang, einmal registriert
+            if (!outputs[i]) {
+                outputs[i] = new LEDOutput();
+                FastLED.addLeds(outputs[i], ledsArray + start, c.count).setCorrection(TypicalLEDStrip);
+            }
+            outputs[i]->configure(c.pin, c.order);
+            outputs[i]->setLeds(ledsArray + start, c.count);
+            Serial.printf("LED output %d: GPIO%d, %d LEDs at %d\n", i, c.pin, c.count, start);
+        }
+        start += c.count;
+        active[i] = c;
+    }
+    ledCount = start;
+}
+
+int LEDController::getOutputCount(int output) const {
+    return (output >= 0 && output < LED_MAX_OUTPUTS) ? outputLen[output] : 0;
+}
+
+int LEDController::getOutputStart(int output) const {
+    return (output >= 0 && output < LED_MAX_OUTPUTS) ? outputStart[output] : 0;
+}
+
+EOrder LEDController::parseColorOrder(const char* name) {
+    if (!name) return GRB;
+    if (!strcasecmp(name, "RGB")) return RGB;
+    if (!strcasecmp(name, "RBG")) return RBG;
+    if (!strcasecmp(name, "GBR")) return GBR;
+    if (!strcasecmp(name, "BRG")) return BRG;
+    if (!strcasecmp(name, "BGR")) return BGR;
+    return GRB;
+}
+
+bool LEDController::isValidOutputPin(int pin) {
+    return pin >= 0 && GPIO_IS_VALID_OUTPUT_GPIO(pin);
 }
 
 void LEDController::setPixelColor(int led, uint8_t red, uint8_t green, uint8_t blue) {
+    lock();
     if (led < 0 || led >= ledCount) {
+        unlock();
         Serial.printf("LED index out of range: %d\n", led);
         return;
     }
     CRGB c(red, green, blue);
     if (gammaEnabled) napplyGamma_video(c, 2.2f); // freie FastLED-Funktion (CRGB hat keinen Member)
     ledsArray[led] = c;
+    unlock();
+}
+
+void LEDController::setPixelColor(int output, int led, uint8_t red, uint8_t green, uint8_t blue) {
+    lock();
+    if (output < 0 || output >= LED_MAX_OUTPUTS || led < 0 || led >= outputLen[output]) {
+        unlock();
+        Serial.printf("LED index out of range: output %d, led %d\n", output, led);
+        return;
+    }
+    setPixelColor(outputStart[output] + led, red, green, blue);
+    unlock();
 }
 
 void LEDController::showPixels() {
+    // Unter dem Lock: der asynchrone RMT-Treiber darf tx_buf nicht überschreiben, während ein
+    // anderer Task seinen Frame noch startet
+    lock();
+    // FastLED-Strommodell (mW bei voller Helligkeit) über den aktuellen Frame aller Ausgänge
+    uint32_t unscaledMw = calculate_unscaled_power_mW(ledsArray, (uint16_t)ledCount);
+    uint32_t requestedMw = (unscaledMw * userBrightness) / 256;
+    uint8_t brightness = userBrightness;
+    if (powerBudgetMw > 0 && requestedMw > powerBudgetMw) {
+        brightness = (uint8_t)(((uint32_t)userBrightness * powerBudgetMw) / requestedMw);
+    }
+    appliedBrightness = brightness;
+    estimatedMw = (unscaledMw * brightness) / 256;
+    FastLED.setBrightness(brightness);
+    // Mit asynchronem RMT5-Treiber kehrt show() nach dem Start der Übertragung zurück;
+    // blockiert wird nur, solange der vorherige Frame noch auf der Leitung ist.
+    uint32_t t0 = micros();
     FastLED.show();
+    uint32_t dt = micros() - t0;
+    lastShowUs = dt;
+    if (dt > maxShowUs) maxShowUs = dt;
+    unlock();
+}
+
+uint32_t LEDController::takeMaxShowMicros() {
+    uint32_t m = maxShowUs;
+    maxShowUs = 0;
+    return m;
 }
 
 CRGB LEDController::getLEDColor(int ledIndex) {
+    lock();
     if (ledIndex < 0 || ledIndex >= ledCount) {
+        unlock();
         Serial.printf("LED index out of range: %d\n", ledIndex);
         return CRGB::Black;
     }
-    return ledsArray[ledIndex];
+    CRGB c = ledsArray[ledIndex];
+    unlock();
+    return c;
+}
+
+void LEDController::setPowerBudget(uint32_t milliwatts) {
+    lock();
+    if (milliwatts != powerBudgetMw) {
+        bool limitedNow = appliedBrightness < userBrightness;
+        powerBudgetMw = milliwatts;
+        // Stehendes Bild neu skalieren, wenn sich die Begrenzung auswirkt
+        if (limitedNow || (milliwatts > 0 && estimatedMw > milliwatts)) showPixels();
+    }
+    unlock();
 }
 
 void LEDController::setBrightness(uint8_t value) {
-    FastLED.setBrightness(value);
-    FastLED.show();
+    lock();
+    userBrightness = value;
+    showPixels();
+    unlock();
 }
 
 void LEDController::setGamma(bool enabled) {
+    lock();
     gammaEnabled = enabled;
+    unlock();
 }
@@ -4,21 +4,87 @@
 #include <Arduino.h>
 #include <FastLED.h>
 
+// Maximale Gesamtlänge aller Ausgänge; der Pixelpuffer wird einmalig in dieser Größe angelegt.
+#ifndef LED_MAX_COUNT
+#define LED_MAX_COUNT 300
+#endif
+
+// Unabhängige WS2812-Ausgänge, je ein eigener RMT-Kanal
+#ifndef LED_MAX_OUTPUTS
+#define LED_MAX_OUTPUTS 4
+#endif
+
+class LEDOutput;
+
+struct LEDOutputConfig {
+    int pin = -1;        // -1 = Ausgang aus
+    int count = 0;
+    EOrder order = GRB;
+};
+
 class LEDController {
 public:
-    LEDController(int ledCount); // Neuer Konstruktor mit Parameter
-    void init();
+    LEDController();
+    // Ausgänge (neu) konfigurieren. Die Ausgänge liegen hintereinander im Pixelpuffer,
+    // globale Indizes (Stream, Vorschau) laufen über alle Ausgänge.
+    void configureOutputs(const LEDOutputConfig* outputs, int count);
+    // GPIOs anderer Aktoren (Motor, Servo, ...). Ein Ausgang auf einem davon wird wie ein doppelt
+    // belegter Pin abgeschaltet. owner: fester Text für die Logzeile. Vor configureOutputs() aufrufen.
+    void reservePin(int pin, const char* owner);
     void setPixelColor(int led, uint8_t red, uint8_t green, uint8_t blue);
+    void setPixelColor(int output, int led, uint8_t red, uint8_t green, uint8_t blue);
     void showPixels();
+    // Pixelpuffer, FastLED.show() und die RMT-Ausgänge werden aus LEDStreamTask, TelemetryTask
+    // (Leistungsbudget), AsyncTCP und loop() benutzt. Alle Methoden, die schreiben oder anzeigen,
+    // nehmen diesen Lock; wer direkt in getPixelBuffer() zeichnet, klammert selbst. Rekursiv, weil
+    // z. B. setBrightness() selbst showPixels() aufruft.
+    void lock() { xSemaphoreTakeRecursive(mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGiveRecursive(mutex); }
     CRGB getLEDColor(int ledIndex);
     void setBrightness(uint8_t value);
     void setGamma(bool enabled);
+    CRGB* getPixelBuffer() { return ledsArray; }
+    int getLedCount() const { return ledCount; }
+    int getOutputCount(int output) const;
+    int getOutputStart(int output) const;
+
+    static EOrder parseColorOrder(const char* name);
+    static bool isValidOutputPin(int pin);
+
+    // Leistungsbudget in mW (0 = unbegrenzt); showPixels() senkt die Helligkeit bei Bedarf ab
+    void setPowerBudget(uint32_t milliwatts);
+    uint32_t getPowerBudget() const { return powerBudgetMw; }
+    uint32_t getEstimatedPower() const { return estimatedMw; }
+    uint8_t getAppliedBrightness() const { return appliedBrightness; }
+
+    // Wie lange FastLED.show() den Aufrufer blockiert hat (µs); Maximum wird beim Lesen zurückgesetzt
+    uint32_t getLastShowMicros() const { return lastShowUs; }
+    uint32_t takeMaxShowMicros();
 
 private:
-    int ledCount;
-    CRGB* ledsArray; // Dynamisches Array
-    int dataPin = 2; // Standarddatenpin, ggf. anpassen oder aus Config laden
+    int ledCount = 0;              // Summe aller aktiven Ausgänge
+    CRGB ledsArray[LED_MAX_COUNT]; // Fester Puffer, Ausgang i belegt [outputStart[i], +outputLen[i])
+    LEDOutput* outputs[LED_MAX_OUTPUTS] = {};
+    LEDOutputConfig active[LED_MAX_OUTPUTS];
+    static const int MAX_RESERVED_PINS = 24;
+    struct ReservedPin {
+        int pin;
+        const char* owner;
+    };
+    ReservedPin reserved[MAX_RESERVED_PINS];
+    int reservedCount = 0;
+    int outputStart[LED_MAX_OUTPUTS] = {};
+    int outputLen[LED_MAX_OUTPUTS] = {};
     bool gammaEnabled = false;
+    uint8_t userBrightness = 255;     // gewünschte Helligkeit (Config/Vorschau)
+    uint8_t appliedBrightness = 255;  // nach Leistungsbudget tatsächlich gesetzt
+    uint32_t powerBudgetMw = 0;
+    uint32_t estimatedMw = 0;
+    volatile uint32_t lastShowUs = 0;
+    volatile uint32_t maxShowUs = 0;
+    SemaphoreHandle_t mutex = xSemaphoreCreateRecursiveMutex();
+
+    void configureOutputsLocked(const LEDOutputConfig* outputs, int count);
 };
 
 #endif
@@ -0,0 +1,238 @@
+#include "LEDFrameStream.h"
+#include "LEDController.h"
+
+void LEDFrameStream::attach(LEDController* target) {
+    if (!mutex) mutex = xSemaphoreCreateMutex();
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    end();
+    leds = target;
+    xSemaphoreGive(mutex);
+}
+
+void LEDFrameStream::begin(uint8_t sourceFps, uint32_t nowMs) {
+    end();
+    pixelCount = leds->getLedCount();
+    fps = sourceFps;
+    decoded.assign(pixelCount, CRGB::Black);
+    ring = fl::ByteStreamMemoryPtr::New(RING_FRAMES * pixelCount * 3);
+    pixels = fl::PixelStreamPtr::New((int)(pixelCount * 3));
+    pixels->beginStream(ring);
+    interpolator = fl::FrameInterpolatorPtr::New(PREBUFFER_FRAMES + 1, (float)fps);
+    scratch = fl::FramePtr::New((int)pixelCount);
+    ringHead = 0;
+    ringCount = 0;
+    active = true;
+    starved = true;   // Uhr wird mit dem ersten Frame verankert
+    synced = false;
+    lastRxMs = nowMs;
+    lastMissedFrame = UINT32_MAX;
+    stats.active = true;
+    stats.fps = fps;
+    Serial.printf("LEDFrameStream: start %u px @ %u fps\n", (unsigned)pixelCount, (unsigned)fps);
+}
+
+void LEDFrameStream::end() {
+    if (active) {
+        Serial.printf("LEDFrameStream: stop (rx=%u underruns=%u late=%u dropped=%u)\n",
+            (unsigned)stats.received, (unsigned)stats.underruns, (unsigned)stats.late, (unsigned)stats.dropped);
+    }
+    active = false;
+    if (pixels) pixels->close();
+    pixels.reset();
+    ring.reset();
+    interpolator.reset();
+    scratch.reset();
+    ringHead = 0;
+    ringCount = 0;
+    stats.active = false;
+    stats.buffered = 0;
+}
+
+bool LEDFrameStream::handleFrame(const uint8_t* data, size_t len) {
+    if (!mutex || !data || len < HEADER_SIZE || data[0] != MSG_TYPE) return false;
+    Encoding enc = (Encoding)data[1];
+    uint8_t sourceFps = data[2];
+    uint16_t seq = (uint16_t)(data[4] | (data[5] << 8));
+    size_t count = (size_t)(data[6] | (data[7] << 8));
+    uint32_t now = millis();
+
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(20)) != pdTRUE) return false;
+
+    if (!leds || leds->getLedCount() <= 0 || sourceFps == 0 || sourceFps > 120) {
+        stats.invalid++;
+        xSemaphoreGive(mutex);
+        return false;
+    }
+    if (!active || sourceFps != fps) {
+        begin(sourceFps, now);
+    }
+
+    uint32_t frameNumber = 0;
+    if (synced) {
+        int16_t step = (int16_t)(seq - lastSeq);
+        if (step <= 0) {
+            // Duplikat oder vertauschte Reihenfolge – Abspielzeitpunkt ist vorbei
+            stats.late++;
+            xSemaphoreGive(mutex);
+            return false;
+        }
+        frameNumber = lastFrameNumber + step;
+    }
+
+    if (!decode(enc, data + HEADER_SIZE, len - HEADER_SIZE, count)) {
+        stats.invalid++;
+        xSemaphoreGive(mutex);
+        return false;
+    }
+    synced = true;
+    lastSeq = seq;
+    lastFrameNumber = frameNumber;
+    lastRxMs = now;
+    stats.received++;
+
+    if (starved) {
+        // Nach Start oder Unterlauf: Uhr so verankern, dass dieser Frame nach dem Vorpuffer erscheint
+        uint32_t prebufferMs = (uint32_t)(PREBUFFER_FRAMES * 1000UL) / fps;
+        startMs = now + prebufferMs - interpolator->get_exact_timestamp_ms(frameNumber);
+        starved = false;
+    } else if ((int32_t)(now - startMs) >= 0) {
+        uint32_t cur, next;
+        interpolator->getFrameTracker().get_interval_frames(now - startMs, &cur, &next);
+        if (frameNumber < cur) {
+            stats.late++;
+            xSemaphoreGive(mutex);
+            return false;
+        }
+    }
+
+    if (ringCount == RING_FRAMES) {
+        discardOldest();
+        stats.dropped++;
+    }
+    ring->writeCRGB(decoded.data(), pixelCount);
+    ringFrameNumbers[(ringHead + ringCount) % RING_FRAMES] = frameNumber;
+    ringCount++;
+
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+void LEDFrameStream::tick(uint32_t nowMs) {
+    if (!mutex) return;
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(5)) != pdTRUE) return;
+    if (!active) {
+        xSemaphoreGive(mutex);
+        return;
+    }
+    if (ringCount == 0 && (nowMs - lastRxMs) > IDLE_TIMEOUT_MS) {
+        // Quelle schweigt: Stream beenden, letztes Bild bleibt stehen
+        end();
+        xSemaphoreGive(mutex);
+        return;
+    }
+    int32_t t = (int32_t)(nowMs - startMs);
+    if (starved || t < 0) {
+        xSemaphoreGive(mutex);
+        return;
+    }
+
+    uint32_t cur, next;
+    interpolator->getFrameTracker().get_interval_frames((uint32_t)t, &cur, &next);
+
+    // Frames aus dem Ring in den Interpolator übernehmen, bis der nächste Frame da ist
+    while (ringCount > 0 && ringFrameNumbers[ringHead] <= next) {
+        uint32_t fn = ringFrameNumbers[ringHead];
+        if (fn < cur) {
+            discardOldest();
+            stats.late++;
+            continue;
+        }
+        fl::FramePtr frame;
+        uint32_t oldest;
+        if (interpolator->full() && interpolator->get_oldest_frame_number(&oldest)) {
+            frame = interpolator->erase(oldest);   // Frame-Speicher wiederverwenden
+        }
+        if (!frame) frame = fl::FramePtr::New((int)pixelCount);
+        pixels->readFrame(frame.get());
+        ringHead = (ringHead + 1) % RING_FRAMES;
+        ringCount--;
+        interpolator->insert(fn, frame);
+    }
+
+    LEDController* target = leds;
+    // Zeichnen und Anzeigen unter dem LED-Lock (Reihenfolge: Stream-Mutex, dann LED-Lock)
+    target->lock();
+    bool drawn = interpolator->has(cur) && interpolator->draw((uint32_t)t, target->getPixelBuffer());
+    if (!drawn) {
+        // Letztes Bild halten; jeden fehlenden Frame nur einmal zählen
+        if (cur != lastMissedFrame) {
+            stats.underruns++;
+            lastMissedFrame = cur;
+        }
+        if (ringCount == 0) starved = true;
+    }
+    stats.buffered = (uint8_t)ringCount;
+    xSemaphoreGive(mutex);
+
+    if (drawn) target->showPixels();
+    target->unlock();
+}
+
+LEDStreamStats LEDFrameStream::getStats() {
+    LEDStreamStats out;
+    if (!mutex) return out;
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+        out = stats;
+        xSemaphoreGive(mutex);
+    }
+    return out;
+}
+
+void LEDFrameStream::discardOldest() {
+    pixels->readFrame(scratch.get());
+    ringHead = (ringHead + 1) % RING_FRAMES;
+    ringCount--;
+}
+
+bool LEDFrameStream::decode(Encoding enc, const uint8_t* p, size_t len, size_t count) {
+    CRGB* dst = decoded.data();
+    switch (enc) {
+        case Encoding::Raw: {
+            if (len < count * 3) return false;
+            for (size_t i = 0; i < count && i < pixelCount; i++) {
+                dst[i] = CRGB(p[i * 3], p[i * 3 + 1], p[i * 3 + 2]);
+            }
+            return true;
+        }
+        case Encoding::Rle: {
+            size_t pos = 0;
+            size_t i = 0;
+            while (i < count && pos + 4 <= len) {
+                uint8_t run = p[pos];
+                CRGB c(p[pos + 1], p[pos + 2], p[pos + 3]);
+                pos += 4;
+                for (uint8_t k = 0; k < run && i < count; k++, i++) {
+                    if (i < pixelCount) dst[i] = c;
+                }
+            }
+            return i == count;
+        }
+        case Encoding::Delta: {
+            size_t pos = 0;
+            while (pos + 3 <= len) {
+                size_t index = (size_t)(p[pos] | (p[pos + 1] << 8));
+                uint8_t run = p[pos + 2];
+                pos += 3;
+                if (pos + (size_t)run * 3 > len) return false;
+                for (uint8_t k = 0; k < run; k++) {
+                    if (index + k < pixelCount) {
+                        dst[index + k] = CRGB(p[pos + k * 3], p[pos + k * 3 + 1], p[pos + k * 3 + 2]);
+                    }
+                }
+                pos += (size_t)run * 3;
+            }
+            return pos == len;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,83 @@
+#ifndef LED_FRAME_STREAM_H
+#define LED_FRAME_STREAM_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <vector>
+#include "fl/bytestreammemory.h"
+#include "fx/video/frame_interpolator.h"
+#include "fx/video/pixel_stream.h"
+
+class LEDController;
+
+// Binaere LED-Frames über den WebSocket (Opcode BINARY), little endian:
+//   [0]    'L'  Nachrichtentyp
+//   [1]    Kodierung: 0 = raw, 1 = RLE, 2 = delta
+//   [2]    Bildrate der Quelle in fps (1..120)
+//   [3]    reserviert (0)
+//   [4..5] Sequenznummer (uint16, läuft über)
+//   [6..7] Anzahl Pixel in diesem Frame
+//   [8..]  Nutzdaten
+// raw:   count * (r,g,b)
+// RLE:   Läufe (len u8, r, g, b) bis count Pixel gefüllt sind
+// delta: Einträge (index u16, len u8, len * (r,g,b)) auf den vorherigen Frame
+struct LEDStreamStats {
+    bool     active = false;
+    uint8_t  fps = 0;
+    uint8_t  buffered = 0;
+    uint32_t received = 0;
+    uint32_t underruns = 0;   // Abspielzeitpunkt erreicht, aber kein Frame vorhanden
+    uint32_t late = 0;        // Frame kam nach seinem Abspielzeitpunkt an
+    uint32_t dropped = 0;     // Ring voll, ältester Frame verworfen
+    uint32_t invalid = 0;
+};
+
+class LEDFrameStream {
+public:
+    static const uint8_t MSG_TYPE = 'L';
+    static const size_t HEADER_SIZE = 8;
+    static const size_t RING_FRAMES = 8;
+    static const size_t PREBUFFER_FRAMES = 2;
+    static const uint32_t OUTPUT_HZ = 50;
+    static const uint32_t IDLE_TIMEOUT_MS = 1000;
+
+    enum class Encoding : uint8_t { Raw = 0, Rle = 1, Delta = 2 };
+
+    void attach(LEDController* leds);
+    bool handleFrame(const uint8_t* data, size_t len);
+    void tick(uint32_t nowMs);
+    LEDStreamStats getStats();
+
+private:
+    SemaphoreHandle_t mutex = nullptr;
+    LEDController* leds = nullptr;
+    size_t pixelCount = 0;
+
+    bool active = false;
+    bool starved = false;
+    bool synced = false;
+    uint8_t fps = 0;
+    uint32_t startMs = 0;        // Zeitnullpunkt der Wiedergabe (Frame 0)
+    uint32_t lastRxMs = 0;
+    uint16_t lastSeq = 0;
+    uint32_t lastFrameNumber = 0;
+    uint32_t lastMissedFrame = UINT32_MAX;
+
+    std::vector<CRGB> decoded;   // zuletzt empfangenes Bild (Basis für delta)
+    fl::ByteStreamMemoryPtr ring;
+    fl::PixelStreamPtr pixels;
+    fl::FrameInterpolatorPtr interpolator;
+    fl::FramePtr scratch;
+    uint32_t ringFrameNumbers[RING_FRAMES];
+    size_t ringHead = 0;
+    size_t ringCount = 0;
+
+    LEDStreamStats stats;
+
+    void begin(uint8_t sourceFps, uint32_t nowMs);
+    void end();
+    bool decode(Encoding enc, const uint8_t* p, size_t len, size_t count);
+    void discardOldest();
+};
+
+#endif
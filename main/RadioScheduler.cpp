@@ -0,0 +1,265 @@
+#include "RadioScheduler.h"
+
+RadioScheduler::RadioScheduler(RadioClock& clock, BtScanControl& bt, WifiControl& wifi)
+    : clock(clock), bt(bt), wifi(wifi) {}
+
+const char* RadioScheduler::modeName(RadioMode mode) {
+    switch (mode) {
+        case RadioMode::Normal:        return "normal";
+        case RadioMode::BluetoothOnly: return "bt_only";
+        case RadioMode::WifiOnly:      return "wifi_only";
+    }
+    return "?";
+}
+
+const char* RadioScheduler::policyName(ScanPolicy policy) {
+    return policy == ScanPolicy::Adaptive ? "adaptive" : "fixed";
+}
+
+RadioMode RadioScheduler::nextButtonMode() {
+    modeStep = (modeStep + 1) % 4;
+    if (modeStep == 0) return RadioMode::Normal;
+    if (modeStep == 2) return RadioMode::BluetoothOnly;
+    return RadioMode::WifiOnly;
+}
+
+bool RadioScheduler::setMode(RadioMode m) {
+    if (modeApplied && m == mode) return false;
+    modeApplied = true;
+    mode = m;
+    uint32_t now = clock.nowMs();
+    searchSinceMs = now;
+    stats.idleWindows = 0;
+
+    if (mode == RadioMode::Normal) {
+        wifi.requestEnable();
+        setScan(false, now);
+        phase = Phase::Off;
+        nextToggleAt = now;
+    } else if (mode == RadioMode::BluetoothOnly) {
+        wifi.requestPause();
+        setScan(true, now);
+        phase = Phase::On;
+    } else {
+        // Erst die Controller trennen, dann die Suche aus
+        bt.disconnectAll();
+        setScan(false, now);
+        phase = Phase::Off;
+        wifi.requestEnable();
+    }
+    return true;
+}
+
+void RadioScheduler::onControllerConnected() {
+    uint32_t now = clock.nowMs();
+    stats.connects++;
+    stats.lastPairMs = now - searchSinceMs;
+    if (scanEnabled && !windowPaired) {
+        windowPaired = true;
+        stats.pairedWindows++;
+    }
+    stats.idleWindows = 0;
+    searchSinceMs = now;   // für einen weiteren Controller
+    if (mode == RadioMode::Normal) {
+        // WLAN kurz pausieren, damit Pairing/Re-Auth ungestört durchläuft
+        wifiPauseUntilMs = now + WIFI_PAUSE_ON_CONNECT_MS;
+        wifiPauseRequested = true;
+    }
+}
+
+void RadioScheduler::onControllerReconnected(uint32_t lostForMs) {
+    onControllerConnected();
+    if (expected > 0) expected--;
+    stats.reconnects++;
+    stats.lastReconnectMs = lostForMs;
+    if (lostForMs > stats.maxReconnectMs) stats.maxReconnectMs = lostForMs;
+}
+
+void RadioScheduler::onControllerDisconnected() {
+    uint32_t now = clock.nowMs();
+    stats.losses++;
+    searchSinceMs = now;
+    stats.idleWindows = 0;
+    // Erst danach die Suche neu starten, sonst kommt error=0x0c (Command Disallowed)
+    scanRestartAfterMs = now + SCAN_RESTART_DELAY_MS;
+    // Getrennt per MODE-Taster (nur WLAN): nicht zurückerwarten
+    if (base.reconnectMs && mode != RadioMode::WifiOnly) {
+        if (expected < 255) expected++;
+        reconnectUntilMs = now + base.reconnectMs;
+        pageOnlyUntilMs = now + RECONNECT_PAGE_ONLY_MS;
+        directPaged = false;
+    }
+}
+
+void RadioScheduler::setScan(bool on, uint32_t now) {
+    if (on && !scanEnabled) scanOnSince = now;
+    if (!on && scanEnabled) stats.scanOnMs += now - scanOnSince;
+    scanEnabled = on;
+    bt.setScanEnabled(on);
+}
+
+// Solange ein bekannter Controller zurückerwartet wird: gleich lange Fenster (kürzer reicht für
+// kein Pairing), aber bis zu viermal so lange Pausen
+ScanWindow RadioScheduler::reconnectWindow(ScanWindow w) {
+    if (w.onMs == 0) return w;
+    uint32_t on = w.onMs;
+    uint32_t off = w.offMs * 4;
+    uint32_t maxOff = w.offMs > MAX_OFF_MS ? w.offMs : MAX_OFF_MS;
+    if (off > maxOff) off = maxOff;
+    if (off < w.offMs) off = w.offMs;
+    return {on, off};
+}
+
+bool RadioScheduler::updateReconnect(uint32_t now) {
+    if (expected && reached(now, reconnectUntilMs)) {
+        stats.reconnectTimeouts += expected;
+        expected = 0;
+    }
+    bool reconnecting = expected > 0 && mode != RadioMode::WifiOnly;
+    if (reconnecting != fastPageScan) {
+        fastPageScan = reconnecting;
+        bt.setFastPageScan(reconnecting);
+    }
+    // Hat der Controller nicht selbst angerufen, einmal selbst anrufen (nur gebondete)
+    if (reconnecting && !directPaged && reached(now, pageOnlyUntilMs)) {
+        directPaged = true;
+        stats.directReconnects++;
+        bt.reconnectKnown();
+    }
+    return reconnecting;
+}
+
+ScanWindow RadioScheduler::adapt(ScanWindow w, const RadioSignals& s) const {
+    if (policy != ScanPolicy::Adaptive || w.onMs == 0 || scenario == Scenario::Reconnect) return w;
+    uint32_t on = w.onMs;
+    uint32_t off = w.offMs;
+    // Ein eben verlorener Controller wird nicht hier gesucht: er ruft selbst an bzw. wird direkt
+    // angerufen (Scenario::Reconnect). Häufigeres Suchen blockierte nur seinen Page Scan.
+    bool wsBusy = s.wsControlActive || s.wsTxQueue >= WS_QUEUE_BUSY;
+    if (wsBusy) {
+        // Jemand fährt über die Weboberfläche oder die Sendewarteschlange staut sich: seltener
+        // suchen. Das Fenster selbst bleibt so lang, sonst reicht es für kein Pairing mehr.
+        off *= 2;
+    } else if (s.wsClients > 0 && stats.idleWindows > IDLE_BACKOFF_WINDOWS) {
+        // Lange kein Controller gekommen, die Weboberfläche ist aber offen: Pausen schrittweise
+        // verlängern, ein Connect oder Verlust setzt zurück
+        uint32_t steps = (stats.idleWindows - IDLE_BACKOFF_WINDOWS) / 10 + 1;
+        off += off * steps / 2;
+    }
+    if (on < 50) on = 50;
+    if (off < 100) off = 100;
+    uint32_t maxOff = w.offMs > MAX_OFF_MS ? w.offMs : MAX_OFF_MS;
+    if (off > maxOff) off = maxOff;
+    return {on, off};
+}
+
+void RadioScheduler::tick(const RadioSignals& s) {
+    uint32_t now = clock.nowMs();
+
+    // Kurze WLAN-Pause nach einem Connect (nur im Normalmodus). Keine neue Suche, wenn schon ein
+    // Controller verbunden ist – das Umschalten stört BTstack und kann den DS3 trennen.
+    if (mode == RadioMode::Normal) {
+        if (wifiPauseRequested && !reached(now, wifiPauseUntilMs)) {
+            if (!wifiPausedForBt) {
+                wifi.requestPause();
+                if (!s.anyController) setScan(true, now);
+                wifiPausedForBt = true;
+            }
+        } else {
+            wifiPauseRequested = false;
+            if (wifiPausedForBt) {
+                wifi.requestEnable();
+                wifiPausedForBt = false;
+            }
+        }
+    } else if (wifiPausedForBt) {
+        wifiPausedForBt = false;
+        wifiPauseRequested = false;
+    }
+
+    bool reconnecting = updateReconnect(now);
+    // Während Page Scan und direktem Anruf keine Suche, die würde beides blockieren
+    bool pageOnly = reconnecting && !reached(now, pageOnlyUntilMs + RECONNECT_DIRECT_MS);
+
+    if (mode == RadioMode::BluetoothOnly) {
+        if (scanEnabled == pageOnly) setScan(!pageOnly, now);
+        return;
+    }
+    if (mode == RadioMode::WifiOnly) {
+        if (scanEnabled) {
+            setScan(false, now);
+            phase = Phase::Off;
+        }
+        return;
+    }
+    if (s.wifiDisabledUntilRestart) {
+        // WLAN ist aus: ohne Controller durchgehend suchen
+        if (!s.anyController && !pageOnly) {
+            if (!scanEnabled) {
+                setScan(true, now);
+                phase = Phase::On;
+            }
+        } else if (scanEnabled) {
+            setScan(false, now);
+            phase = Phase::Off;
+        }
+        return;
+    }
+
+    // Szenario: Controller verbunden -> keine Suche; Controller zurückerwartet -> erst keine, dann
+    // wenig; AP mit Clients -> sehr wenig; STA verbindet -> wenig; sonst ausgewogen
+    Scenario sc = Scenario::Normal;
+    ScanWindow w = base.normal;
+    if (s.anyController) {
+        sc = Scenario::Connected;
+        w = {0, 1000};
+    } else if (reconnecting) {
+        sc = Scenario::Reconnect;
+        ScanWindow b = s.apActive ? base.apActive : s.staConnecting ? base.staConnect : base.normal;
+        w = pageOnly ? ScanWindow{0, 1000} : reconnectWindow(b);
+    } else if (s.apActive) {
+        sc = Scenario::ApActive;
+        w = base.apActive;
+    } else if (s.staConnecting) {
+        sc = Scenario::StaConnect;
+        w = base.staConnect;
+    }
+    if (sc != scenario || w != baseWindow) {
+        // Szenario oder Einstellung geändert: Takt neu beginnen. Anpassungen der adaptiven
+        // Strategie greifen dagegen erst mit dem nächsten Fenster.
+        scenario = sc;
+        baseWindow = w;
+        stats.window = adapt(w, s);
+        phase = Phase::Off;
+        setScan(false, now);
+        nextToggleAt = now + stats.window.offMs;
+    }
+
+    if (!s.anyController && !reached(now, scanRestartAfterMs)) return;
+    if (s.anyController) {
+        if (scanEnabled) {
+            setScan(false, now);
+            phase = Phase::Off;
+            nextToggleAt = now + 1000;
+        }
+        return;
+    }
+    if (!reached(now, nextToggleAt)) return;
+
+    if (phase == Phase::Off) {
+        stats.window = adapt(baseWindow, s);
+        bool on = stats.window.onMs > 0;
+        setScan(on, now);
+        phase = Phase::On;
+        nextToggleAt = now + (on ? stats.window.onMs : stats.window.offMs);
+        if (on) {
+            stats.scanWindows++;
+            windowPaired = false;
+        }
+    } else {
+        if (scanEnabled && !windowPaired) stats.idleWindows++;
+        setScan(false, now);
+        phase = Phase::Off;
+        nextToggleAt = now + stats.window.offMs;
+    }
+}
@@ -0,0 +1,165 @@
+#ifndef RADIO_SCHEDULER_H
+#define RADIO_SCHEDULER_H
+
+#include <stdint.h>
+
+// Teilt die Funkzeit zwischen Bluetooth-Suche und WLAN auf: Funkmodus (MODE-Taster), kurze
+// WLAN-Pause nach einem Controller-Connect und das Ein-/Ausschalten der BT-Suche im Takt.
+// Ohne Arduino-Abhängigkeit: Uhr, BT und WLAN kommen als Schnittstellen herein, damit
+// tools/radio_sim.cpp dieselbe Logik auf dem Host mit aufgezeichneten Abläufen durchspielt.
+
+enum class RadioMode : uint8_t { Normal, BluetoothOnly, WifiOnly };
+
+// Fixed (Standard): feste Fenster je Szenario (bt_scan_*). Adaptive: dieselben Fenster als Basis,
+// angepasst an WS-Last und erfolglose Suchfenster; weniger WS-Latenz, dafür späteres Pairing
+// (tools/radio_sim).
+// Unabhängig davon: nach einem Verlust wird der Controller reconnectMs lang zurückerwartet. Er ruft
+// meist selbst an (Page), dafür braucht es keine Suche: erst nur schneller Page Scan, dann ein
+// direkter Anruf, danach Suche mit niedrigem Takt. Die volle Suche kommt erst nach reconnectMs.
+enum class ScanPolicy : uint8_t { Fixed, Adaptive };
+
+struct ScanWindow {
+    uint32_t onMs;
+    uint32_t offMs;
+    bool operator==(const ScanWindow& o) const { return onMs == o.onMs && offMs == o.offMs; }
+    bool operator!=(const ScanWindow& o) const { return !(*this == o); }
+};
+
+struct ScanTimings {
+    ScanWindow normal = {500, 500};        // WLAN ruhig
+    ScanWindow staConnect = {150, 850};    // STA verbindet: dem WLAN mehr Funkzeit lassen
+    ScanWindow apActive = {100, 1900};     // AP mit Clients: so wenig Suche wie möglich
+    uint32_t reconnectMs = 15000;          // verlorenen Controller so lange zurückerwarten, 0 = aus
+};
+
+class RadioClock {
+public:
+    virtual ~RadioClock() {}
+    virtual uint32_t nowMs() = 0;
+};
+
+class BtScanControl {
+public:
+    virtual ~BtScanControl() {}
+    virtual void setScanEnabled(bool on) = 0;   // neue Verbindungen annehmen / suchen
+    virtual void disconnectAll() = 0;
+    virtual void setFastPageScan(bool on) = 0;  // bekannte Controller kommen schneller durch
+    virtual void reconnectKnown() = 0;          // verlorene Controller direkt anrufen
+};
+
+class WifiControl {
+public:
+    virtual ~WifiControl() {}
+    virtual void requestEnable() = 0;
+    virtual void requestPause() = 0;   // vorübergehend, nicht bis zum Neustart
+};
+
+// Vom Aufrufer je Durchlauf erhoben
+struct RadioSignals {
+    bool anyController = false;
+    bool staConnecting = false;
+    bool apActive = false;                 // AP mit verbundenen Clients
+    bool wifiDisabledUntilRestart = false;
+    uint16_t wsTxQueue = 0;                // längste WS-Sendewarteschlange aller Clients
+    bool wsControlActive = false;          // Fahrbefehle über WS in der letzten Sekunde
+    uint8_t wsClients = 0;
+};
+
+struct RadioSchedulerStats {
+    uint32_t scanWindows = 0;      // begonnene Suchfenster
+    uint32_t pairedWindows = 0;    // Fenster, in denen ein Controller verbunden hat
+    uint32_t connects = 0;
+    uint32_t losses = 0;
+    uint32_t lastPairMs = 0;       // Verlust bzw. Suchbeginn bis Connect
+    uint32_t scanOnMs = 0;         // Summe der Suchzeit
+    uint32_t idleWindows = 0;      // Fenster ohne Erfolg seit dem letzten Ereignis
+    ScanWindow window = {0, 0};    // aktuell benutzt
+    uint32_t reconnects = 0;       // zurückerwartete Controller, die wiederkamen
+    uint32_t reconnectTimeouts = 0;   // ... und die nicht innerhalb reconnectMs
+    uint32_t lastReconnectMs = 0;  // Verlust bis Connect
+    uint32_t maxReconnectMs = 0;
+    uint32_t directReconnects = 0; // direkte Anrufe
+};
+
+class RadioScheduler {
+public:
+    RadioScheduler(RadioClock& clock, BtScanControl& bt, WifiControl& wifi);
+
+    void setTimings(const ScanTimings& timings) { base = timings; }
+    void setPolicy(ScanPolicy p) { policy = p; }
+    ScanPolicy getPolicy() const { return policy; }
+
+    // Wendet den Modus an (nur bei Änderung); true, wenn umgeschaltet wurde
+    bool setMode(RadioMode mode);
+    RadioMode getMode() const { return mode; }
+    // MODE-Taster: Normal -> nur WLAN -> nur BT -> nur WLAN -> Normal
+    RadioMode nextButtonMode();
+
+    void onControllerConnected();
+    // Ein zurückerwarteter Controller ist wieder da (der Aufrufer kennt die Adressen)
+    void onControllerReconnected(uint32_t lostForMs);
+    void onControllerDisconnected();
+    // Einmal je loop()-Durchlauf
+    void tick(const RadioSignals& signals);
+
+    bool isScanEnabled() const { return scanEnabled; }
+    bool isReconnecting() const { return expected > 0; }
+    const RadioSchedulerStats& getStats() const { return stats; }
+    static const char* modeName(RadioMode mode);
+    static const char* policyName(ScanPolicy policy);
+
+    static const uint32_t WIFI_PAUSE_ON_CONNECT_MS = 3000;
+    static const uint32_t SCAN_RESTART_DELAY_MS = 600;   // BTstack braucht ~500 ms für den Disconnect
+    // Adaptive Richtwerte
+    static const uint16_t WS_QUEUE_BUSY = 2;             // ab hier lässt der Server schon Telemetrie aus
+    static const uint32_t IDLE_BACKOFF_WINDOWS = 30;     // danach wird die Pause zwischen Suchen länger
+    static const uint32_t MAX_OFF_MS = 4000;
+    // Nach einem Verlust so lange nur Page Scan, dann ein direkter Anruf; der darf dauern, bis
+    // Bluepad32 aufgibt (Namensabfrage), erst danach kommt die Suche mit niedrigem Takt
+    static const uint32_t RECONNECT_PAGE_ONLY_MS = 3000;
+    static const uint32_t RECONNECT_DIRECT_MS = 5000;
+
+private:
+    enum class Scenario : uint8_t { Normal, StaConnect, ApActive, Connected, Reconnect };
+    enum class Phase : uint8_t { Off, On };
+
+    RadioClock& clock;
+    BtScanControl& bt;
+    WifiControl& wifi;
+    ScanTimings base;
+    ScanPolicy policy = ScanPolicy::Fixed;
+
+    RadioMode mode = RadioMode::Normal;
+    bool modeApplied = false;
+    int modeStep = 0;
+
+    bool scanEnabled = false;
+    Phase phase = Phase::Off;
+    uint32_t nextToggleAt = 0;
+    Scenario scenario = Scenario::Normal;
+    ScanWindow baseWindow = {500, 500};
+    uint32_t scanOnSince = 0;
+    bool windowPaired = false;
+
+    uint32_t wifiPauseUntilMs = 0;
+    bool wifiPauseRequested = false;
+    bool wifiPausedForBt = false;
+    uint32_t scanRestartAfterMs = 0;
+    uint32_t searchSinceMs = 0;    // Beginn der aktuellen Suche nach einem Controller
+
+    uint8_t expected = 0;          // verlorene Controller, die zurückerwartet werden
+    uint32_t reconnectUntilMs = 0;
+    uint32_t pageOnlyUntilMs = 0;
+    bool directPaged = false;
+    bool fastPageScan = false;
+
+    RadioSchedulerStats stats;
+
+    void setScan(bool on, uint32_t now);
+    ScanWindow adapt(ScanWindow w, const RadioSignals& s) const;
+    static ScanWindow reconnectWindow(ScanWindow w);
+    bool updateReconnect(uint32_t now);
+    static bool reached(uint32_t now, uint32_t at) { return (int32_t)(now - at) >= 0; }
+};
+
+#endif
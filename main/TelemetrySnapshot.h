@@ -0,0 +1,84 @@
+#ifndef TELEMETRY_SNAPSHOT_H
+#define TELEMETRY_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <Bluepad32.h>
+#include "LEDFrameStream.h"
+
+// Sperrfreie Übergabe eines Werts von genau einem Schreiber an beliebig viele Leser (Seqlock).
+// Der Schreiber macht die Sequenz ungerade, kopiert und macht sie wieder gerade; ein Leser
+// kopiert und wiederholt, falls sich die Sequenz dabei geändert hat. Der Schreiber wartet nie.
+template<typename T>
+class SeqLock {
+public:
+    void publish(const T& value) {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        data = value;
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    T read() const {
+        T out;
+        for (int spins = 0;; spins++) {
+            uint32_t before = seq.load(std::memory_order_acquire);
+            if (!(before & 1)) {
+                out = data;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq.load(std::memory_order_relaxed) == before) return out;
+            }
+            // Schreiber wurde mitten in der Kopie verdrängt (gleicher Kern, niedrigere Priorität)
+            if (spins > 8) vTaskDelay(1);
+        }
+    }
+
+private:
+    std::atomic<uint32_t> seq{0};
+    T data{};
+};
+
+struct ControllerInputSnapshot {
+    bool     connected = false;
+    uint32_t buttons   = 0;
+    uint8_t  dpad      = 0;
+    int16_t  axisX = 0, axisY = 0, axisRX = 0, axisRY = 0;
+    uint32_t updatedMs = 0;
+};
+
+// Langsame Messungen (ADC mit Mittelung), vom TelemetryTask geschrieben
+struct PowerTelemetry {
+    float batteryVoltage = 0;
+    float batteryPercentage = 0;
+    float hbridgeAmps[2] = {};
+    uint32_t updatedMs = 0;
+};
+
+struct ActuatorTelemetry {
+    int servos[3] = {};
+    int motorPWMs[4] = {};
+    uint32_t updatedMs = 0;
+};
+
+struct LedTelemetry {
+    uint8_t firstLED[3] = {};
+    uint32_t budgetMw = 0;
+    uint32_t estimatedMw = 0;
+    uint8_t brightness = 0;
+    uint32_t showUs = 0;
+    uint32_t showMaxUs = 0;   // Maximum seit der vorigen Veröffentlichung
+    LEDStreamStats stream;
+    uint32_t updatedMs = 0;
+};
+
+// Letzter bekannter Stand für die Telemetrie. Jeder Abschnitt hat einen eigenen Schreiber
+// mit eigener Rate; der WebSocket-Sender liest nur und blockiert dabei niemanden.
+struct TelemetrySnapshot {
+    SeqLock<PowerTelemetry> power;
+    SeqLock<ActuatorTelemetry> actuators;
+    SeqLock<LedTelemetry> leds;
+    SeqLock<ControllerInputSnapshot> controllers[BP32_MAX_GAMEPADS]; // vom Bluepad32-Loop
+};
+
+#endif
@@ -60,14 +60,31 @@ void TinkerThinkerBoard::reApplyConfig() {
     }
     servoController->init();
 
-    ledController = new LEDController(config->getLedCount());
-    ledController->init();
+    // LED-Controller nur einmal anlegen; geänderte Ausgänge werden umkonfiguriert
+    if (!ledController) {
+        ledController = new LEDController();
+        // Motor-, Servo- und Power-Pins sind fest verdrahtet; ein LED-Ausgang dort würde per RMT
+        // neben dem Motortreiber bzw. Servo-Signal treiben
+        for (size_t i = 0; i < MOTOR_COUNT; i++) {
+            ledController->reservePin(motors[i].pin1, "a motor");
+            ledController->reservePin(motors[i].pin2, "a motor");
+        }
+        for (size_t i = 0; i < SERVO_COUNT; i++) ledController->reservePin(servos[i].pin, "a servo");
+        ledController->reservePin(POWER_ON_PIN, "POWER_ON");
+    }
+    LEDOutputConfig ledOutputs[LED_MAX_OUTPUTS];
+    for (int i = 0; i < LED_MAX_OUTPUTS && i < ConfigManager::LED_OUTPUTS; i++) {
+        ledOutputs[i].pin = config->getLedOutputPin(i);
+        ledOutputs[i].count = config->getLedOutputCount(i);
+        ledOutputs[i].order = LEDController::parseColorOrder(config->getLedOutputOrder(i).c_str());
+    }
+    ledController->configureOutputs(ledOutputs, LED_MAX_OUTPUTS);
+    ledStream.attach(ledController);
     ledController->setGamma(config->getLedGamma());
-    FastLED.setBrightness(config->getLedBrightness());
-    for (int i = 0; i < config->getLedCount(); i++) {
+    for (int i = 0; i < ledController->getLedCount(); i++) {
         ledController->setPixelColor(i, 0, 0, 0); // Boot-Default: aus (nicht „weiß")
     }
-    FastLED.show();
+    ledController->setBrightness(config->getLedBrightness()); // zeigt auch an
 
     batteryMonitor = new BatteryMonitor(BATTERY_PIN);
     batteryMonitor->init();
@@ -78,7 +95,7 @@ void TinkerThinkerBoard::reApplyConfig() {
 }
 
 void TinkerThinkerBoard::begin() {
-    config->init();
+    // config->init() ist zu diesem Zeitpunkt schon gelaufen (setup), nicht ein zweites Mal laden
     pinMode(POWER_ON_PIN, OUTPUT);
     digitalWrite(POWER_ON_PIN, HIGH);
 
@@ -91,6 +108,18 @@ void TinkerThinkerBoard::startServices() {
     webServerManager = new WebServerManager(this, config);
     webServerManager->init();
 
+    // Messwerte (ADC mit Mittelung, Aktorstellungen, LED-Status) in den Telemetrie-Snapshot
+    xTaskCreatePinnedToCore([](void* obj) {
+        TinkerThinkerBoard* board = (TinkerThinkerBoard*)obj;
+        TickType_t lastWake = xTaskGetTickCount();
+        for (;;) {
+            board->checkCommandTimeouts(millis());
+            board->sampleTelemetry(millis());
+            vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(TELEMETRY_TASK_MS));
+        }
+    }, "TelemetryTask", 4096, this, 1, NULL, 1);
+
+    // Versand liest nur den Snapshot und serialisiert
     xTaskCreatePinnedToCore([](void* obj) {
         TinkerThinkerBoard* board = (TinkerThinkerBoard*)obj;
         for (;;) {
@@ -99,6 +128,16 @@ void TinkerThinkerBoard::startServices() {
         }
     }, "WebClientTask", 4096, this, 1, NULL, 1);
 
+    // Feste Ausgaberate für gestreamte LED-Frames (interpoliert zwischen empfangenen Frames)
+    xTaskCreatePinnedToCore([](void* obj) {
+        TinkerThinkerBoard* board = (TinkerThinkerBoard*)obj;
+        TickType_t lastWake = xTaskGetTickCount();
+        for (;;) {
+            board->ledStream.tick(millis());
+            vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1000 / LEDFrameStream::OUTPUT_HZ));
+        }
+    }, "LEDStreamTask", 4096, this, 1, NULL, 1);
+
     Serial.println("TinkerThinkerBoard initialized.");
 }
 
@@ -148,6 +187,14 @@ void TinkerThinkerBoard::setLED(int led, uint8_t r, uint8_t g, uint8_t b) {
     ledController->setPixelColor(led, r, g, b);
 }
 
+void TinkerThinkerBoard::setOutputLED(int output, int led, uint8_t r, uint8_t g, uint8_t b) {
+    ledController->setPixelColor(output, led, r, g, b);
+}
+
+int TinkerThinkerBoard::getLedOutputCount(int output) {
+    return ledController ? ledController->getOutputCount(output) : 0;
+}
+
 void TinkerThinkerBoard::showLEDs() {
     ledController->showPixels();
 }
@@ -164,6 +211,54 @@ void TinkerThinkerBoard::setLedGamma(bool enabled) {
     if (ledController) ledController->setGamma(enabled);
 }
 
+void TinkerThinkerBoard::updateLedPowerBudget() {
+    if (!ledController) return;
+    PowerTelemetry power = telemetry.power.read();
+    if (power.updatedMs == 0) return;
+
+    uint32_t limit = (uint32_t)config->getLedPowerLimitMw();
+    if (limit == 0) {
+        ledController->setPowerBudget(0);
+        return;
+    }
+
+    // Akku: ab 3.8 V volles Budget, darunter linear bis 25 % bei 3.4 V (1S).
+    // Unter 2.5 V ist kein Akku gemessen (USB-Versorgung) – dann nicht drosseln.
+    float voltage = power.batteryVoltage;
+    float batteryFactor = 1.0f;
+    if (voltage > 2.5f) {
+        batteryFactor = 0.25f + 0.75f * constrain((voltage - 3.4f) / 0.4f, 0.0f, 1.0f);
+    }
+    // Motorstrom: ab 0.5 A linear bis 40 % bei 2 A
+    float amps = power.hbridgeAmps[0] + power.hbridgeAmps[1];
+    float motorFactor = 1.0f - 0.6f * constrain((amps - 0.5f) / 1.5f, 0.0f, 1.0f);
+
+    uint32_t budget = (uint32_t)(limit * batteryFactor * motorFactor);
+    budget = (budget / 100) * 100;  // in 100-mW-Schritten, damit Messrauschen nicht neu skaliert
+    if (budget < LED_POWER_MIN_MW) budget = LED_POWER_MIN_MW;
+    ledController->setPowerBudget(budget);
+}
+
+uint32_t TinkerThinkerBoard::getLedPowerBudget() {
+    return ledController ? ledController->getPowerBudget() : 0;
+}
+
+uint32_t TinkerThinkerBoard::getLedEstimatedPower() {
+    return ledController ? ledController->getEstimatedPower() : 0;
+}
+
+uint8_t TinkerThinkerBoard::getLedAppliedBrightness() {
+    return ledController ? ledController->getAppliedBrightness() : 0;
+}
+
+bool TinkerThinkerBoard::handleLEDStreamFrame(const uint8_t* data, size_t len) {
+    return ledStream.handleFrame(data, len);
+}
+
+LEDStreamStats TinkerThinkerBoard::getLEDStreamStats() {
+    return ledStream.getStats();
+}
+
 float TinkerThinkerBoard::getBatteryVoltage() {
     return batteryMonitor->readVoltage();
 }
@@ -188,6 +283,44 @@ float TinkerThinkerBoard::getSpeedMultiplier() {
     return motorController ? motorController->getSpeedMultiplier() : 1.0f;
 }
 
+void TinkerThinkerBoard::sampleTelemetry(uint32_t now) {
+    if (batteryMonitor && systemMonitor && now - lastPowerSampleMs >= TELEMETRY_POWER_MS) {
+        lastPowerSampleMs = now;
+        PowerTelemetry p;
+        p.batteryVoltage = batteryMonitor->readVoltage();
+        p.batteryPercentage = batteryMonitor->mapVoltageToPercent(p.batteryVoltage);
+        p.hbridgeAmps[0] = systemMonitor->getHBridgeAmps(0);
+        p.hbridgeAmps[1] = systemMonitor->getHBridgeAmps(1);
+        p.updatedMs = now;
+        telemetry.power.publish(p);
+        updateLedPowerBudget();
+    }
+    if (now - lastActuatorSampleMs >= TELEMETRY_ACTUATOR_MS) {
+        lastActuatorSampleMs = now;
+        ActuatorTelemetry a;
+        for (int i = 0; i < 3; i++) a.servos[i] = getServoAngle(i);
+        for (int i = 0; i < 4; i++) a.motorPWMs[i] = getMotorPWM(i);
+        a.updatedMs = now;
+        telemetry.actuators.publish(a);
+    }
+    if (ledController && now - lastLedSampleMs >= TELEMETRY_LED_MS) {
+        lastLedSampleMs = now;
+        LedTelemetry l;
+        CRGB first = ledController->getLEDColor(0);
+        l.firstLED[0] = first.r;
+        l.firstLED[1] = first.g;
+        l.firstLED[2] = first.b;
+        l.budgetMw    = ledController->getPowerBudget();
+        l.estimatedMw = ledController->getEstimatedPower();
+        l.brightness  = ledController->getAppliedBrightness();
+        l.showUs      = ledController->getLastShowMicros();
+        l.showMaxUs   = ledController->takeMaxShowMicros();
+        l.stream      = ledStream.getStats();
+        l.updatedMs   = now;
+        telemetry.leds.publish(l);
+    }
+}
+
 void TinkerThinkerBoard::updateWebClients() {
     if (webServerManager) {
         webServerManager->sendStatusUpdate();
@@ -213,6 +346,26 @@ bool TinkerThinkerBoard::isWifiDisabledUntilRestart() {
     return false;
 }
 
+WifiState TinkerThinkerBoard::getWifiState() {
+    return webServerManager ? webServerManager->getWifiState() : WifiState::Off;
+}
+
+WifiRadioStats TinkerThinkerBoard::getWifiRadioStats() {
+    return webServerManager ? webServerManager->getWifiRadioStats() : WifiRadioStats();
+}
+
+uint8_t TinkerThinkerBoard::getWsClientCount() {
+    return webServerManager ? webServerManager->getWsClientCount() : 0;
+}
+
+uint16_t TinkerThinkerBoard::getWsTxQueueMax() {
+    return webServerManager ? webServerManager->getWsTxQueueMax() : 0;
+}
+
+uint32_t TinkerThinkerBoard::getLastWsControlMs() {
+    return webServerManager ? webServerManager->getLastWsControlMs() : 0;
+}
+
 void TinkerThinkerBoard::notifyControllerConnected(int slot, const char* mac, const char* model) {
     if (webServerManager) webServerManager->notifyControllerConnected(slot, mac, model);
 }
@@ -227,14 +380,40 @@ void TinkerThinkerBoard::setWhitelistApplyCallback(std::function<void()> cb) {
 
 // --- Arbitration helpers ---
 bool TinkerThinkerBoard::shouldAccept(ControlSource src, bool isActive) {
-    uint32_t now = millis();
     // If active command, always accept and take ownership
     if (isActive) {
         takeOwnership(src);
-        return true;
+    } else if (lastSource != src) {
+        // Neutral command: accept only if same source currently owns control
+        return false;
+    }
+    // Jeder angenommene Befehl hält die Quelle am Leben, auch ein neutraler
+    lastCommandMs[(int)src].store(millis(), std::memory_order_relaxed);
+    commandArmed[(int)src].store(true, std::memory_order_release);
+    return true;
+}
+
+void TinkerThinkerBoard::checkCommandTimeouts(uint32_t now) {
+    // Ohne Lock vorprüfen (läuft mit 50 Hz), entschieden wird erst unter dem Lock
+    ControlSource src = lastSource;
+    uint32_t timeout = commandTimeoutMs(src);
+    if (timeout == 0 || !commandArmed[(int)src].load(std::memory_order_acquire)) return;
+    if ((int32_t)(now - lastCommandMs[(int)src].load(std::memory_order_relaxed)) <= (int32_t)timeout) return;
+    lockArbiter();
+    // Inzwischen kann ein Befehl angekommen sein oder eine andere Quelle übernommen haben
+    now = millis();
+    bool expired = lastSource == src && commandArmed[(int)src].load(std::memory_order_relaxed) &&
+                   (int32_t)(now - lastCommandMs[(int)src].load(std::memory_order_relaxed)) > (int32_t)timeout;
+    if (expired) {
+        commandArmed[(int)src].store(false, std::memory_order_relaxed);
+        for (int i = 0; i < (int)MOTOR_COUNT; i++) controlMotorStop(i);
+        lastSource = ControlSource::None;
+    }
+    unlockArbiter();
+    if (expired) {
+        Serial.printf("TinkerThinkerBoard: no command from source %d for %u ms, stopping motors\n",
+            (int)src, (unsigned)timeout);
     }
-    // Neutral command: accept only if same source currently owns control
-    return (lastSource == src);
 }
 
 void TinkerThinkerBoard::takeOwnership(ControlSource src) {
@@ -288,6 +467,7 @@ void TinkerThinkerBoard::applyDriveOther(int axisX, int axisY, bool swapSides) {
 
 // --- Source-aware API implementations ---
 void TinkerThinkerBoard::requestDriveFromBT(int axisX, int axisY, bool swapSides) {
+    lockArbiter();
     bool active = !isNeutralAxes(axisX, axisY);
     if (shouldAccept(ControlSource::Bluetooth, active)) {
         // Eigene BT-Controller-Einstellungen – unabhängig von der Website.
@@ -297,9 +477,11 @@ void TinkerThinkerBoard::requestDriveFromBT(int axisX, int axisY, bool swapSides
         if (config->getBtInvertY()) axisY = -axisY;
         applyDrive(axisX, axisY, swapSides);
     }
+    unlockArbiter();
 }
 
 void TinkerThinkerBoard::requestDriveFromWS(int axisX, int axisY, bool swapSides) {
+    lockArbiter();
     bool active = !isNeutralAxes(axisX, axisY);
     if (shouldAccept(ControlSource::WebSocket, active)) {
         // Eigene Website-Einstellungen – unabhängig von den BT-Controller-Bindings.
@@ -309,9 +491,11 @@ void TinkerThinkerBoard::requestDriveFromWS(int axisX, int axisY, bool swapSides
         if (config->getWsInvertY()) axisY = -axisY;
         applyDrive(axisX, axisY, false);
     }
+    unlockArbiter();
 }
 
 void TinkerThinkerBoard::requestDriveOtherFromBT(int axisX, int axisY, bool swapSides) {
+    lockArbiter();
     bool active = !isNeutralAxes(axisX, axisY);
     if (shouldAccept(ControlSource::Bluetooth, active)) {
         if (config->getBtSwapAxes()) { int t = axisX; axisX = axisY; axisY = t; }
@@ -319,9 +503,11 @@ void TinkerThinkerBoard::requestDriveOtherFromBT(int axisX, int axisY, bool swap
         if (config->getBtInvertY()) axisY = -axisY;
         applyDriveOther(axisX, axisY, swapSides);
     }
+    unlockArbiter();
 }
 
 void TinkerThinkerBoard::requestDriveOtherFromWS(int axisX, int axisY, bool swapSides) {
+    lockArbiter();
     bool active = !isNeutralAxes(axisX, axisY);
     if (shouldAccept(ControlSource::WebSocket, active)) {
         // Eigene Website-Einstellungen – unabhängig von den BT-Controller-Bindings.
@@ -330,32 +516,47 @@ void TinkerThinkerBoard::requestDriveOtherFromWS(int axisX, int axisY, bool swap
         if (config->getWsInvertY()) axisY = -axisY;
         applyDriveOther(axisX, axisY, false);
     }
+    unlockArbiter();
 }
 
 void TinkerThinkerBoard::requestMotorDirectFromBT(int motorIndex, int pwmValue) {
+    lockArbiter();
     bool active = (abs(pwmValue) > 0);
     if (shouldAccept(ControlSource::Bluetooth, active)) {
         controlMotorDirect(motorIndex, pwmValue);
     }
+    unlockArbiter();
 }
 
 void TinkerThinkerBoard::requestMotorDirectFromWS(int motorIndex, int pwmValue) {
+    lockArbiter();
     bool active = (abs(pwmValue) > 0);
     if (shouldAccept(ControlSource::WebSocket, active)) {
         controlMotorDirect(motorIndex, pwmValue);
     }
+    unlockArbiter();
+}
+
+void TinkerThinkerBoard::requestMotorRawFromWS(int motorIndex, int pwmValue) {
+    lockArbiter();
+    if (shouldAccept(ControlSource::WebSocket, pwmValue != 0)) {
+        controlMotorRaw(motorIndex, pwmValue);
+    }
+    unlockArbiter();
 }
 
 void TinkerThinkerBoard::requestMotorStopFromWS(int motorIndex) {
+    lockArbiter();
     // Stop is neutral; only allow if WS owns control
     if (shouldAccept(ControlSource::WebSocket, false)) {
         controlMotorStop(motorIndex);
     }
+    unlockArbiter();
 }
 
 void TinkerThinkerBoard::updateControllerSnapshot(int idx, ControllerPtr ctl) {
     if (idx < 0 || idx >= BP32_MAX_GAMEPADS || !ctl) return;
-    ControllerInputSnapshot& s = controllerSnapshots[idx];
+    ControllerInputSnapshot s;
     s.connected = true;
     s.buttons   = ctl->buttons();
     s.dpad      = ctl->dpad();
@@ -364,15 +565,15 @@ void TinkerThinkerBoard::updateControllerSnapshot(int idx, ControllerPtr ctl) {
     s.axisRX    = ctl->axisRX();
     s.axisRY    = ctl->axisRY();
     s.updatedMs = millis();
+    telemetry.controllers[idx].publish(s);
 }
 
 void TinkerThinkerBoard::clearControllerSnapshot(int idx) {
     if (idx < 0 || idx >= BP32_MAX_GAMEPADS) return;
-    controllerSnapshots[idx] = ControllerInputSnapshot();
+    telemetry.controllers[idx].publish(ControllerInputSnapshot());
 }
 
-const ControllerInputSnapshot& TinkerThinkerBoard::getControllerSnapshot(int idx) const {
-    static const ControllerInputSnapshot empty;
-    if (idx < 0 || idx >= BP32_MAX_GAMEPADS) return empty;
-    return controllerSnapshots[idx];
+ControllerInputSnapshot TinkerThinkerBoard::getControllerSnapshot(int idx) const {
+    if (idx < 0 || idx >= BP32_MAX_GAMEPADS) return ControllerInputSnapshot();
+    return telemetry.controllers[idx].read();
 }
@@ -4,21 +4,16 @@
 #include "MotorController.h"
 #include "ServoController.h"
 #include "LEDController.h"
+#include "LEDFrameStream.h"
 #include "BatteryMonitor.h"
 #include "SystemMonitor.h"
 #include "WebServerManager.h"
 #include "ConfigManager.h"
+#include "TelemetrySnapshot.h"
+#include <atomic>
 #include <functional>
 #include <Bluepad32.h>
 
-struct ControllerInputSnapshot {
-    bool     connected = false;
-    uint32_t buttons   = 0;
-    uint8_t  dpad      = 0;
-    int16_t  axisX = 0, axisY = 0, axisRX = 0, axisRY = 0;
-    uint32_t updatedMs = 0;
-};
-
 class TinkerThinkerBoard {
 public:
     TinkerThinkerBoard(ConfigManager* configManager);
@@ -41,6 +36,7 @@ public:
     void requestDriveOtherFromWS(int axisX, int axisY, bool swapSides = false);
     void requestMotorDirectFromBT(int motorIndex, int pwmValue);
     void requestMotorDirectFromWS(int motorIndex, int pwmValue);
+    void requestMotorRawFromWS(int motorIndex, int pwmValue);   // ohne Deadband, sonst wie Direct
     void requestMotorStopFromWS(int motorIndex);
     void setMotorLeftGUI(int motorIndex);
     void setMotorRightGUI(int motorIndex);
@@ -50,11 +46,19 @@ public:
     int getServoAngle(int servoIndex);
 
     // LED-Steuerung
-    void setLED(int led, uint8_t r, uint8_t g, uint8_t b);
+    void setLED(int led, uint8_t r, uint8_t g, uint8_t b);              // globaler Index über alle Ausgänge
+    void setOutputLED(int output, int led, uint8_t r, uint8_t g, uint8_t b); // Index innerhalb eines Ausgangs
+    int getLedOutputCount(int output);
     void showLEDs();
     CRGB getLEDColor(int ledIndex);
     void setLedBrightness(uint8_t value);
     void setLedGamma(bool enabled);
+    void updateLedPowerBudget();
+    uint32_t getLedPowerBudget();
+    uint32_t getLedEstimatedPower();
+    uint8_t getLedAppliedBrightness();
+    bool handleLEDStreamFrame(const uint8_t* data, size_t len);
+    LEDStreamStats getLEDStreamStats();
 
     // Batteriemessung
     float getBatteryVoltage();
@@ -62,11 +66,22 @@ public:
 
     float getHBridgeAmps(int motorIndex);
 
+    // Telemetrie: Messwerte in den Snapshot schreiben (TelemetryTask), Leser blockieren nicht
+    void sampleTelemetry(uint32_t nowMs);
+    // Quelle, die fahren durfte, schweigt länger als ihr Timeout: Motoren stoppen, Kontrolle abgeben
+    void checkCommandTimeouts(uint32_t nowMs);
+    const TelemetrySnapshot& getTelemetry() const { return telemetry; }
+
     // Webserver-Update
     void updateWebClients();
     void requestWifiDisable(bool untilRestart);
     void requestWifiEnable();
     bool isWifiDisabledUntilRestart();
+    WifiState getWifiState();
+    WifiRadioStats getWifiRadioStats();
+    uint8_t getWsClientCount();
+    uint16_t getWsTxQueueMax();
+    uint32_t getLastWsControlMs();
 
     int getMotorPWM(int motorIndex);
     void setSpeedMultiplier(float m);
@@ -76,19 +91,35 @@ public:
     void notifyControllerDisconnected(int slot);
     void updateControllerSnapshot(int idx, ControllerPtr ctl);
     void clearControllerSnapshot(int idx);
-    const ControllerInputSnapshot& getControllerSnapshot(int idx) const;
+    ControllerInputSnapshot getControllerSnapshot(int idx) const;
     void setWhitelistApplyCallback(std::function<void()> cb);
 
 private:
     enum class ControlSource { None, Bluetooth, WebSocket };
-    ControlSource lastSource = ControlSource::None;
+    // Arbiter: Befehle kommen aus loop() (BT) und AsyncTCP (WS), der Timeout prüft im
+    // TelemetryTask. Annehmen und Ausführen eines Befehls sowie der Timeout laufen unter diesem
+    // Lock, sonst stoppt der Timeout einen eben angenommenen Befehl.
+    SemaphoreHandle_t arbiterMutex = xSemaphoreCreateMutex();
+    std::atomic<ControlSource> lastSource{ControlSource::None};   // geschrieben nur unter dem Lock
     uint32_t lastActiveMs = 0;
     const int neutralThreshold = 16; // axis deadband for arbitration
 
+    // Befehls-Timeout je Quelle. Die Website wiederholt gehaltene Eingaben (Keepalive alle
+    // 200 ms); Bluepad32 meldet nur Änderungen, dort beendet erst der Disconnect die Fahrt.
+    static const uint32_t WS_COMMAND_TIMEOUT_MS = 500;
+    static const int CONTROL_SOURCE_COUNT = 3;
+    std::atomic<uint32_t> lastCommandMs[CONTROL_SOURCE_COUNT] = {};
+    std::atomic<bool> commandArmed[CONTROL_SOURCE_COUNT] = {};   // Befehl seit dem letzten Timeout
+    static uint32_t commandTimeoutMs(ControlSource src) {
+        return src == ControlSource::WebSocket ? WS_COMMAND_TIMEOUT_MS : 0;
+    }
+
     bool isNeutralAxes(int x, int y) {
         return (abs(x) <= neutralThreshold && abs(y) <= neutralThreshold);
     }
-    bool shouldAccept(ControlSource src, bool isActive);
+    bool shouldAccept(ControlSource src, bool isActive);   // nur unter arbiterMutex
+    void lockArbiter() { xSemaphoreTake(arbiterMutex, portMAX_DELAY); }
+    void unlockArbiter() { xSemaphoreGive(arbiterMutex); }
     void applyDrive(int axisX, int axisY, bool swapSides = false);
     void applyDriveOther(int axisX, int axisY, bool swapSides = false);
     void getOtherPair(int &leftIdx, int &rightIdx);
@@ -97,9 +128,10 @@ private:
     ConfigManager* config;
     MotorController* motorController;
     ServoController* servoController;
-    LEDController* ledController;
-    BatteryMonitor* batteryMonitor;
-    SystemMonitor* systemMonitor;
+    LEDController* ledController = nullptr;
+    LEDFrameStream ledStream;
+    BatteryMonitor* batteryMonitor = nullptr;
+    SystemMonitor* systemMonitor = nullptr;
     WebServerManager* webServerManager;
 
     // Werte aus Config lesen
@@ -109,7 +141,17 @@ private:
     ServoMotor servos[SERVO_COUNT];
     int motorLeftGUI = 2;
     int motorRightGUI = 3;
-    ControllerInputSnapshot controllerSnapshots[BP32_MAX_GAMEPADS];
+    static const uint32_t LED_POWER_MIN_MW = 300;   // Status-LED bleibt sichtbar
+
+    // Abtastraten der Telemetrie-Abschnitte; das LED-Budget folgt den Leistungswerten
+    static const uint32_t TELEMETRY_TASK_MS = 50;
+    static const uint32_t TELEMETRY_POWER_MS = 500;
+    static const uint32_t TELEMETRY_ACTUATOR_MS = 100;
+    static const uint32_t TELEMETRY_LED_MS = 250;
+    TelemetrySnapshot telemetry;
+    uint32_t lastPowerSampleMs = 0;
+    uint32_t lastActuatorSampleMs = 0;
+    uint32_t lastLedSampleMs = 0;
 };
 
 #endif
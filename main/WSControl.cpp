@@ -0,0 +1,423 @@
+#include "WSControl.h"
+#include <ArduinoJson.h>
+
+namespace WSControl {
+
+static inline uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline int16_t readI16(const uint8_t* p) { return (int16_t)readU16(p); }
+static inline uint32_t readU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Nutzdatenlänge je Record-Tag, -1 = unbekannt
+static int payloadSize(uint8_t tag) {
+    switch (tag) {
+        case TAG_DRIVE:          return 4;
+        case TAG_MOTOR:          return 3;
+        case TAG_MOTOR_STOP:     return 1;
+        case TAG_MOTOR_RAW:      return 3;
+        case TAG_SERVO:          return 2;
+        case TAG_LED_RANGE:      return 8;
+        case TAG_LED_BRIGHTNESS: return 1;
+    }
+    return -1;
+}
+
+void JsonArena::reset() {
+    used = 0;
+    stats.messages++;
+}
+
+void* JsonArena::allocate(size_t size) {
+    size_t need = blockSize(size);
+    if (need > SIZE - used) {
+        stats.heapAllocs++;
+        return malloc(size);
+    }
+    uint8_t* block = buffer + used;
+    *(size_t*)block = size;
+    used += need;
+    stats.allocs++;
+    if (used > stats.peak) stats.peak = used;
+    return block + ALIGN;
+}
+
+void JsonArena::deallocate(void* ptr) {
+    // Arena-Blöcke werden erst mit reset() frei
+    if (ptr && !owns(ptr)) free(ptr);
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+    if (!ptr) return allocate(newSize);
+    if (!owns(ptr)) {
+        stats.heapAllocs++;
+        return realloc(ptr, newSize);
+    }
+    uint8_t* block = (uint8_t*)ptr - ALIGN;
+    size_t oldSize = *(size_t*)block;
+    if (block + blockSize(oldSize) == buffer + used) {
+        // Letzter Block (wachsender String, shrinkToFit eines Pools): an Ort und Stelle
+        size_t offset = block - buffer;
+        if (blockSize(newSize) <= SIZE - offset) {
+            *(size_t*)block = newSize;
+            used = offset + blockSize(newSize);
+            if (used > stats.peak) stats.peak = used;
+            return ptr;
+        }
+    } else if (newSize <= oldSize) {
+        *(size_t*)block = newSize;
+        return ptr;
+    }
+    void* moved = allocate(newSize);
+    if (moved) memcpy(moved, ptr, oldSize < newSize ? oldSize : newSize);
+    return moved;
+}
+
+bool isBinaryControlFrame(const uint8_t* data, size_t len) {
+    return data && len >= HEADER_SIZE && data[0] == MSG_TYPE && data[1] == VERSION;
+}
+
+bool handleBinary(const uint8_t* data, size_t len, ControlSink& sink, FrameHeader* header) {
+    if (!isBinaryControlFrame(data, len)) return false;
+
+    // 1. Durchlauf: Struktur prüfen, damit kein halber Frame ausgeführt wird
+    size_t pos = HEADER_SIZE;
+    while (pos < len) {
+        int n = payloadSize(data[pos]);
+        if (n < 0 || pos + 1 + (size_t)n > len) return false;
+        pos += 1 + (size_t)n;
+    }
+    if (header) {
+        header->seq = readU16(data + 2);
+        header->clientMs = readU32(data + 4);
+    }
+
+    // 2. Durchlauf: ausführen
+    pos = HEADER_SIZE;
+    while (pos < len) {
+        uint8_t tag = data[pos];
+        const uint8_t* p = data + pos + 1;
+        switch (tag) {
+            case TAG_DRIVE: {
+                int x = constrain((int)readI16(p), -512, 512);
+                int y = constrain((int)readI16(p + 2), -512, 512);
+                sink.drive(-y, x); // gleiche Achsenrotation wie im JSON-Pfad
+                break;
+            }
+            case TAG_MOTOR:
+                if (p[0] < 4) sink.motor(p[0], constrain((int)readI16(p + 1), -255, 255));
+                break;
+            case TAG_MOTOR_STOP:
+                if (p[0] < 4) sink.motorStop(p[0]);
+                break;
+            case TAG_MOTOR_RAW:
+                if (p[0] < 4) sink.motorRaw(p[0], constrain((int)readI16(p + 1), -255, 255));
+                break;
+            case TAG_SERVO:
+                if (p[0] < 7) sink.servo(p[0], p[1]);
+                break;
+            case TAG_LED_RANGE:
+                sink.ledRange(p[0] == 0xFF ? -1 : p[0], readU16(p + 1), readU16(p + 3), p[5], p[6], p[7]);
+                break;
+            case TAG_LED_BRIGHTNESS:
+                sink.ledBrightness(p[0]);
+                break;
+        }
+        pos += 1 + (size_t)payloadSize(tag);
+    }
+    sink.commit();
+    return true;
+}
+
+// ---- JSON-Befehle ----
+// Das empfangene Objekt wird genau einmal durchlaufen; jeder Schlüssel wird über eine zur
+// Compile-Zeit gebaute perfekte Hashtabelle einem typisierten Handler zugeordnet. Die Kosten
+// hängen damit nur von den gesendeten Schlüsseln ab, nicht von der Zahl der Befehle.
+
+namespace {
+
+struct JsonDispatch {
+    ControlSink& sink;
+    bool hasX = false, hasY = false;
+    float x = 0, y = 0;
+};
+
+typedef void (*JsonHandler)(JsonVariantConst value, uint8_t arg, JsonDispatch& d);
+
+struct JsonCommand {
+    const char* key;
+    JsonHandler handler;
+    uint8_t arg;   // z. B. Motor- oder Servo-Index
+};
+
+void onX(JsonVariantConst v, uint8_t, JsonDispatch& d) { d.x = v.as<float>(); d.hasX = !v.isNull(); }
+void onY(JsonVariantConst v, uint8_t, JsonDispatch& d) { d.y = v.as<float>(); d.hasY = !v.isNull(); }
+
+// {"motorA": "forward"|"backward"|"stop"|<pwm>}
+void onMotor(JsonVariantConst v, uint8_t i, JsonDispatch& d) {
+    if (v.isNull()) return;
+    const char* command = v.as<const char*>();
+    if (command && !strcmp(command, "forward")) {
+        d.sink.motor(i, 255);
+    } else if (command && !strcmp(command, "backward")) {
+        d.sink.motor(i, -255);
+    } else if (command && !strcmp(command, "stop")) {
+        d.sink.motorStop(i);
+    } else {// Direkte PWM-Steuerung (Zahl oder Zahl als String)
+        int pwmValue = command ? atoi(command) : v.as<int>();
+        d.sink.motor(i, constrain(pwmValue, -255, 255));
+    }
+}
+
+// Raw Motor PWM (bypasses deadband, used by setup): {"motor_raw":{"motor":0,"pwm":-120}}
+void onMotorRaw(JsonVariantConst v, uint8_t, JsonDispatch& d) {
+    JsonObjectConst raw = v.as<JsonObjectConst>();
+    if (raw.isNull()) return;
+    int idx = raw["motor"] | -1;
+    int pwm = raw["pwm"] | 0;
+    if (idx >= 0 && idx < 4) {
+        d.sink.motorRaw(idx, constrain(pwm, -255, 255));
+    }
+}
+
+// {"servo0": <angle>, ... "servo6": <angle>}
+void onServo(JsonVariantConst v, uint8_t i, JsonDispatch& d) {
+    if (!v.isNull()) d.sink.servo(i, v.as<int>());
+}
+
+// LED set (expects {"led_set":{"start":0,"count":1,"color":"#RRGGBB"}})
+// Optional "output": start zählt dann innerhalb dieses Ausgangs, sonst global über alle Ausgänge
+void onLedSet(JsonVariantConst v, uint8_t, JsonDispatch& d) {
+    JsonObjectConst led = v.as<JsonObjectConst>();
+    if (led.isNull()) return;
+    int output = led["output"] | -1;
+    int start = led["start"] | 0;
+    int count = led["count"] | 1;
+    const char* color = led["color"] | "#000000";
+    long rgb = strtol(color + 1, nullptr, 16);
+    d.sink.ledRange(output, start, count, (rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+}
+
+// LED-Helligkeit live setzen (Vorschau, ohne Speichern): {"led_brightness":0-255}
+void onLedBrightness(JsonVariantConst v, uint8_t, JsonDispatch& d) {
+    if (!v.isNull()) d.sink.ledBrightness((uint8_t)constrain(v.as<int>(), 0, 255));
+}
+
+// Gamma live umschalten: {"led_gamma":true|false}
+void onLedGamma(JsonVariantConst v, uint8_t, JsonDispatch& d) {
+    if (!v.isNull()) d.sink.ledGamma(v.as<bool>());
+}
+
+// Swap-Flag, falls von der UI gesendet: {"swap":true|false}
+void onSwap(JsonVariantConst v, uint8_t, JsonDispatch& d) {
+    if (!v.isNull()) d.sink.swap(v.as<bool>());
+}
+
+// Telemetrie-Rate des sendenden Clients: {"telemetry_hz": 0-10}
+void onTelemetryHz(JsonVariantConst v, uint8_t, JsonDispatch& d) {
+    if (!v.isNull()) d.sink.telemetryRate(v.as<int>());
+}
+
+// Telemetrie-Themen abonnieren: {"subscribe": {"power": 1, "controllers": 10}}, fehlende = aus
+void onSubscribe(JsonVariantConst v, uint8_t, JsonDispatch& d) {
+    JsonObjectConst topics = v.as<JsonObjectConst>();
+    if (topics.isNull()) return;
+    uint8_t hz[TOPIC_COUNT] = {};
+    for (JsonPairConst kv : topics) {
+        for (int t = 0; t < TOPIC_COUNT; t++) {
+            if (!strcmp(kv.key().c_str(), TOPIC_NAMES[t])) hz[t] = (uint8_t)constrain(kv.value().as<int>(), 0, 255);
+        }
+    }
+    d.sink.telemetrySubscribe(hz);
+}
+
+// Antwort auf {"ping": t1}: {"pong": [t1, t2, t3]}, t2/t3 = Empfang/Versand beim Client in ms
+void onPong(JsonVariantConst v, uint8_t, JsonDispatch& d) {
+    JsonArrayConst a = v.as<JsonArrayConst>();
+    if (a.size() != 3) return;
+    d.sink.pong(a[0].as<uint32_t>(), a[1].as<double>(), a[2].as<double>());
+}
+
+// Sendezeit eines Befehls in der Uhr des Clients: {"ts": ms, "x": ..., "y": ...}
+void onTimestamp(JsonVariantConst v, uint8_t, JsonDispatch& d) {
+    if (!v.isNull()) d.sink.clientTimestamp(v.as<uint32_t>());
+}
+
+// Neue Befehle: hier eine Zeile ergänzen, die Hashtabelle wird beim Übersetzen neu gebaut
+constexpr JsonCommand JSON_COMMANDS[] = {
+    { "x",              onX,             0 },
+    { "y",              onY,             0 },
+    { "motorA",         onMotor,         0 },
+    { "motorB",         onMotor,         1 },
+    { "motorC",         onMotor,         2 },
+    { "motorD",         onMotor,         3 },
+    { "motor_raw",      onMotorRaw,      0 },
+    { "servo0",         onServo,         0 },
+    { "servo1",         onServo,         1 },
+    { "servo2",         onServo,         2 },
+    { "servo3",         onServo,         3 },
+    { "servo4",         onServo,         4 },
+    { "servo5",         onServo,         5 },
+    { "servo6",         onServo,         6 },
+    { "led_set",        onLedSet,        0 },
+    { "led_brightness", onLedBrightness, 0 },
+    { "led_gamma",      onLedGamma,      0 },
+    { "swap",           onSwap,          0 },
+    { "telemetry_hz",   onTelemetryHz,   0 },
+    { "subscribe",      onSubscribe,     0 },
+    { "pong",           onPong,          0 },
+    { "ts",             onTimestamp,     0 },
+};
+constexpr size_t JSON_COMMAND_COUNT = sizeof(JSON_COMMANDS) / sizeof(JSON_COMMANDS[0]);
+
+constexpr size_t HASH_SLOTS = 64;      // Zweierpotenz, deutlich größer als die Befehlszahl
+constexpr uint8_t EMPTY_SLOT = 0xFF;
+constexpr uint32_t NO_SEED = 0xFFFFFFFFu;
+static_assert(JSON_COMMAND_COUNT < EMPTY_SLOT && JSON_COMMAND_COUNT <= HASH_SLOTS, "zu viele JSON-Befehle");
+
+// FNV-1a, mit seed als Variation des Startwerts
+constexpr uint32_t keyHash(const char* s, size_t n, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr size_t keyLength(const char* s) {
+    size_t n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+struct CommandHashTable {
+    uint32_t seed = NO_SEED;
+    uint8_t slot[HASH_SLOTS] = {};
+};
+
+// Sucht den ersten seed, bei dem alle Schlüssel in verschiedenen Slots landen
+constexpr CommandHashTable buildCommandTable() {
+    for (uint32_t seed = 0; seed < 4096; seed++) {
+        CommandHashTable t;
+        for (size_t s = 0; s < HASH_SLOTS; s++) t.slot[s] = EMPTY_SLOT;
+        bool collision = false;
+        for (size_t i = 0; i < JSON_COMMAND_COUNT && !collision; i++) {
+            const char* key = JSON_COMMANDS[i].key;
+            size_t s = keyHash(key, keyLength(key), seed) & (HASH_SLOTS - 1);
+            if (t.slot[s] != EMPTY_SLOT) collision = true;
+            else t.slot[s] = (uint8_t)i;
+        }
+        if (!collision) {
+            t.seed = seed;
+            return t;
+        }
+    }
+    return CommandHashTable();
+}
+
+constexpr CommandHashTable COMMAND_TABLE = buildCommandTable();
+static_assert(COMMAND_TABLE.seed != NO_SEED, "keine kollisionsfreie Hashtabelle gefunden, HASH_SLOTS erhöhen");
+
+const JsonCommand* findCommand(const char* key, size_t len) {
+    uint8_t i = COMMAND_TABLE.slot[keyHash(key, len, COMMAND_TABLE.seed) & (HASH_SLOTS - 1)];
+    if (i == EMPTY_SLOT) return nullptr;
+    const JsonCommand* cmd = &JSON_COMMANDS[i];
+    // Slot ist eindeutig für bekannte Schlüssel; unbekannte können trotzdem dort landen
+    if (strncmp(cmd->key, key, len) != 0 || cmd->key[len] != '\0') return nullptr;
+    return cmd;
+}
+
+}
+
+bool handleJson(const uint8_t* data, size_t len, ControlSink& sink, JsonArena* arena, uint32_t* unknownKeys) {
+    if (arena) arena->reset();
+    JsonDocument doc(arena ? (ArduinoJson::Allocator*)arena : ArduinoJson::detail::DefaultAllocator::instance());
+    DeserializationError error = deserializeJson(doc, (const char*)data, len);
+    if (error) return false;
+    JsonObjectConst obj = doc.as<JsonObjectConst>();
+    if (obj.isNull()) return false;
+
+    JsonDispatch d{ sink };
+    for (JsonPairConst kv : obj) {
+        JsonString key = kv.key();
+        const JsonCommand* cmd = findCommand(key.c_str(), key.size());
+        if (!cmd) {
+            if (unknownKeys) (*unknownKeys)++;
+            continue;
+        }
+        cmd->handler(kv.value(), cmd->arg, d);
+    }
+
+    // Joystick erst, wenn beide Achsen da sind
+    if (d.hasX && d.hasY) {
+        // Achsenrotation
+        float rotatedX = -d.y;
+        float rotatedY = d.x;
+        sink.drive((int)(rotatedX * 512), (int)(rotatedY * 512));
+    }
+    sink.commit();
+    return true;
+}
+
+namespace {
+class CountingSink : public ControlSink {
+public:
+    uint32_t calls = 0;
+    void drive(int, int) override { calls++; }
+    void motor(int, int) override { calls++; }
+    void motorStop(int) override { calls++; }
+    void motorRaw(int, int) override { calls++; }
+    void servo(int, int) override { calls++; }
+    void ledRange(int, int, int, uint8_t, uint8_t, uint8_t) override { calls++; }
+    void ledBrightness(uint8_t) override { calls++; }
+    void ledGamma(bool) override { calls++; }
+    void swap(bool) override { calls++; }
+};
+}
+
+BenchResult benchmark(uint32_t iterations) {
+    // Typische Frames der Web-UI: Joystick + Servo, Motortaste, LED-Bereich
+    static const char* const jsonFrames[] = {
+        "{\"x\":0.5123,\"y\":-0.2511,\"servo0\":90}",
+        "{\"motorA\":\"forward\"}",
+        "{\"led_set\":{\"start\":0,\"count\":8,\"color\":\"#00ff00\"}}",
+    };
+    static const uint8_t binDrive[] = { 'C', VERSION, 1, 0, 0x10, 0x27, 0, 0,
+                                        TAG_DRIVE, 0x06, 0x01, 0x80, 0xFF, TAG_SERVO, 0, 90 };
+    static const uint8_t binMotor[] = { 'C', VERSION, 2, 0, 0x20, 0x27, 0, 0,
+                                        TAG_MOTOR, 0, 0xFF, 0x00 };
+    static const uint8_t binLed[]   = { 'C', VERSION, 3, 0, 0x30, 0x27, 0, 0,
+                                        TAG_LED_RANGE, 0xFF, 0, 0, 8, 0, 0x00, 0xFF, 0x00 };
+    static const struct { const uint8_t* data; size_t len; } binFrames[] = {
+        { binDrive, sizeof(binDrive) }, { binMotor, sizeof(binMotor) }, { binLed, sizeof(binLed) },
+    };
+    const size_t kinds = sizeof(binFrames) / sizeof(binFrames[0]);
+
+    BenchResult res;
+    res.iterations = iterations;
+    CountingSink sink;
+    // Eigene Arena (statisch, nicht auf dem Stack des Aufrufers); die des WebSockets gehört dem AsyncTCP-Task
+    static JsonArena arena;
+    uint32_t heapBefore = arena.getStats().heapAllocs;
+
+    uint32_t t0 = micros();
+    for (uint32_t i = 0; i < iterations; i++) {
+        const char* f = jsonFrames[i % kinds];
+        size_t n = strlen(f);
+        handleJson((const uint8_t*)f, n, sink, &arena);
+        res.jsonBytes += n;
+    }
+    res.jsonUs = micros() - t0;
+    res.jsonHeapAllocs = arena.getStats().heapAllocs - heapBefore;
+
+    t0 = micros();
+    for (uint32_t i = 0; i < iterations; i++) {
+        handleBinary(binFrames[i % kinds].data, binFrames[i % kinds].len, sink);
+        res.binaryBytes += binFrames[i % kinds].len;
+    }
+    res.binaryUs = micros() - t0;
+    return res;
+}
+
+}
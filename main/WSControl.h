@@ -0,0 +1,136 @@
+#ifndef WS_CONTROL_H
+#define WS_CONTROL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Steuerbefehle über den WebSocket – JSON (Text) oder kompakt binär.
+//
+// Binärformat v1 (Opcode BINARY, little endian), ausgehandelt über den Subprotocol
+// "tt-ctl.1" (der Browser sieht ws.protocol === "tt-ctl.1", ältere Firmware antwortet ohne):
+//   [0]    'C'  Nachrichtentyp (LED-Frames benutzen 'L', siehe LEDFrameStream.h)
+//   [1]    Version (1)
+//   [2..3] Sequenznummer (uint16, läuft über)
+//   [4..7] Zeitstempel des Clients in ms (uint32)
+//   [8..]  Records: Tag (u8) + Nutzdaten
+//     0x01 DRIVE       x i16, y i16          Joystick, ±512 entspricht ±1.0 im JSON
+//     0x02 MOTOR       idx u8, pwm i16       wie {"motorA": pwm}
+//     0x03 MOTOR_STOP  idx u8                wie {"motorA": "stop"}
+//     0x04 MOTOR_RAW   idx u8, pwm i16       wie {"motor_raw": {...}}
+//     0x05 SERVO       idx u8, angle u8      wie {"servo0": angle}
+//     0x06 LED_RANGE   out u8, start u16, count u16, r, g, b   (out 0xFF = globaler Index)
+//     0x07 LED_BRIGHT  value u8
+// Ein Frame wird erst vollständig geprüft und dann ausgeführt; dabei wird kein Heap benutzt.
+namespace WSControl {
+
+static const char* const BINARY_PROTOCOL = "tt-ctl.1";
+static const uint8_t MSG_TYPE = 'C';
+static const uint8_t VERSION = 1;
+static const size_t HEADER_SIZE = 8;
+
+enum Tag : uint8_t {
+    TAG_DRIVE = 0x01,
+    TAG_MOTOR = 0x02,
+    TAG_MOTOR_STOP = 0x03,
+    TAG_MOTOR_RAW = 0x04,
+    TAG_SERVO = 0x05,
+    TAG_LED_RANGE = 0x06,
+    TAG_LED_BRIGHTNESS = 0x07,
+};
+
+// Ziel der dekodierten Befehle (Board im Betrieb, Zähler im Benchmark)
+class ControlSink {
+public:
+    virtual ~ControlSink() {}
+    virtual void drive(int x, int y) = 0;              // bereits rotiert, ±512
+    virtual void motor(int index, int pwm) = 0;
+    virtual void motorStop(int index) = 0;
+    virtual void motorRaw(int index, int pwm) = 0;
+    virtual void servo(int index, int angle) = 0;
+    virtual void ledRange(int output, int start, int count, uint8_t r, uint8_t g, uint8_t b) = 0; // output -1 = global
+    virtual void ledBrightness(uint8_t value) = 0;
+    virtual void ledGamma(bool enabled) = 0;
+    virtual void swap(bool enabled) = 0;
+    virtual void telemetryRate(int /*hz*/) {}              // nur für den sendenden Client
+    virtual void telemetrySubscribe(const uint8_t* /*topicHz*/) {} // TOPIC_COUNT Raten, 0 = aus
+    // Laufzeitmessung: Antwort auf {"ping": t1} mit Empfangs-/Sendezeit des Clients (ms, performance.now())
+    virtual void pong(uint32_t /*t1Us*/, double /*t2Ms*/, double /*t3Ms*/) {}
+    virtual void clientTimestamp(uint32_t /*clientMs*/) {}    // {"ts": ms} – Sendezeit des Befehls
+    virtual void commit() {} // nach jedem Frame (z. B. LEDs anzeigen)
+};
+
+// Telemetrie-Themen für {"subscribe": {"<thema>": hz, ...}}
+enum TelemetryTopic : uint8_t {
+    TOPIC_POWER,        // batteryVoltage, batteryPercentage
+    TOPIC_MOTORS,       // motorPWMs, motorCurrents
+    TOPIC_SERVOS,       // servos
+    TOPIC_LEDS,         // firstLED, ledPower, ledStream
+    TOPIC_CONTROLLERS,  // controllers
+    TOPIC_DIAGNOSTICS,  // wsControl, wsClients
+    TOPIC_COUNT
+};
+static const char* const TOPIC_NAMES[TOPIC_COUNT] = {
+    "power", "motors", "servos", "leds", "controllers", "diagnostics"
+};
+
+struct FrameHeader {
+    uint16_t seq = 0;
+    uint32_t clientMs = 0;
+};
+
+// Allocator für JsonDocument auf einem festen Speicherblock: Zuteilung per Zeigervorschub,
+// Freigabe ist wirkungslos, reset() vor jeder Nachricht gibt alles auf einmal zurück.
+// Passt eine Anforderung nicht mehr hinein, wird auf den Heap ausgewichen und das gezählt –
+// im Normalbetrieb muss heapAllocs also 0 bleiben.
+struct ArenaStats {
+    uint32_t messages = 0;
+    uint32_t allocs = 0;      // Zuteilungen aus dem Arena-Speicher
+    uint32_t heapAllocs = 0;  // Ausweichen auf malloc/realloc (Arena zu klein)
+    uint32_t peak = 0;        // höchster Füllstand in Byte
+};
+
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    // Reicht für die Slot-Pools einer Steuernachricht (1 KB je Pool) plus Schlüssel/Strings
+    static const size_t SIZE = 4096;
+
+    void reset();
+    const ArenaStats& getStats() const { return stats; }
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+private:
+    static const size_t ALIGN = 8;   // Blockkopf (Größe) + Ausrichtung der Nutzdaten
+    alignas(8) uint8_t buffer[SIZE];
+    size_t used = 0;
+    ArenaStats stats;
+
+    bool owns(const void* ptr) const {
+        return (const uint8_t*)ptr >= buffer && (const uint8_t*)ptr < buffer + SIZE;
+    }
+    static size_t blockSize(size_t size) { return ALIGN + ((size + ALIGN - 1) & ~(ALIGN - 1)); }
+};
+
+bool isBinaryControlFrame(const uint8_t* data, size_t len);
+bool handleBinary(const uint8_t* data, size_t len, ControlSink& sink, FrameHeader* header = nullptr);
+// Parst direkt aus dem Frame-Puffer; mit arena ohne Heap (arena wird dabei zurückgesetzt).
+// Jeder Schlüssel wird einmal über eine Hashtabelle zugeordnet, unbekannte zählen nach unknownKeys.
+bool handleJson(const uint8_t* data, size_t len, ControlSink& sink, JsonArena* arena = nullptr,
+                uint32_t* unknownKeys = nullptr);
+
+struct BenchResult {
+    uint32_t iterations = 0;
+    uint32_t jsonUs = 0;
+    uint32_t binaryUs = 0;
+    uint32_t jsonBytes = 0;
+    uint32_t binaryBytes = 0;
+    uint32_t jsonHeapAllocs = 0;
+};
+// Dekodiert typische Joystick-/Motor-/Servo-Frames in beiden Formaten gegen einen Zähler-Sink
+BenchResult benchmark(uint32_t iterations);
+
+}
+
+#endif
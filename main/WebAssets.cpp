@@ -0,0 +1,75 @@
+#include "WebAssets.h"
+
+#if CONFIG_TT_EMBED_WEB_UI
+
+int EmbeddedAssetHandler::findPath(const char* path) {
+    // Tabelle ist nach strcmp sortiert
+    int lo = 0, hi = (int)WEB_ASSET_COUNT - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int c = strcmp(path, WEB_ASSETS[mid].path);
+        if (c == 0) return mid;
+        if (c < 0) hi = mid - 1;
+        else lo = mid + 1;
+    }
+    return -1;
+}
+
+int EmbeddedAssetHandler::find(const String& url) {
+    if (url == "/") return findPath("/index.html");
+    int i = findPath(url.c_str());
+    if (i >= 0 || url.indexOf('.') >= 0) return i;
+    // Seiten ohne Endung: /config -> /config.html
+    char page[48];
+    if (url.length() + 6 > sizeof(page)) return -1;
+    snprintf(page, sizeof(page), "%s.html", url.c_str());
+    return findPath(page);
+}
+
+void EmbeddedAssetHandler::scanOverrides(fs::FS& fs) {
+    overrideFs = &fs;
+    overridden.assign(WEB_ASSET_COUNT, false);
+    File dir = fs.open(OVERRIDE_DIR);
+    if (!dir || !dir.isDirectory()) return;
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        String name = String("/") + f.name();
+        if (name.endsWith(".gz")) name.remove(name.length() - 3);
+        int i = findPath(name.c_str());
+        if (i >= 0) {
+            overridden[i] = true;
+            Serial.printf("WebAssets: %s aus LittleFS%s\n", name.c_str(), OVERRIDE_DIR);
+        }
+    }
+}
+
+bool EmbeddedAssetHandler::canHandle(AsyncWebServerRequest* request) const {
+    return request->isHTTP() && request->method() == HTTP_GET && find(request->url()) >= 0;
+}
+
+void EmbeddedAssetHandler::handleRequest(AsyncWebServerRequest* request) {
+    int i = find(request->url());
+    if (i < 0) {
+        request->send(404);
+        return;
+    }
+    const WebAsset& a = WEB_ASSETS[i];
+    if (overrideFs && i < (int)overridden.size() && overridden[i]) {
+        request->send(*overrideFs, String(OVERRIDE_DIR) + a.path, a.mime);
+        return;
+    }
+
+    const char* cacheControl = a.immutable ? "public, max-age=31536000, immutable" : "no-cache";
+    AsyncWebServerResponse* response;
+    if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == a.etag) {
+        response = request->beginResponse(304);
+    } else {
+        // Antwort liest in Häppchen direkt aus dem Flash, ohne Kopie
+        response = request->beginResponse(200, a.mime, a.data, a.len);
+        if (a.gzipped) response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", a.etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <FS.h>
+#include <vector>
+
+// Web-Oberfläche im Firmware-Image (CONFIG_TT_EMBED_WEB_UI, siehe Kconfig.projbuild).
+// tools/build_web_assets.py --embed erzeugt beim Bauen aus data/ eine nach Pfad sortierte
+// Tabelle in .rodata; ausgeliefert wird direkt aus dem Flash, ohne Dateisystemzugriff.
+struct WebAsset {
+    const char* path;       // URL-Pfad, z. B. "/index.html" oder "/a/script.736ed906.js"
+    const char* mime;
+    const uint8_t* data;
+    uint32_t len;
+    const char* etag;       // Inhalts-Hash in Anführungszeichen
+    bool gzipped;
+    bool immutable;         // Name enthält den Inhalts-Hash: unbegrenzt cachebar
+};
+
+extern const WebAsset WEB_ASSETS[];
+extern const size_t WEB_ASSET_COUNT;
+
+// Bedient alle Pfade der Tabelle ("/" und "/config" usw. als Seiten-Aliase). Eine Datei gleichen
+// Namens unter /www/ auf LittleFS ersetzt den Eintrag (einmal beim Start geprüft); Pfade, die
+// nicht in der Tabelle stehen, fallen auf die LittleFS-Routen durch.
+class EmbeddedAssetHandler : public AsyncWebHandler {
+public:
+    static constexpr const char* OVERRIDE_DIR = "/www";
+
+    void scanOverrides(fs::FS& fs);
+    bool canHandle(AsyncWebServerRequest* request) const override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+
+private:
+    fs::FS* overrideFs = nullptr;
+    std::vector<bool> overridden;
+
+    static int find(const String& url);
+    static int findPath(const char* path);
+};
+
+#endif
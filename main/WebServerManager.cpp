@@ -1,8 +1,258 @@
 #include "WebServerManager.h"
 #include "TinkerThinkerBoard.h"
 #include "ConfigManager.h"
+#include "WebAssets.h"
+#include "BootTimeline.h"
+#include <Preferences.h>
+#include <algorithm>
 #include <utility>
 
+namespace {
+// Pong auswerten: t1/t4 in µs der Firmware, t2/t3 in ms des Clients (performance.now())
+void updateClockSync(WSClientState* s, uint32_t t1Us, double t2Ms, double t3Ms, uint32_t t4Us, uint32_t t4Ms) {
+    uint32_t elapsedUs = t4Us - t1Us;
+    double turnaroundUs = (t3Ms - t2Ms) * 1000.0;
+    // Verspätete Antwort (mehrere Pings offen) oder unplausible Client-Zeiten verwerfen
+    if (elapsedUs > 10 * WS_PING_INTERVAL_MS * 1000UL || turnaroundUs < 0 || turnaroundUs > elapsedUs) return;
+    uint32_t rtt = elapsedUs - (uint32_t)turnaroundUs;
+    // Client hat um t3 gesendet, bei der Firmware kam es nach der halben Laufzeit an
+    uint32_t clientSendMs = (uint32_t)(int64_t)llround(t3Ms);
+    int32_t offset = (int32_t)(clientSendMs - (t4Ms - (rtt + 1000) / 2000));
+
+    s->rttSampleUs[s->clockNext] = rtt;
+    s->offsetSampleMs[s->clockNext] = offset;
+    s->clockNext = (s->clockNext + 1) % WS_CLOCK_SAMPLES;
+    if (s->clockSamples < WS_CLOCK_SAMPLES) s->clockSamples++;
+    int best = 0;
+    for (int i = 1; i < s->clockSamples; i++) {
+        if (s->rttSampleUs[i] < s->rttSampleUs[best]) best = i;
+    }
+    s->rttMinUs = s->rttSampleUs[best];
+    s->clockOffsetMs = s->offsetSampleMs[best];
+    s->clockValid = true;
+    s->rttUs = s->pongs++ ? s->rttUs + ((int32_t)(rtt - s->rttUs)) / 8 : rtt;
+    uint32_t div = 1 + s->rttUs / (WS_TELEMETRY_RTT_SLOW_MS * 1000UL);
+    s->rateDiv = (uint8_t)(div < WS_TELEMETRY_MAX_RATE_DIV ? div : WS_TELEMETRY_MAX_RATE_DIV);
+}
+
+// Einweglatenz eines vom Client gestempelten Befehls (Binär-Header oder {"ts": ...})
+void noteClientTimestamp(WSClientState* s, uint32_t clientMs, uint32_t nowMs) {
+    if (!s->clockValid) return;
+    int32_t owdMs = (int32_t)(nowMs - (clientMs - (uint32_t)s->clockOffsetMs));
+    if (owdMs < 0) owdMs = 0;   // Auflösung der Zeitstempel (1 ms) und Drift seit dem letzten Ping
+    if (owdMs > 10000) return;   // Uhr des Clients neu gestartet (Reload)
+    s->lastOneWayMs = (uint32_t)owdMs;
+    uint32_t owdUs = (uint32_t)owdMs * 1000;
+    s->oneWayUs = s->oneWayUs ? s->oneWayUs + ((int32_t)(owdUs - s->oneWayUs)) / 8 : owdUs;
+}
+
+// {"ping": t1} mit den bisherigen Schätzwerten, damit der Client sie anzeigen kann
+void sendPing(AsyncWebSocketClient& c, WSClientState* s, uint32_t now) {
+    char msg[160];
+    int n;
+    if (s->clockValid) {
+        n = snprintf(msg, sizeof(msg),
+            "{\"ping\":%u,\"link\":{\"rttMs\":%.1f,\"rttMinMs\":%.1f,\"offsetMs\":%d,\"owdMs\":%.1f,\"rateDiv\":%u}}",
+            (unsigned)micros(), s->rttUs / 1000.0f, s->rttMinUs / 1000.0f, (int)s->clockOffsetMs,
+            s->oneWayUs / 1000.0f, (unsigned)s->rateDiv);
+    } else {
+        n = snprintf(msg, sizeof(msg), "{\"ping\":%u}", (unsigned)micros());
+    }
+    s->lastPingMs = now;
+    if (n > 0 && n < (int)sizeof(msg) && c.text(msg, (size_t)n)) s->pingsSent++;
+}
+
+// Body-Handler für JSON-POSTs: nur in einen malloc-Puffer akkumulieren (free-kompatibel mit
+// ~AsyncWebServerRequest, falls die Verbindung vor onRequest abbricht). onRequest liest
+// request->_tempObject als nullterminierten Text.
+void collectBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (index == 0) {
+        char* buf = (char*)malloc(total + 1);
+        if (buf) buf[total] = '\0';
+        request->_tempObject = buf;
+    }
+    char* buf = reinterpret_cast<char*>(request->_tempObject);
+    if (!buf) return;
+    memcpy(buf + index, data, len);
+}
+
+// Behält von einer vollständigen Ausgabe nur das Stück [from, from + len). Für beginChunkedResponse:
+// jeder Aufruf schreibt den Export neu und kopiert nur das nächste Stück in den Sendepuffer, der
+// Speicherbedarf bleibt damit unabhängig von der Größe der Config. Ist das Stück voll, meldet
+// WindowPrint einen Schreibfehler, und der Export hört beim nächsten Feld auf.
+class WindowPrint : public Print {
+public:
+    WindowPrint(uint8_t* buf, size_t from, size_t len) : buf(buf), from(from), len(len) {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t n) override {
+        size_t start = pos < from ? from - pos : 0;   // Bytes vor dem Fenster
+        if (start < n && pos + start < from + len) {
+            size_t at = pos + start - from;
+            size_t count = std::min(n - start, len - at);
+            memcpy(buf + at, data + start, count);
+        }
+        pos += n;
+        if (pos >= from + len) setWriteError();
+        return n;
+    }
+    size_t filled() const { return pos <= from ? 0 : std::min(pos - from, len); }
+
+private:
+    uint8_t* buf;
+    size_t from, len;
+    size_t pos = 0;
+};
+
+// Config-Export in Stücken. Alle Stücke stammen aus demselben Stand (getGeneration() beim Anlegen
+// der Antwort); ändert sich die Config zwischendurch, wird die Verbindung ohne abschließendes
+// Stück geschlossen, der Client sieht eine abgebrochene Übertragung statt zerrissenem JSON.
+AsyncWebServerResponse* beginConfigResponse(AsyncWebServerRequest* request, ConfigManager* config,
+                                            const char* extraMembers) {
+    uint32_t gen = config->getGeneration();
+    return request->beginChunkedResponse("application/json",
+        [request, config, extraMembers, gen](uint8_t* buf, size_t maxLen, size_t index) -> size_t {
+            WindowPrint window(buf, index, maxLen);
+            if (!config->exportJson(window, extraMembers, gen)) {
+                Serial.println("Config export: Config während der Übertragung geändert, abgebrochen");
+                request->client()->close();
+                return RESPONSE_TRY_AGAIN;
+            }
+            return window.filled();
+        });
+}
+
+// Dekodierte WebSocket-Befehle (JSON oder binär) auf das Board anwenden. Schreibzugriffe auf den
+// Client-Zustand laufen unter stateMutex (wsMutex), WebClientTask liest ihn in sendStatusUpdate().
+class BoardControlSink : public WSControl::ControlSink {
+public:
+    BoardControlSink(TinkerThinkerBoard* b, ConfigManager* c, WSClientState* s = nullptr,
+                     SemaphoreHandle_t m = nullptr)
+        : board(b), config(c), client(s), stateMutex(m) {}
+    void drive(int x, int y) override { board->requestDriveFromWS(x, y); }
+    void motor(int index, int pwm) override { board->requestMotorDirectFromWS(index, pwm); }
+    void motorStop(int index) override { board->requestMotorStopFromWS(index); }
+    void motorRaw(int index, int pwm) override { board->requestMotorRawFromWS(index, pwm); }
+    void servo(int index, int angle) override { board->setServoAngle(index, angle); }
+    void ledRange(int output, int start, int count, uint8_t r, uint8_t g, uint8_t b) override {
+        if (count > LED_MAX_COUNT) count = LED_MAX_COUNT;
+        for (int i = start; i < start + count; i++) {
+            if (output >= 0) board->setOutputLED(output, i, r, g, b);
+            else board->setLED(i, r, g, b);
+        }
+        ledsDirty = true;
+    }
+    void ledBrightness(uint8_t value) override { board->setLedBrightness(value); }
+    void ledGamma(bool enabled) override { board->setLedGamma(enabled); }
+    void swap(bool enabled) override {
+        // Config entsprechend setzen
+        config->setMotorSwap(enabled);
+        config->requestSave();
+    }
+    void telemetryRate(int hz) override {
+        if (!client) return;
+        lockState();
+        for (int t = 0; t < WSControl::TOPIC_COUNT; t++) {
+            client->topicHz[t] = (uint8_t)constrain(hz, 0, WS_TELEMETRY_DEFAULT_HZ);
+        }
+        client->deltas = false;
+        client->subscriptionGen++;
+        unlockState();
+    }
+    void telemetrySubscribe(const uint8_t* topicHz) override {
+        if (!client) return;
+        lockState();
+        for (int t = 0; t < WSControl::TOPIC_COUNT; t++) {
+            client->topicHz[t] = topicHz[t] < WS_TELEMETRY_DEFAULT_HZ ? topicHz[t] : WS_TELEMETRY_DEFAULT_HZ;
+        }
+        client->deltas = true;
+        client->keyframePending = true;
+        client->subscriptionGen++;
+        unlockState();
+    }
+    void pong(uint32_t t1Us, double t2Ms, double t3Ms) override {
+        if (!client) return;
+        lockState();
+        updateClockSync(client, t1Us, t2Ms, t3Ms, micros(), millis());
+        unlockState();
+    }
+    void clientTimestamp(uint32_t clientMs) override {
+        if (!client) return;
+        lockState();
+        noteClientTimestamp(client, clientMs, millis());
+        unlockState();
+    }
+    void commit() override {
+        if (ledsDirty) board->showLEDs();
+        ledsDirty = false;
+    }
+
+private:
+    TinkerThinkerBoard* board;
+    ConfigManager* config;
+    WSClientState* client;
+    SemaphoreHandle_t stateMutex;
+    bool ledsDirty = false;
+
+    void lockState() { if (stateMutex) xSemaphoreTake(stateMutex, portMAX_DELAY); }
+    void unlockState() { if (stateMutex) xSemaphoreGive(stateMutex); }
+};
+
+struct TelemetryFieldDef {
+    const char* key;
+    WSControl::TelemetryTopic topic;
+};
+
+const TelemetryFieldDef TELEMETRY_FIELDS[FIELD_COUNT] = {
+    { "batteryVoltage",    WSControl::TOPIC_POWER },
+    { "batteryPercentage", WSControl::TOPIC_POWER },
+    { "servos",            WSControl::TOPIC_SERVOS },
+    { "motorPWMs",         WSControl::TOPIC_MOTORS },
+    { "motorCurrents",     WSControl::TOPIC_MOTORS },
+    { "firstLED",          WSControl::TOPIC_LEDS },
+    { "ledPower",          WSControl::TOPIC_LEDS },
+    { "ledStream",         WSControl::TOPIC_LEDS },
+    { "wsControl",         WSControl::TOPIC_DIAGNOSTICS },
+    { "controllers",       WSControl::TOPIC_CONTROLLERS },
+    { "wsClients",         WSControl::TOPIC_DIAGNOSTICS },
+};
+
+uint16_t topicFields(uint8_t topics) {
+    uint16_t fields = 0;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        if (topics & (1 << TELEMETRY_FIELDS[f].topic)) fields |= 1 << f;
+    }
+    return fields;
+}
+
+uint8_t subscribedTopics(const WSClientState* state) {
+    uint8_t topics = 0;
+    for (int t = 0; t < WSControl::TOPIC_COUNT; t++) {
+        if (state->topicHz[t]) topics |= 1 << t;
+    }
+    return topics;
+}
+
+// Themen, deren Rate abgelaufen ist; bei langer RTT mit rateDiv gestreckt
+uint8_t dueTopics(const WSClientState* state, uint32_t now) {
+    uint8_t topics = 0;
+    for (int t = 0; t < WSControl::TOPIC_COUNT; t++) {
+        uint8_t hz = state->topicHz[t];
+        // halber Task-Takt Toleranz, damit 5 Hz nicht durch Jitter zu 3,3 Hz werden
+        if (hz && now - state->topicLastMs[t] + 50 >= 1000UL * state->rateDiv / hz) topics |= 1 << t;
+    }
+    return topics;
+}
+
+uint32_t fragmentHash(const char* s, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+}
+
 WebServerManager::WebServerManager(TinkerThinkerBoard* board, ConfigManager* config)
 : board(board), config(config), server(80), ws("/ws") {}
 
@@ -12,16 +262,22 @@ void WebServerManager::init() {
         return;
     }
 
-    startWifi();
     setupWebSocket();
     setupRoutes();
     // Register control bindings REST endpoints
     registerBindingsRoutes(server, config);
-    server.begin();
-    Serial.println("Web Server started");
+
+    // WLAN im Hintergrund starten: der STA-Verbindungsaufbau (bis 10 s) hält Bluepad32 und die
+    // Bindings nicht mehr auf. Der Server lauscht, sobald das Netz steht. Derselbe Task übernimmt
+    // danach alle Pausen und Wiederanläufe.
+    wifiQueue = xQueueCreate(8, sizeof(WifiRequest));
+    xTaskCreatePinnedToCore([](void* arg) {
+        static_cast<WebServerManager*>(arg)->radioLoop();
+    }, "WifiRadio", 6144, this, 1, NULL, 1);
+    postWifiCommand(WifiCommand::Enable);
 }
 
-void WebServerManager::startWifi() {
+bool WebServerManager::startWifi() {
     if (config->getWifiMode() == "AP") {
         WiFi.mode(WIFI_AP);
         WiFi.softAP(config->getHotspotSSID().c_str(), config->getHotspotPassword().c_str());
@@ -38,78 +294,261 @@ void WebServerManager::startWifi() {
         staSsid.trim();
         staPass.trim();
         Serial.printf("STA target SSID='%s' (passLen=%u)\n", staSsid.c_str(), (unsigned)staPass.length());
-        WiFi.begin(staSsid.c_str(), staPass.c_str());
-        Serial.print("Connecting to WiFi ");
+        radioStats.staticIp = applyStaticIp();
+        loadStaCache();
+
+        // Erst direkt auf den zuletzt benutzten AP (kein Scan über alle Kanäle), sonst voller Scan.
+        // Jede Millisekunde hier läuft Bluetooth nur mit dem STA-Connect-Duty-Cycle.
         uint32_t staStart = millis();
-        const uint32_t STA_TIMEOUT_MS = 10000;
-        while (WiFi.status() != WL_CONNECTED) {
-            if (millis() - staStart > STA_TIMEOUT_MS) {
-                Serial.println("\nSTA connect timeout – falling back to AP mode");
-                WiFi.disconnect(true);
-                WiFi.mode(WIFI_AP);
-                WiFi.softAP(config->getHotspotSSID().c_str(), config->getHotspotPassword().c_str());
-                Serial.print("Fallback AP IP: ");
-                Serial.println(WiFi.softAPIP());
-                return;
+        bool direct = staCache.valid && staCache.ssid == staSsid;
+        StaResult result = StaResult::Failed;
+        if (direct) {
+            Serial.printf("Connecting to WiFi (Kanal %u, BSSID %02X:%02X:%02X:%02X:%02X:%02X) ",
+                          staCache.channel, staCache.bssid[0], staCache.bssid[1], staCache.bssid[2],
+                          staCache.bssid[3], staCache.bssid[4], staCache.bssid[5]);
+            result = connectSta(staSsid, staPass, &staCache, STA_DIRECT_TIMEOUT_MS);
+            if (result == StaResult::Failed) {
+                Serial.println("\nDirektverbindung fehlgeschlagen – voller Scan");
+                radioStats.directMisses++;
+                direct = false;
             }
-            Serial.print(".");
-            delay(500);
         }
+        if (!direct && result != StaResult::Aborted) {
+            Serial.print("Connecting to WiFi ");
+            uint32_t spent = millis() - staStart;
+            result = connectSta(staSsid, staPass, nullptr, spent < STA_TIMEOUT_MS ? STA_TIMEOUT_MS - spent : 0);
+        }
+
+        if (result == StaResult::Aborted) {
+            Serial.println("\nSTA connect abgebrochen (Pause angefordert)");
+            WiFi.disconnect(true, false);
+            return false;
+        }
+        if (result == StaResult::Failed) {
+            Serial.println("\nSTA connect timeout – falling back to AP mode");
+            WiFi.disconnect(true);
+            WiFi.mode(WIFI_AP);
+            WiFi.softAP(config->getHotspotSSID().c_str(), config->getHotspotPassword().c_str());
+            Serial.print("Fallback AP IP: ");
+            Serial.println(WiFi.softAPIP());
+            return true;
+        }
+
+        uint32_t connectMs = millis() - staStart;
+        radioStats.lastConnectMs = connectMs;
+        if (connectMs > radioStats.maxConnectMs) radioStats.maxConnectMs = connectMs;
+        if (direct) radioStats.directConnects++;
+        else radioStats.scanConnects++;
+        saveStaCache(staSsid);
         Serial.println();
-        Serial.print("Connected IP: ");
-        Serial.println(WiFi.localIP());
+        Serial.printf("Connected IP: %s in %u ms (%s, Kanal %ld%s)\n", WiFi.localIP().toString().c_str(),
+                      (unsigned)connectMs, direct ? "direkt" : "Scan", (long)WiFi.channel(),
+                      radioStats.staticIp ? ", statische IP" : "");
     }
+    return true;
+}
+
+// Wartet auf WL_CONNECTED. direct: nur diesen Kanal/BSSID versuchen (scheitert schnell, wenn der
+// AP dort nicht mehr antwortet). Eine wartende Pause bricht ab.
+WebServerManager::StaResult WebServerManager::connectSta(const String& ssid, const String& pass,
+                                                         const StaCache* direct, uint32_t timeoutMs) {
+    if (direct) {
+        WiFi.begin(ssid.c_str(), pass.c_str(), direct->channel, direct->bssid, true);
+    } else {
+        WiFi.begin(ssid.c_str(), pass.c_str());
+    }
+    uint32_t start = millis();
+    for (;;) {
+        wl_status_t st = WiFi.status();
+        if (st == WL_CONNECTED) return StaResult::Connected;
+        if (wifiStopPending(0)) return StaResult::Aborted;
+        if (millis() - start > timeoutMs) break;
+        // Direkt: AP weg oder umgezogen -> sofort auf den Scan zurückfallen statt das Timeout abzuwarten
+        // (die ersten 200 ms kann noch der Status der vorigen Verbindung anstehen)
+        if (direct && millis() - start > 200 && (st == WL_NO_SSID_AVAIL || st == WL_CONNECT_FAILED)) break;
+        Serial.print(".");
+        wifiStopPending(direct ? 100 : 500);   // wacht bei einer neuen Anforderung sofort auf
+    }
+    WiFi.disconnect(false, false);
+    return StaResult::Failed;
+}
+
+// Optionale statische Adresse aus der Konfiguration; true, wenn sie gesetzt wurde (kein DHCP).
+// Ohne sie fragt der DHCP-Client zuerst die letzte Adresse an (CONFIG_LWIP_DHCP_RESTORE_LAST_IP).
+bool WebServerManager::applyStaticIp() {
+    IPAddress ip, gateway, netmask, dns;
+    if (!ip.fromString(config->getWifiStaticIp())) return false;
+    if (!gateway.fromString(config->getWifiGateway()) || !netmask.fromString(config->getWifiNetmask())) {
+        Serial.println("Statische IP ohne gültiges Gateway/Netzmaske – DHCP");
+        return false;
+    }
+    if (!dns.fromString(config->getWifiDns())) dns = gateway;
+    return WiFi.config(ip, gateway, netmask, dns);
+}
+
+void WebServerManager::loadStaCache() {
+    if (staCacheLoaded) return;   // danach nur noch im RAM nachgeführt
+    staCacheLoaded = true;
+    Preferences prefs;
+    if (!prefs.begin(STA_CACHE_NS, true)) return;
+    staCache.ssid = prefs.getString("ssid", "");
+    staCache.channel = prefs.getUChar("ch", 0);
+    size_t n = prefs.getBytes("bssid", staCache.bssid, sizeof(staCache.bssid));
+    prefs.end();
+    staCache.valid = staCache.ssid.length() && n == sizeof(staCache.bssid) &&
+                     staCache.channel >= 1 && staCache.channel <= 14;
+}
+
+void WebServerManager::saveStaCache(const String& ssid) {
+    const uint8_t* bssid = WiFi.BSSID();
+    int32_t channel = WiFi.channel();
+    if (!bssid || channel < 1 || channel > 14) return;
+    if (staCache.valid && staCache.ssid == ssid && staCache.channel == channel &&
+        memcmp(staCache.bssid, bssid, sizeof(staCache.bssid)) == 0) {
+        return;   // unverändert: Flash schonen
+    }
+    staCache.ssid = ssid;
+    staCache.channel = (uint8_t)channel;
+    memcpy(staCache.bssid, bssid, sizeof(staCache.bssid));
+    staCache.valid = true;
+    Preferences prefs;
+    if (!prefs.begin(STA_CACHE_NS, false)) return;
+    prefs.putString("ssid", ssid);
+    prefs.putUChar("ch", staCache.channel);
+    prefs.putBytes("bssid", staCache.bssid, sizeof(staCache.bssid));
+    prefs.end();
 }
 
 void WebServerManager::disableWifiUntilRestart() {
     requestWifiDisable(true);
 }
 
-void WebServerManager::requestWifiDisable(bool untilRestart) {
-    if (wifiDisabledUntilRestart || wifiShutdownInProgress) {
-        return;
-    }
-    if (untilRestart) {
-        wifiDisabledUntilRestart = true;
-    } else {
-        wifiTemporarilyDisabled = true;
+const char* WebServerManager::wifiStateName(WifiState state) {
+    switch (state) {
+        case WifiState::Off:      return "off";
+        case WifiState::Starting: return "starting";
+        case WifiState::Up:       return "up";
+        case WifiState::Pausing:  return "pausing";
+        case WifiState::Paused:   return "paused";
     }
-    wifiShutdownInProgress = true;
+    return "?";
+}
 
-    bool permanent = untilRestart;
-    auto* ctx = new std::pair<WebServerManager*, bool>(this, permanent);
-    xTaskCreatePinnedToCore([](void* arg) {
-        auto* p = static_cast<std::pair<WebServerManager*, bool>*>(arg);
-        WebServerManager* self = p->first;
-        bool perm = p->second;
-        delete p;
-        self->disableWifiInternal(perm);
-        self->wifiShutdownInProgress = false;
-        vTaskDelete(NULL);
-    }, "WifiShutdown", 4096, ctx, 1, NULL, 1);
+void WebServerManager::requestWifiDisable(bool untilRestart) {
+    if (wifiDisabledUntilRestart) return;
+    if (untilRestart) wifiDisabledUntilRestart = true;
+    postWifiCommand(untilRestart ? WifiCommand::DisableUntilRestart : WifiCommand::Pause);
 }
 
 void WebServerManager::requestWifiEnable() {
-    if (wifiDisabledUntilRestart || wifiStartupInProgress) {
-        return;
-    }
-    if (!wifiTemporarilyDisabled && WiFi.getMode() != WIFI_OFF) {
-        return;
+    if (wifiDisabledUntilRestart) return;
+    postWifiCommand(WifiCommand::Enable);
+}
+
+void WebServerManager::postWifiCommand(WifiCommand cmd) {
+    if (!wifiQueue) return;
+    WifiRequest req = {cmd, millis()};
+    wifiRequests++;
+    lastWifiCommand = (uint8_t)cmd;
+    if (xQueueSend(wifiQueue, &req, 0) != pdTRUE) {
+        // Voll: ältere Anforderungen würden ohnehin zusammengefasst, die neueste zählt
+        xQueueReset(wifiQueue);
+        xQueueSend(wifiQueue, &req, 0);
     }
-    wifiTemporarilyDisabled = false;
-    wifiStartupInProgress = true;
+}
 
-    xTaskCreatePinnedToCore([](void* arg) {
-        WebServerManager* self = static_cast<WebServerManager*>(arg);
-        self->enableWifiInternal();
-        self->wifiStartupInProgress = false;
-        vTaskDelete(NULL);
-    }, "WifiStartup", 6144, this, 1, NULL, 1);
+// Während des STA-Verbindungsaufbaus: wartet eine Pause/Abschaltung, den Aufbau abbrechen.
+// waitMs > 0 wartet höchstens so lange auf eine neue Anforderung (statt eines festen delay()).
+bool WebServerManager::wifiStopPending(uint32_t waitMs) {
+    WifiRequest req;
+    bool queued = xQueuePeek(wifiQueue, &req, pdMS_TO_TICKS(waitMs)) == pdTRUE;
+    bool stop = wifiDisabledUntilRestart || (queued && lastWifiCommand != (uint8_t)WifiCommand::Enable);
+    // Zuletzt kam nur ein weiteres Enable: das ist schon in Arbeit, normal weiter warten
+    if (queued && !stop && waitMs) vTaskDelay(pdMS_TO_TICKS(waitMs));
+    return stop;
+}
+
+void WebServerManager::setWifiState(WifiState state) {
+    wifiState = (uint8_t)state;
+}
+
+void WebServerManager::publishRadioStats() {
+    xSemaphoreTake(radioStatsMutex, portMAX_DELAY);
+    radioStatsShared = radioStats;
+    xSemaphoreGive(radioStatsMutex);
+}
+
+WifiRadioStats WebServerManager::getWifiRadioStats() const {
+    xSemaphoreTake(radioStatsMutex, portMAX_DELAY);
+    WifiRadioStats stats = radioStatsShared;
+    xSemaphoreGive(radioStatsMutex);
+    stats.requests = wifiRequests.load();
+    return stats;
+}
+
+void WebServerManager::radioLoop() {
+    for (;;) {
+        WifiRequest req;
+        xQueueReceive(wifiQueue, &req, portMAX_DELAY);
+        // Wartezeit ab der ältesten zusammengefassten Anforderung; req.atMs bleibt die Zeit des
+        // ausgeführten Kommandos (Grace-Delay für dessen Antwort)
+        uint32_t firstAtMs = req.atMs;
+        WifiRequest next;
+        while (xQueueReceive(wifiQueue, &next, 0) == pdTRUE) {
+            radioStats.coalesced++;
+            if (req.cmd != WifiCommand::DisableUntilRestart) req = next;
+        }
+        if (wifiDisabledUntilRestart) req.cmd = WifiCommand::DisableUntilRestart;
+
+        WifiState from = getWifiState();
+        WifiState target = (req.cmd == WifiCommand::Enable) ? WifiState::Up
+                         : (req.cmd == WifiCommand::Pause) ? WifiState::Paused : WifiState::Off;
+        // Schon im Ziel (z. B. Pause und Enable vor dem Abholen zusammengefasst). Aus dem
+        // Anfangszustand Off geht es nur per Enable heraus; eine Pause davor hat nichts abzuschalten.
+        if (from == target || (from == WifiState::Off && target == WifiState::Paused)) {
+            publishRadioStats();
+            continue;
+        }
+
+        uint32_t begin = millis();
+        radioStats.lastQueueMs = begin - firstAtMs;
+        if (target == WifiState::Up) {
+            setWifiState(WifiState::Starting);
+            bool first = !serverStarted;
+            if (first) boot_phase_begin("wifi");
+            bool up = startWifi();
+            if (first) {
+                // Nur einmal: ESPAsyncWebServer verträgt kein end()/begin(), der Listener bleibt
+                // über Pausen hinweg bestehen
+                server.begin();
+                serverStarted = true;
+                boot_phase_end("wifi");
+                Serial.println("Web Server started");
+            }
+            if (!up) target = WifiState::Paused;   // Aufbau zugunsten einer Pause abgebrochen
+            setWifiState(target);
+            radioStats.lastStartMs = millis() - begin;
+            if (radioStats.lastStartMs > radioStats.maxStartMs) radioStats.maxStartMs = radioStats.lastStartMs;
+        } else {
+            if (target == WifiState::Off && req.cmd == WifiCommand::DisableUntilRestart &&
+                begin - req.atMs < WIFI_DISABLE_GRACE_MS) {
+                vTaskDelay(pdMS_TO_TICKS(WIFI_DISABLE_GRACE_MS - (begin - req.atMs)));
+            }
+            setWifiState(WifiState::Pausing);
+            disableWifiInternal(target == WifiState::Off);
+            setWifiState(target);
+            radioStats.lastPauseMs = millis() - begin;
+            if (radioStats.lastPauseMs > radioStats.maxPauseMs) radioStats.maxPauseMs = radioStats.lastPauseMs;
+        }
+        radioStats.transitions++;
+        publishRadioStats();
+        Serial.printf("WiFi: %s -> %s in %u ms (wartete %u ms)\n", wifiStateName(from), wifiStateName(target),
+                      (unsigned)(millis() - begin), (unsigned)radioStats.lastQueueMs);
+    }
 }
 
 void WebServerManager::disableWifiInternal(bool permanent) {
     Serial.println("Disabling WiFi...");
-    delay(150);
 
     // Close WebSocket connections but do NOT call server.end() —
     // ESPAsyncWebServer does not support stop/restart; calling begin() a second
@@ -137,28 +576,33 @@ void WebServerManager::disableWifiInternal(bool permanent) {
     // (a full WIFI_OFF here breaks the later re-init with
     //  "netstack cb reg failed 12308 / ESP_ERR_WIFI_STOP_STATE")
 
-    delay(50);
     Serial.println(permanent ? "WiFi disabled permanently." : "WiFi paused temporarily.");
 }
 
-void WebServerManager::enableWifiInternal() {
-    Serial.println("Enabling WiFi per user request...");
-    startWifi();
-    // Do NOT call server.begin() here — the server was never stopped,
-    // only WiFi was disconnected. Calling begin() again would create a
-    // second TCP listener and cause hangs.
-    Serial.println("WiFi re-enabled, server still running.");
-}
-
 void WebServerManager::setupWebSocket() {
     ws.onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, 
                       AwsEventType type, void *arg, uint8_t *data, size_t len) {
         this->onWebSocketEvent(server, client, type, arg, data, len);
     });
+    ws.addProtocol(WSControl::BINARY_PROTOCOL);
     server.addHandler(&ws);
 }
 
 void WebServerManager::setupRoutes() {
+#if CONFIG_TT_EMBED_WEB_UI
+    // Eingebettete Oberfläche zuerst; was nicht in der Tabelle steht, bedienen die Routen unten
+    EmbeddedAssetHandler* embedded = new EmbeddedAssetHandler();
+    embedded->scanOverrides(LittleFS);
+    server.addHandler(embedded);
+#endif
+    // Gebaute Oberfläche (tools/build_web_assets.py): Dateien unter /a/ tragen den Inhalts-Hash im
+    // Namen und dürfen unbegrenzt gecacht werden. Seiten liegen als .gz vor; send(LittleFS, ...)
+    // nimmt den CRC aus dem gzip-Trailer als ETag, setzt no-cache und antwortet unverändert mit 304.
+    // Ohne Build-Schritt (rohes data/) wird wie bisher unkomprimiert ausgeliefert.
+    server.serveStatic("/a/", LittleFS, "/a/").setCacheControl("public, max-age=31536000, immutable");
+    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
+        request->send(LittleFS, "/index.html", "text/html");
+    });
     server.serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
 
     server.on("/config", HTTP_GET, [this](AsyncWebServerRequest *request){
@@ -298,75 +742,12 @@ document.getElementById('f').onsubmit=function(e){
         disableWifiUntilRestart();
     });
 
-    // JSON mit aktueller Config liefern
+    // JSON mit aktueller Config liefern: chunked, jedes Stück wird direkt aus den Feldern in den
+    // Sendepuffer geschrieben (WindowPrint). Kein JsonDocument, kein String mit dem ganzen Text.
     server.on("/getConfig", HTTP_GET, [this](AsyncWebServerRequest *request){
-        JsonDocument doc;
-
-        doc["wifi_mode"] = config->getWifiMode();
-        doc["wifi_ssid"] = config->getWifiSSID();
-        doc["wifi_password"] = config->getWifiPassword();
-        doc["hotspot_ssid"] = config->getHotspotSSID();
-        doc["hotspot_password"] = config->getHotspotPassword();
-        doc["wifi_disabled_until_restart"] = wifiDisabledUntilRestart || (WiFi.getMode() == WIFI_OFF);
-
-        JsonArray invArr = doc["motor_invert"].to<JsonArray>();
-        for (int i=0; i<4; i++) invArr.add(config->getMotorInvert(i));
-
-        doc["motor_swap"] = config->getMotorSwap();
-        doc["motor_left_gui"] = config->getMotorLeftGUI();
-        doc["motor_right_gui"] = config->getMotorRightGUI();
-
-        JsonArray dbArr = doc["motor_deadband"].to<JsonArray>();
-        for (int i=0; i<4; i++) dbArr.add(config->getMotorDeadband(i));
-
-        JsonArray freqArr = doc["motor_frequency"].to<JsonArray>();
-        for (int i=0; i<4; i++) freqArr.add(config->getMotorFrequency(i));
-
-        doc["led_count"] = config->getLedCount();
-        doc["led_brightness"] = config->getLedBrightness();
-        doc["led_gamma"] = config->getLedGamma();
-        doc["ws_invert_x"] = config->getWsInvertX();
-        doc["ws_invert_y"] = config->getWsInvertY();
-        doc["ws_swap_sides"] = config->getWsSwapSides();
-        doc["bt_invert_x"] = config->getBtInvertX();
-        doc["bt_invert_y"] = config->getBtInvertY();
-        doc["bt_swap_axes"] = config->getBtSwapAxes();
-        doc["ota_enabled"] = config->getOTAEnabled();
-
-        doc["drive_mixer"] = config->getDriveMixer();
-        doc["drive_turn_gain"] = config->getDriveTurnGain();
-        doc["drive_axis_deadband"] = config->getDriveAxisDeadband();
-        doc["motor_curve_type"] = config->getMotorCurveType();
-        doc["motor_curve_strength"] = config->getMotorCurveStrength();
-
-        // Bluetooth scan duty-cycle
-        doc["bt_scan_on_normal_ms"]  = config->getBtScanOnNormal();
-        doc["bt_scan_off_normal_ms"] = config->getBtScanOffNormal();
-        doc["bt_scan_on_sta_ms"]     = config->getBtScanOnSta();
-        doc["bt_scan_off_sta_ms"]    = config->getBtScanOffSta();
-        doc["bt_scan_on_ap_ms"]      = config->getBtScanOnAp();
-        doc["bt_scan_off_ap_ms"]     = config->getBtScanOffAp();
-
-        JsonArray servoArr = doc["servo_settings"].to<JsonArray>();
-        for (int i=0; i<3; i++) {
-            JsonObject sObj = servoArr.add<JsonObject>();
-            sObj["min_pulsewidth"] = config->getServoMinPulsewidth(i);
-            sObj["max_pulsewidth"] = config->getServoMaxPulsewidth(i);
-        }
-
-        // Control bindings: embed JSON
-        {
-            String binds = config->getControlBindingsJson();
-            if (binds.length() == 0) binds = String(ConfigManager::getDefaultControlBindingsJson());
-            JsonDocument bd;
-            if (deserializeJson(bd, binds) == DeserializationError::Ok) {
-                doc["control_bindings"] = bd;
-            }
-        }
-
-        String json;
-        serializeJson(doc, json);
-        request->send(200, "application/json", json);
+        bool wifiOff = wifiDisabledUntilRestart || (WiFi.getMode() == WIFI_OFF);
+        request->send(beginConfigResponse(request, config, wifiOff ? "\"wifi_disabled_until_restart\":true"
+                                                                    : "\"wifi_disabled_until_restart\":false"));
     });
 
     // POST config
@@ -374,6 +755,36 @@ document.getElementById('f').onsubmit=function(e){
         handleConfig(request);
     });
 
+    // Komplette Konfiguration als JSON exportieren/importieren. Gespeichert wird binär
+    // (ConfigManager::CONFIG_BIN_PATH); config.json ist nur noch das Austauschformat.
+    server.on(ConfigManager::CONFIG_JSON_PATH, HTTP_GET, [this](AsyncWebServerRequest *request){
+        AsyncWebServerResponse* response = beginConfigResponse(request, config, nullptr);
+        response->addHeader("Content-Disposition", "attachment; filename=\"config.json\"");
+        request->send(response);
+    });
+    server.on(ConfigManager::CONFIG_JSON_PATH, HTTP_POST,
+        [this](AsyncWebServerRequest *request){
+            char* body = reinterpret_cast<char*>(request->_tempObject);
+            if (!body) {
+                request->send(400, "text/plain", "no body");
+                return;
+            }
+            JsonDocument doc;
+            DeserializationError err = deserializeJson(doc, (const char*)body);
+            free(body);
+            request->_tempObject = nullptr;
+            if (err || !doc.is<JsonObject>()) {
+                request->send(400, "text/plain", "invalid json");
+                return;
+            }
+            config->importJson(doc.as<JsonObjectConst>());
+            board->reApplyConfig();
+            request->send(200, "application/json", "{\"status\":\"ok\",\"reboot_required\":true}");
+        },
+        NULL,
+        collectBody
+    );
+
     server.on("/resetconfig", HTTP_GET, [this](AsyncWebServerRequest* request){
         config->resetConfig();
         request->redirect("/config");
@@ -432,7 +843,7 @@ document.getElementById('f').onsubmit=function(e){
                 }
                 config->setBtWhitelist(addrs);
             }
-            config->saveConfig();
+            config->requestSave();
             if (whitelistApplyCallback) whitelistApplyCallback();
         }
     );
@@ -451,10 +862,10 @@ document.getElementById('f').onsubmit=function(e){
         if (request->hasParam("gamma")) {
             config->setLedGamma(request->getParam("gamma")->value() == "1");
         }
-        bool ok = config->saveConfig();
+        config->requestSave();
         board->setLedBrightness((uint8_t)config->getLedBrightness());
         board->setLedGamma(config->getLedGamma());
-        request->send(ok ? 200 : 500, "text/plain", ok ? "OK" : "save failed");
+        request->send(200, "text/plain", "OK");
     });
 
     // Website-Joystick-Steuerung (unabhängig vom BT-Controller) dauerhaft speichern
@@ -462,8 +873,8 @@ document.getElementById('f').onsubmit=function(e){
         if (request->hasParam("x"))    config->setWsInvertX(request->getParam("x")->value() == "1");
         if (request->hasParam("y"))    config->setWsInvertY(request->getParam("y")->value() == "1");
         if (request->hasParam("swap")) config->setWsSwapSides(request->getParam("swap")->value() == "1");
-        bool ok = config->saveConfig();
-        request->send(ok ? 200 : 500, "text/plain", ok ? "OK" : "save failed");
+        config->requestSave();
+        request->send(200, "text/plain", "OK");
     });
 
     // BT-Controller-Joystick-Richtung (unabhängig von der Website) dauerhaft speichern
@@ -471,167 +882,27 @@ document.getElementById('f').onsubmit=function(e){
         if (request->hasParam("x"))    config->setBtInvertX(request->getParam("x")->value() == "1");
         if (request->hasParam("y"))    config->setBtInvertY(request->getParam("y")->value() == "1");
         if (request->hasParam("swap")) config->setBtSwapAxes(request->getParam("swap")->value() == "1");
-        bool ok = config->saveConfig();
-        request->send(ok ? 200 : 500, "text/plain", ok ? "OK" : "save failed");
+        config->requestSave();
+        request->send(200, "text/plain", "OK");
     });
 }
 
 
 void WebServerManager::handleConfig(AsyncWebServerRequest* request) {
-    bool wifiChanged = false;
-
-    // WLAN- und Hotspot-Settings
-    if (request->hasParam("wifi_mode", true)) {
-        String newMode = request->getParam("wifi_mode", true)->value();
-        if (newMode != config->getWifiMode()) {
-            wifiChanged = true;
-        }
-        config->setWifiMode(newMode);
-    }
-    if (request->hasParam("wifi_ssid", true)) {
-        String ssid = request->getParam("wifi_ssid", true)->value();
-        ssid.trim();
-        config->setWifiSSID(ssid);
-    }
-    if (request->hasParam("wifi_password", true)) {
-        String pass = request->getParam("wifi_password", true)->value();
-        pass.trim();
-        config->setWifiPassword(pass);
-    }
-    if (request->hasParam("hotspot_ssid", true)) {
-        config->setHotspotSSID(request->getParam("hotspot_ssid", true)->value());
-    }
-    if (request->hasParam("hotspot_password", true)) {
-        config->setHotspotPassword(request->getParam("hotspot_password", true)->value());
-    }
-
-    // Motor Swap
-    if (request->hasParam("motor_swap", true)) {
-        bool sw = (request->getParam("motor_swap", true)->value() == "on");
-        config->setMotorSwap(sw);
-    } else {
-        config->setMotorSwap(false);
-    }
-
-    if (request->hasParam("motor_left_gui", true)) {
-        int left = request->getParam("motor_left_gui", true)->value().toInt();
-        left = constrain(left, 0, 3);
-        config->setMotorLeftGUI(left);
-    }
-    if (request->hasParam("motor_right_gui", true)) {
-        int right = request->getParam("motor_right_gui", true)->value().toInt();
-        right = constrain(right, 0, 3);
-        config->setMotorRightGUI(right);
+    // Alle POST-Felder in einem Durchlauf über das Schema (ConfigSchema.h)
+    std::vector<ConfigManager::FormField> fields;
+    fields.reserve(request->params());
+    for (size_t i = 0; i < request->params(); i++) {
+        const AsyncWebParameter* p = request->getParam(i);
+        if (p->isPost()) fields.push_back({p->name().c_str(), p->value().c_str()});
     }
+    ConfigManager::ConfigChange change = config->applyForm(fields.data(), fields.size());
+    bool wifiChanged = change.sections & CFG_REBOOT;
 
-    // Motoren (invert, deadband, frequency)
-    for (int i = 0; i < 4; i++) {
-        // Motor Invert
-        {
-            String field = "motor_invert_" + String(i);
-            bool inv = false;
-            if (request->hasParam(field, true)) {
-                inv = (request->getParam(field, true)->value() == "on");
-            }
-            config->setMotorInvert(i, inv);
-        }
-
-        // Motor Deadband
-        {
-            String field = "motor_deadband_" + String(i);
-            int dbVal = config->getMotorDeadband(i);
-            if (request->hasParam(field, true)) {
-                dbVal = request->getParam(field, true)->value().toInt();
-            }
-            config->setMotorDeadband(i, dbVal);
-        }
-
-        // Motor Frequency
-        {
-            String field = "motor_frequency_" + String(i);
-            int freqVal = config->getMotorFrequency(i);
-            if (request->hasParam(field, true)) {
-                freqVal = request->getParam(field, true)->value().toInt();
-            }
-            config->setMotorFrequency(i, freqVal);
-        }
-    }
-
-    // LED Count
-    if (request->hasParam("led_count", true)) {
-        config->setLedCount(request->getParam("led_count", true)->value().toInt());
-    }
-
-    // OTA Enabled
-    if (request->hasParam("ota_enabled", true)) {
-        bool ota = (request->getParam("ota_enabled", true)->value() == "on");
-        config->setOTAEnabled(ota);
-    } else {
-        config->setOTAEnabled(false);
-    }
-
-    // BT scan timings (optional fields)
-    auto setIntIf = [&](const char* name, void(*setter)(ConfigManager*, int)){
-        if (request->hasParam(name, true)) {
-            int v = request->getParam(name, true)->value().toInt();
-            setter(config, v);
-        }
-    };
-    setIntIf("bt_scan_on_normal_ms",  [](ConfigManager* c,int v){ c->setBtScanOnNormal(v); });
-    setIntIf("bt_scan_off_normal_ms", [](ConfigManager* c,int v){ c->setBtScanOffNormal(v); });
-    setIntIf("bt_scan_on_sta_ms",     [](ConfigManager* c,int v){ c->setBtScanOnSta(v); });
-    setIntIf("bt_scan_off_sta_ms",    [](ConfigManager* c,int v){ c->setBtScanOffSta(v); });
-    setIntIf("bt_scan_on_ap_ms",      [](ConfigManager* c,int v){ c->setBtScanOnAp(v); });
-    setIntIf("bt_scan_off_ap_ms",     [](ConfigManager* c,int v){ c->setBtScanOffAp(v); });
-
-    // Servos
-    for (int i = 0; i < 3; i++) {
-        String minField = "servo" + String(i) + "_min";
-        String maxField = "servo" + String(i) + "_max";
-        int min_pw = config->getServoMinPulsewidth(i);
-        int max_pw = config->getServoMaxPulsewidth(i);
-
-        if (request->hasParam(minField, true)) {
-            min_pw = request->getParam(minField, true)->value().toInt();
-        }
-        if (request->hasParam(maxField, true)) {
-            max_pw = request->getParam(maxField, true)->value().toInt();
-        }
-        config->setServoPulsewidthRange(i, min_pw, max_pw);
-    }
-
-    if (request->hasParam("drive_mixer", true)) {
-        config->setDriveMixer(request->getParam("drive_mixer", true)->value());
-    }
-    if (request->hasParam("drive_turn_gain", true)) {
-        String v = request->getParam("drive_turn_gain", true)->value();
-        v.trim();
-        if (v.length() > 0) {
-            config->setDriveTurnGain(v.toFloat());
-        }
-    }
-    if (request->hasParam("drive_axis_deadband", true)) {
-        String v = request->getParam("drive_axis_deadband", true)->value();
-        v.trim();
-        if (v.length() > 0) {
-            config->setDriveAxisDeadband(v.toInt());
-        }
-    }
-    if (request->hasParam("motor_curve_type", true)) {
-        config->setMotorCurveType(request->getParam("motor_curve_type", true)->value());
-    }
-    if (request->hasParam("motor_curve_strength", true)) {
-        String v = request->getParam("motor_curve_strength", true)->value();
-        v.trim();
-        if (v.length() > 0) {
-            config->setMotorCurveStrength(v.toFloat());
-        }
-    }
-
-    // Config speichern
-    config->saveConfig();
+    // Config speichern (im Hintergrund; ein folgender Neustart schreibt vorher noch)
+    if (change.sections) config->requestSave();
     // Apply new config
-    board->reApplyConfig();
+    if (change.sections & CFG_HARDWARE) board->reApplyConfig();
 
     if (wifiChanged) {
         // Sende eine Nachricht über WebSocket, dass ein Neustart erfolgt
@@ -672,8 +943,19 @@ void WebServerManager::notifyControllerDisconnected(int slot) {
 void registerBindingsRoutes(AsyncWebServer& server, ConfigManager* config) {
     server.on("/getBindings", HTTP_GET, [config](AsyncWebServerRequest* request){
         String binds = config->getControlBindingsJson();
-        if (binds.length() == 0) binds = String(ConfigManager::getDefaultControlBindingsJson());
-        request->send(200, "application/json", binds);
+        if (binds.length() == 0) {
+            // Standardbelegung liegt im Flash: ohne Kopie senden
+            const char* def = ConfigManager::getDefaultControlBindingsJson();
+            request->send(200, "application/json", (const uint8_t*)def, strlen(def));
+            return;
+        }
+        // Eine Momentaufnahme, aus der die Antwort stückweise gefüllt wird (keine zweite Kopie)
+        size_t len = binds.length();
+        request->send("application/json", len, [binds = std::move(binds)](uint8_t* buf, size_t maxLen, size_t index) -> size_t {
+            size_t n = std::min(maxLen, binds.length() - index);
+            memcpy(buf, binds.c_str() + index, n);
+            return n;
+        });
     });
     server.on("/control_bindings", HTTP_POST,
         // onRequest läuft NACH dem Body-Handler: hier parsen, speichern und antworten.
@@ -699,131 +981,120 @@ void registerBindingsRoutes(AsyncWebServer& server, ConfigManager* config) {
             String normalized;
             serializeJson(bd, normalized);
             config->setControlBindingsJson(normalized);
-            bool ok = config->saveConfig();
-            Serial.printf("control_bindings: gespeichert=%s\n", ok ? "true" : "false");
-            request->send(ok ? 200 : 500, "text/plain", ok ? "OK" : "save failed");
+            config->requestSave();
+            request->send(200, "text/plain", "OK");
         },
         NULL,
-        // Body-Handler: nur in einen malloc-Puffer akkumulieren (free-kompatibel mit
-        // ~AsyncWebServerRequest, falls die Verbindung vor onRequest abbricht).
-        [](AsyncWebServerRequest* request, uint8_t *data, size_t len, size_t index, size_t total){
-            if (index == 0) {
-                char* buf = (char*)malloc(total + 1);
-                if (buf) buf[total] = '\0';
-                request->_tempObject = buf;
-            }
-            char* buf = reinterpret_cast<char*>(request->_tempObject);
-            if (!buf) return;
-            memcpy(buf + index, data, len);
-        }
+        collectBody
     );
 }
 
 
 
+void WebServerManager::handleBinaryControl(AsyncWebSocketClient* client, const uint8_t* data, size_t len) {
+    WSClientState* state = (WSClientState*)client->_tempObject;
+    WSControl::FrameHeader header;
+    header.seq = (uint16_t)(data[2] | (data[3] << 8));
+    // Veraltete oder doppelte Frames (z. B. nach Reconnect nachgesendet) verwerfen
+    xSemaphoreTake(wsMutex, portMAX_DELAY);
+    bool stale = state && state->seqValid && (int16_t)(header.seq - state->lastSeq) <= 0;
+    xSemaphoreGive(wsMutex);
+    if (stale) {
+        wsStats.stale++;
+        return;
+    }
+    BoardControlSink sink(board, config);
+    if (!WSControl::handleBinary(data, len, sink, &header)) {
+        wsStats.invalid++;
+        return;
+    }
+    wsStats.binary++;
+    lastWsControlMs = millis();
+    if (state) {
+        xSemaphoreTake(wsMutex, portMAX_DELAY);
+        state->seqValid = true;
+        state->lastSeq = header.seq;
+        state->lastClientMs = header.clientMs;
+        noteClientTimestamp(state, header.clientMs, millis());
+        xSemaphoreGive(wsMutex);
+    }
+}
+
+void WebServerManager::handleWsMessage(AsyncWebSocketClient* client, uint8_t opcode, const uint8_t* data, size_t len) {
+    if (opcode == WS_BINARY) {
+        // Binaere Nachrichten: Steuerung (WSControl.h) oder LED-Stream (LEDFrameStream.h)
+        if (WSControl::isBinaryControlFrame(data, len)) {
+            handleBinaryControl(client, data, len);
+        } else {
+            board->handleLEDStreamFrame(data, len);
+        }
+        return;
+    }
+    BoardControlSink sink(board, config, (WSClientState*)client->_tempObject, wsMutex);
+    if (!WSControl::handleJson(data, len, sink, &wsJsonArena, &wsStats.unknownKeys)) {
+        wsStats.invalid++;
+        return;
+    }
+    wsStats.json++;
+    lastWsControlMs = millis();
+}
+
 void WebServerManager::onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, 
                                         AwsEventType type, void *arg, uint8_t *data, size_t len) {
     if (type == WS_EVT_DATA) {
-        lastPacketTime = millis();
-        String message;
-        for (size_t i = 0; i < len; i++) {
-            message += (char)data[i];
+        AwsFrameInfo* info = (AwsFrameInfo*)arg;
+        if (!info) return;
+        if (info->num == 0 && info->final && info->index == 0 && info->len == len) {
+            // Nachricht in einem Stück: direkt aus dem Frame-Puffer verarbeiten
+            handleWsMessage(client, info->opcode, data, len);
+            return;
         }
-
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, message);
-        if (!error) {
-            // Vorhandene Steuerung für Joystick & Servo
-            if (!doc["x"].isNull() && !doc["y"].isNull()) {
-                float x = doc["x"].as<float>();
-                float y = doc["y"].as<float>();
-
-                // Achsenrotation
-                float rotatedX = -y;
-                float rotatedY = x;
-
-                board->requestDriveFromWS((int)(rotatedX * 512), (int)(rotatedY * 512));
-            }
-
-            // Bestehende Motor Steuerung (A, B, C, D)
-            for (int i = 0; i < 4; i++) {
-                String motorKey = "motor" + String((char)('A' + i));
-                if (!doc[motorKey].isNull()) {
-                    String command = doc[motorKey].as<String>();
-                    if (command == "forward") {
-                        board->requestMotorDirectFromWS(i, 255);
-                    } else if (command == "backward") {
-                        board->requestMotorDirectFromWS(i, -255);
-                    } else if (command == "stop") {
-                        board->requestMotorStopFromWS(i);
-                    } else {// Direkte PWM-Steuerung
-                        int pwmValue = command.toInt();
-                        pwmValue = constrain(pwmValue, -255, 255);
-                        board->requestMotorDirectFromWS(i, pwmValue);
-                    }
-                }
-            }
-
-            // Raw Motor PWM (bypasses deadband, used by setup)
-            if (!doc["motor_raw"].isNull()) {
-                JsonObject raw = doc["motor_raw"].as<JsonObject>();
-                int idx = raw["motor"] | -1;
-                int pwm = raw["pwm"] | 0;
-                pwm = constrain(pwm, -255, 255);
-                if (idx >= 0 && idx < 4) {
-                    board->controlMotorRaw(idx, pwm);
-                }
-            }
-
-            // Servo setzen
-            // Erwartetes Format: {"servo0": <angle>, ... "servo6": <angle>}
-            for (int i = 0; i < 7; i++) {
-                String servoKey = "servo" + String(i);
-                if (!doc[servoKey].isNull()) {
-                    Serial.println(servoKey + ": " + String(doc[servoKey].as<int>()));
-                    int angle = doc[servoKey].as<int>();
-                    board->setServoAngle(i, angle);
-                }
-            }
-
-            // LED set (expects {"led_set":{"start":0,"count":1,"color":"#RRGGBB"}})
-            if (!doc["led_set"].isNull()) {
-                JsonObject led = doc["led_set"].as<JsonObject>();
-                int start = led["start"] | 0;
-                int count = led["count"] | 1;
-                const char* color = led["color"] | "#000000";
-                long rgb = strtol(color + 1, nullptr, 16);
-                uint8_t r = (rgb >> 16) & 0xFF;
-                uint8_t g = (rgb >> 8) & 0xFF;
-                uint8_t b = (rgb) & 0xFF;
-                for (int i = start; i < start + count; i++) {
-                    board->setLED(i, r, g, b);
-                }
-                board->showLEDs();
-            }
-            // LED-Helligkeit live setzen (Vorschau, ohne Speichern): {"led_brightness":0-255}
-            if (!doc["led_brightness"].isNull()) {
-                int b = doc["led_brightness"].as<int>();
-                if (b < 0) b = 0; if (b > 255) b = 255;
-                board->setLedBrightness((uint8_t)b);
-            }
-            // Gamma live umschalten: {"led_gamma":true|false}
-            if (!doc["led_gamma"].isNull()) {
-                board->setLedGamma(doc["led_gamma"].as<bool>());
-            }
-            // Optionale Einstellung zum Setzen des Swap-Flags, falls von der UI gesendet
-            // z.B. {"swap":true} oder {"swap":false}
-            if (!doc["swap"].isNull()) {
-                bool sw = doc["swap"].as<bool>();
-                // Config entsprechend setzen
-                config->setMotorSwap(sw);
-                config->saveConfig();
+        // Fragmentierte Nachricht (num > 0 bzw. !final) oder Frame über mehrere TCP-Segmente (index > 0).
+        // Der Zustand wird nur in diesem Task (AsyncTCP) gelöscht, er bleibt also bis zum Ende gültig.
+        WSClientState* state = (WSClientState*)client->_tempObject;
+        if (!state) return;
+        xSemaphoreTake(wsMutex, portMAX_DELAY);
+        if (info->num == 0 && info->index == 0) {
+            state->msgLen = 0;
+            state->msgOverflow = false;
+        }
+        if (state->msgOverflow || len > sizeof(state->msgBuf) - state->msgLen) {
+            state->msgOverflow = true;
+        } else {
+            memcpy(state->msgBuf + state->msgLen, data, len);
+            state->msgLen += len;
+        }
+        bool complete = info->final && info->index + len == info->len;
+        bool overflow = state->msgOverflow;
+        xSemaphoreGive(wsMutex);
+        if (complete) {
+            // Ohne Sperre auswerten: die Befehle sperren selbst, wo sie den Zustand ändern
+            if (overflow) {
+                wsStats.oversize++;
+            } else {
+                wsStats.reassembled++;
+                handleWsMessage(client, info->message_opcode, state->msgBuf, state->msgLen);
             }
+            xSemaphoreTake(wsMutex, portMAX_DELAY);
+            state->msgLen = 0;
+            state->msgOverflow = false;
+            xSemaphoreGive(wsMutex);
         }
     } else if (type == WS_EVT_CONNECT) {
         Serial.println("Websocket client connected");
+        // Unter wsMutex anlegen und löschen: sendStatusUpdate() läuft in WebClientTask über
+        // ws.getClients() und benutzt _tempObject
+        WSClientState* state = new WSClientState();
+        xSemaphoreTake(wsMutex, portMAX_DELAY);
+        client->_tempObject = state;
+        xSemaphoreGive(wsMutex);
     } else if (type == WS_EVT_DISCONNECT) {
         Serial.println("Websocket client disconnected");
+        xSemaphoreTake(wsMutex, portMAX_DELAY);
+        WSClientState* state = (WSClientState*)client->_tempObject;
+        client->_tempObject = nullptr;
+        xSemaphoreGive(wsMutex);
+        delete state;
         // Do not force stop if BT is controlling; respect arbiter
         for (int i = 0; i < 4; i++) {
             board->requestMotorStopFromWS(i);
@@ -835,59 +1106,266 @@ void WebServerManager::onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketCl
 void WebServerManager::sendStatusUpdate() {
     // Nicht auf den WebSocket/Netz-Stack zugreifen, während WiFi pausiert/abgeschaltet
     // wird – sonst Spinlock-Crash beim gleichzeitigen Teardown (v. a. bei 10 Hz Telemetrie).
-    if (isWifiDisabled() || wifiShutdownInProgress) return;
+    if (isWifiDisabled()) {
+        wsClientCount = 0;
+        wsTxQueueMax = 0;
+        return;
+    }
 
-    if (millis() - lastPacketTime > 5000) {
-        // Kein Paket seit 1 Sekunde, stoppe alle Motoren
+    // 1) Kurz sperren: welche Themen sind je Client fällig, Keyframe oder Delta? Wer mit dem
+    //    Abholen nicht nachkommt, wird ausgelassen statt die Warteschlange weiter zu füllen –
+    //    die nächste Nachricht ist ohnehin aktueller.
+    struct ClientPlan {
+        uint32_t id, gen;
+        uint8_t topics;          // fällige Themen, 0 = diesmal nichts
+        bool keyframe, deltas;
+        uint8_t hz[WSControl::TOPIC_COUNT];
+        uint32_t hash[FIELD_COUNT];
+        uint32_t queue, sent, dropped;
+        bool clockValid;
+        uint32_t rttUs, rttMinUs, oneWayUs;
+        int32_t offsetMs;
+        uint8_t rateDiv;
+        AsyncWebSocketSharedBuffer buffer;
+        uint16_t fields;
+    };
+    ClientPlan plans[DEFAULT_MAX_WS_CLIENTS];
+    size_t planCount = 0;
+    uint16_t needed = 0;
+    uint32_t queueMax = 0;
+    uint32_t now = millis();
+    if (xSemaphoreTake(wsMutex, pdMS_TO_TICKS(50)) != pdTRUE) return;
+    for (AsyncWebSocketClient& c : ws.getClients()) {
+        WSClientState* state = (WSClientState*)c._tempObject;
+        if (c.status() != WS_CONNECTED || !state) continue;
+        if (planCount == DEFAULT_MAX_WS_CLIENTS) break;
+        // Laufzeitmessung unabhängig von der Telemetrie, aber nicht in eine volle Warteschlange
+        if (now - state->lastPingMs >= WS_PING_INTERVAL_MS && c.queueLen() < WS_TELEMETRY_QUEUE_LIMIT) {
+            sendPing(c, state, now);
+        }
+        ClientPlan& p = plans[planCount++];
+        p.id = c.id();
+        p.gen = state->subscriptionGen;
+        p.deltas = state->deltas;
+        p.topics = dueTopics(state, now);
+        p.keyframe = !state->deltas || state->keyframePending ||
+                     now - state->lastKeyframeMs >= WS_TELEMETRY_KEYFRAME_MS;
+        // Keyframe eines Abonnenten: alle abonnierten Themen, auch wenn ihre Rate noch läuft
+        if (state->deltas && p.keyframe && p.topics) p.topics = subscribedTopics(state);
+        p.queue = c.queueLen();
+        if (p.queue > queueMax) queueMax = p.queue;
+        if (p.topics && p.queue >= WS_TELEMETRY_QUEUE_LIMIT) {
+            state->telemetryDropped++;
+            for (int t = 0; t < WSControl::TOPIC_COUNT; t++) {
+                if (p.topics & (1 << t)) state->topicLastMs[t] = now;
+            }
+            p.topics = 0;
+        }
+        memcpy(p.hz, state->topicHz, sizeof(p.hz));
+        memcpy(p.hash, state->fieldHash, sizeof(p.hash));
+        p.sent = state->telemetrySent;
+        p.dropped = state->telemetryDropped;
+        p.clockValid = state->clockValid;
+        p.rttUs = state->rttUs;
+        p.rttMinUs = state->rttMinUs;
+        p.oneWayUs = state->oneWayUs;
+        p.offsetMs = state->clockOffsetMs;
+        p.rateDiv = state->rateDiv;
+        needed |= topicFields(p.topics);
+    }
+    xSemaphoreGive(wsMutex);
+    // Für die Aufteilung der Funkzeit (RadioScheduler): wie voll ist es auf dem WebSocket?
+    wsClientCount = (uint8_t)planCount;
+    wsTxQueueMax = (uint16_t)std::min<uint32_t>(queueMax, UINT16_MAX);
+    if (needed == 0) return;
+
+    // 2) Ohne Sperre: nur benötigte Felder aus dem letzten Snapshot füllen
+    const TelemetrySnapshot& telemetry = board->getTelemetry();
+    JsonDocument doc;
+    auto want = [needed](TelemetryField f) { return (needed & (1 << f)) != 0; };
+
+    if (want(FIELD_BATTERY_VOLTAGE) || want(FIELD_BATTERY_PERCENTAGE) || want(FIELD_MOTOR_CURRENTS)) {
+        // Gerundet, damit ADC-Rauschen nicht jedes Delta füllt
+        PowerTelemetry power = telemetry.power.read();
+        doc["batteryVoltage"] = roundf(power.batteryVoltage * 100) / 100;
+        doc["batteryPercentage"] = roundf(power.batteryPercentage * 10) / 10;
+        JsonArray motorCurrents = doc["motorCurrents"].to<JsonArray>();
+        for (int i = 0; i < 2; i++) {
+            motorCurrents.add(roundf(power.hbridgeAmps[i] * 1000) / 1000);
+        }
+    }
+
+    if (want(FIELD_SERVOS) || want(FIELD_MOTOR_PWMS)) {
+        ActuatorTelemetry actuators = telemetry.actuators.read();
+        JsonArray servos = doc["servos"].to<JsonArray>();
+        for (int i = 0; i < 3; i++) {
+            servos.add(actuators.servos[i]);
+        }
+        JsonArray motorPWMs = doc["motorPWMs"].to<JsonArray>();
         for (int i = 0; i < 4; i++) {
-            //TODO: Check if controller is connected or Wifi
-            //board->controlMotorStop(i);
+            motorPWMs.add(actuators.motorPWMs[i]);
         }
     }
-    if (xSemaphoreTake(wsMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        if (ws.count() > 0) {
-            JsonDocument doc;
-            doc["batteryVoltage"] = board->getBatteryVoltage();
-            doc["batteryPercentage"] = board->getBatteryPercentage();
 
-            JsonArray servos = doc["servos"].to<JsonArray>();
-            for (int i = 0; i < 3; i++) {
-                servos.add(board->getServoAngle(i));
-            }
+    if (want(FIELD_FIRST_LED) || want(FIELD_LED_POWER) || want(FIELD_LED_STREAM)) {
+        LedTelemetry leds = telemetry.leds.read();
+        JsonObject firstLED = doc["firstLED"].to<JsonObject>();
+        firstLED["r"] = leds.firstLED[0];
+        firstLED["g"] = leds.firstLED[1];
+        firstLED["b"] = leds.firstLED[2];
+
+        JsonObject ledPower = doc["ledPower"].to<JsonObject>();
+        ledPower["budgetMw"]    = leds.budgetMw;
+        ledPower["estimatedMw"] = leds.estimatedMw;
+        ledPower["brightness"]  = leds.brightness;
+        ledPower["showUs"]      = leds.showUs;
+        ledPower["showMaxUs"]   = leds.showMaxUs;
+
+        const LEDStreamStats& ls = leds.stream;
+        if (ls.active || ls.received > 0) {
+            JsonObject stream = doc["ledStream"].to<JsonObject>();
+            stream["active"]    = ls.active;
+            stream["fps"]       = ls.fps;
+            stream["buffered"]  = ls.buffered;
+            stream["received"]  = ls.received;
+            stream["underruns"] = ls.underruns;
+            stream["late"]      = ls.late;
+            stream["dropped"]   = ls.dropped;
+            stream["invalid"]   = ls.invalid;
+        }
+    }
+
+    if (want(FIELD_WS_CONTROL)) {
+        JsonObject wsCtl = doc["wsControl"].to<JsonObject>();
+        wsCtl["json"]    = wsStats.json;
+        wsCtl["binary"]  = wsStats.binary;
+        wsCtl["invalid"] = wsStats.invalid;
+        wsCtl["stale"]   = wsStats.stale;
+        wsCtl["reassembled"] = wsStats.reassembled;
+        wsCtl["oversize"]    = wsStats.oversize;
+        wsCtl["unknownKeys"] = wsStats.unknownKeys;
+        const WSControl::ArenaStats& arena = wsJsonArena.getStats();
+        wsCtl["arenaPeak"]   = arena.peak;
+        wsCtl["arenaAllocs"] = arena.allocs;
+        wsCtl["heapAllocs"]  = arena.heapAllocs;
+    }
 
-            JsonArray motorPWMs = doc["motorPWMs"].to<JsonArray>();
-            for (int i = 0; i < 4; i++) {
-                motorPWMs.add(board->getMotorPWM(i));
+    if (want(FIELD_CONTROLLERS)) {
+        JsonArray ctrls = doc["controllers"].to<JsonArray>();
+        for (int i = 0; i < BP32_MAX_GAMEPADS; i++) {
+            ControllerInputSnapshot s = telemetry.controllers[i].read();
+            if (!s.connected) continue;
+            JsonObject c = ctrls.add<JsonObject>();
+            c["idx"]     = i;
+            c["buttons"] = s.buttons;
+            c["dpad"]    = s.dpad;
+            c["x"]       = s.axisX;
+            c["y"]       = s.axisY;
+            c["rx"]      = s.axisRX;
+            c["ry"]      = s.axisRY;
+        }
+    }
+
+    if (want(FIELD_WS_CLIENTS)) {
+        JsonArray clients = doc["wsClients"].to<JsonArray>();
+        for (size_t i = 0; i < planCount; i++) {
+            JsonObject o = clients.add<JsonObject>();
+            o["id"]      = plans[i].id;
+            o["delta"]   = plans[i].deltas;
+            JsonArray hz = o["hz"].to<JsonArray>();
+            for (int t = 0; t < WSControl::TOPIC_COUNT; t++) hz.add(plans[i].hz[t]);
+            o["queue"]   = plans[i].queue;
+            o["sent"]    = plans[i].sent;
+            o["dropped"] = plans[i].dropped;
+            o["rateDiv"] = plans[i].rateDiv;
+            if (plans[i].clockValid) {
+                // auf 0,1 ms gerundet, damit Jitter nicht jedes Delta füllt
+                o["rttMs"]    = roundf(plans[i].rttUs / 100.0f) / 10;
+                o["rttMinMs"] = roundf(plans[i].rttMinUs / 100.0f) / 10;
+                o["offsetMs"] = plans[i].offsetMs;
+                o["owdMs"]    = roundf(plans[i].oneWayUs / 100.0f) / 10;
             }
+        }
+    }
 
-            JsonArray motorCurrents = doc["motorCurrents"].to<JsonArray>();
-            for (int i = 0; i < 2; i++) {
-                motorCurrents.add(board->getHBridgeAmps(i));
+    // Jedes Feld einmal serialisieren; der Hash zeigt, ob es sich für einen Client geändert hat
+    std::string frags;
+    uint16_t fragOff[FIELD_COUNT] = {}, fragLen[FIELD_COUNT] = {};
+    uint32_t fragHash[FIELD_COUNT] = {};
+    uint16_t present = 0;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        JsonVariantConst v = doc[TELEMETRY_FIELDS[f].key];
+        if (!want((TelemetryField)f) || v.isNull()) continue;
+        size_t n = measureJson(v);
+        size_t off = frags.size();
+        frags.resize(off + n + 1);
+        serializeJson(v, &frags[off], n + 1);
+        frags.resize(off + n);
+        fragOff[f] = (uint16_t)off;
+        fragLen[f] = (uint16_t)n;
+        fragHash[f] = fragmentHash(frags.data() + off, n);
+        present |= 1 << f;
+    }
+
+    // Nachricht je Feldauswahl einmal bauen; Clients mit gleicher Auswahl teilen den Puffer
+    for (size_t i = 0; i < planCount; i++) {
+        ClientPlan& p = plans[i];
+        p.fields = topicFields(p.topics) & present;
+        if (!p.keyframe) {
+            for (int f = 0; f < FIELD_COUNT; f++) {
+                if ((p.fields & (1 << f)) && p.hash[f] == fragHash[f]) p.fields &= ~(1 << f);
+            }
+        }
+        if (p.fields == 0) continue;
+        bool markKeyframe = p.deltas && p.keyframe;
+        for (size_t j = 0; j < i && !p.buffer; j++) {
+            if (plans[j].buffer && plans[j].fields == p.fields &&
+                (plans[j].deltas && plans[j].keyframe) == markKeyframe) {
+                p.buffer = plans[j].buffer;
             }
+        }
+        if (p.buffer) continue;
+        std::string msg = markKeyframe ? "{\"kf\":1" : "{";
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            if (!(p.fields & (1 << f))) continue;
+            if (msg.size() > 1) msg += ',';
+            msg += '"';
+            msg += TELEMETRY_FIELDS[f].key;
+            msg += "\":";
+            msg.append(frags, fragOff[f], fragLen[f]);
+        }
+        msg += '}';
+        p.buffer = std::make_shared<std::vector<uint8_t>>(msg.begin(), msg.end());
+    }
 
-            CRGB ledColor = board->getLEDColor(0);
-            JsonObject firstLED = doc["firstLED"].to<JsonObject>();
-            firstLED["r"] = ledColor.r;
-            firstLED["g"] = ledColor.g;
-            firstLED["b"] = ledColor.b;
-
-            JsonArray ctrls = doc["controllers"].to<JsonArray>();
-            for (int i = 0; i < BP32_MAX_GAMEPADS; i++) {
-                const ControllerInputSnapshot& s = board->getControllerSnapshot(i);
-                if (!s.connected) continue;
-                JsonObject c = ctrls.add<JsonObject>();
-                c["idx"]     = i;
-                c["buttons"] = s.buttons;
-                c["dpad"]    = s.dpad;
-                c["x"]       = s.axisX;
-                c["y"]       = s.axisY;
-                c["rx"]      = s.axisRX;
-                c["ry"]      = s.axisRY;
+    // 3) Sperre nur für das Einreihen und das Nachführen des Client-Zustands
+    if (isWifiDisabled()) return;
+    if (xSemaphoreTake(wsMutex, pdMS_TO_TICKS(50)) != pdTRUE) return;
+    for (AsyncWebSocketClient& c : ws.getClients()) {
+        WSClientState* state = (WSClientState*)c._tempObject;
+        if (c.status() != WS_CONNECTED || !state) continue;
+        ClientPlan* p = nullptr;
+        for (size_t i = 0; i < planCount && !p; i++) {
+            if (plans[i].id == c.id()) p = &plans[i];
+        }
+        // Unbekannt oder inzwischen neu abonniert: beim nächsten Takt
+        if (!p || !p->topics || p->gen != state->subscriptionGen) continue;
+        for (int t = 0; t < WSControl::TOPIC_COUNT; t++) {
+            if (p->topics & (1 << t)) state->topicLastMs[t] = now;
+        }
+        if (!p->buffer) continue;   // nichts geändert
+        if (c.text(p->buffer)) {
+            state->telemetrySent++;
+            for (int f = 0; f < FIELD_COUNT; f++) {
+                if (p->fields & (1 << f)) state->fieldHash[f] = fragHash[f];
+            }
+            if (p->deltas && p->keyframe) {
+                state->keyframePending = false;
+                state->lastKeyframeMs = now;
             }
-            String jsonString;
-            serializeJson(doc, jsonString);
-            ws.textAll(jsonString);
+        } else {
+            state->telemetryDropped++;
         }
-        xSemaphoreGive(wsMutex);
     }
+    xSemaphoreGive(wsMutex);
 }
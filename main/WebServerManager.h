@@ -7,11 +7,140 @@
 #include <WiFi.h>
 #include <ArduinoJson.h>
 #include <Update.h>
+#include <atomic>
 #include <functional>
+#include "WSControl.h"
 
 class TinkerThinkerBoard; 
 class ConfigManager;
 
+// Größte zusammengesetzte WS-Nachricht (Fragmente bzw. auf mehrere TCP-Segmente verteilte Frames).
+// Deckt Steuer-JSON und einen rohen LED-Frame mit 300 Pixeln (8 + 900 Byte) ab.
+#ifndef WS_MESSAGE_MAX
+#define WS_MESSAGE_MAX 1024
+#endif
+
+// Telemetrie: Standardrate je Client (zugleich Höchstrate, Takt des WebClientTask), Grenze der
+// Sendewarteschlange, ab der ein Client keine weiteren Statusnachrichten bekommt (die nächste ist
+// ohnehin aktueller), und Abstand der Keyframes für Clients mit Delta-Telemetrie
+#ifndef WS_TELEMETRY_DEFAULT_HZ
+#define WS_TELEMETRY_DEFAULT_HZ 10
+#endif
+#ifndef WS_TELEMETRY_QUEUE_LIMIT
+#define WS_TELEMETRY_QUEUE_LIMIT 2
+#endif
+#ifndef WS_TELEMETRY_KEYFRAME_MS
+#define WS_TELEMETRY_KEYFRAME_MS 2000
+#endif
+
+// Laufzeitmessung: Abstand der Pings je Client, Fenster für die Auswahl des besten Samples
+// (kleinste RTT = am wenigsten Warteschlange, also die beste Uhrzeit-Differenz) und die
+// geglättete RTT, ab der die Telemetrie des Clients gedrosselt wird (je Vielfaches ein Teiler mehr)
+#ifndef WS_PING_INTERVAL_MS
+#define WS_PING_INTERVAL_MS 2000
+#endif
+#ifndef WS_CLOCK_SAMPLES
+#define WS_CLOCK_SAMPLES 8
+#endif
+#ifndef WS_TELEMETRY_RTT_SLOW_MS
+#define WS_TELEMETRY_RTT_SLOW_MS 150
+#endif
+#ifndef WS_TELEMETRY_MAX_RATE_DIV
+#define WS_TELEMETRY_MAX_RATE_DIV 4
+#endif
+
+// Felder der Statusnachricht; jedes gehört zu genau einem Thema (WSControl::TelemetryTopic)
+enum TelemetryField : uint8_t {
+    FIELD_BATTERY_VOLTAGE,
+    FIELD_BATTERY_PERCENTAGE,
+    FIELD_SERVOS,
+    FIELD_MOTOR_PWMS,
+    FIELD_MOTOR_CURRENTS,
+    FIELD_FIRST_LED,
+    FIELD_LED_POWER,
+    FIELD_LED_STREAM,
+    FIELD_WS_CONTROL,
+    FIELD_CONTROLLERS,
+    FIELD_WS_CLIENTS,
+    FIELD_COUNT
+};
+
+// Zustand je WebSocket-Client, hängt an AsyncWebSocketClient::_tempObject
+struct WSClientState {
+    WSClientState() {
+        for (int t = 0; t < WSControl::TOPIC_COUNT; t++) topicHz[t] = WS_TELEMETRY_DEFAULT_HZ;
+    }
+    bool seqValid = false;
+    uint16_t lastSeq = 0;
+    uint32_t lastClientMs = 0;
+    // Telemetrie je Client: Rate je Thema, 0 = aus. {"telemetry_hz": n} setzt alle Themen und
+    // liefert vollständige Nachrichten; nach {"subscribe": {...}} nur die Themen, und zwischen
+    // den Keyframes nur geänderte Felder.
+    uint8_t topicHz[WSControl::TOPIC_COUNT];
+    uint32_t topicLastMs[WSControl::TOPIC_COUNT] = {};
+    bool deltas = false;
+    bool keyframePending = true;
+    uint32_t lastKeyframeMs = 0;
+    uint32_t subscriptionGen = 0;        // ändert sich mit jedem subscribe/telemetry_hz
+    uint32_t fieldHash[FIELD_COUNT] = {}; // Stand, den der Client zuletzt bekommen hat
+    uint32_t telemetrySent = 0;
+    uint32_t telemetryDropped = 0;  // Warteschlange voll, Statusnachricht ausgelassen
+    // Laufzeit und Uhrvergleich (NTP-artig): Firmware sendet {"ping": t1}, Client antwortet mit
+    // {"pong": [t1, t2, t3]}. clockOffsetMs = Client-Uhr minus millis(), aus dem Sample mit der
+    // kleinsten RTT im Fenster; damit wird für gestempelte Befehle die Einweglatenz geschätzt.
+    uint32_t lastPingMs = 0;
+    uint32_t pingsSent = 0;
+    uint32_t pongs = 0;
+    uint32_t rttSampleUs[WS_CLOCK_SAMPLES] = {};
+    int32_t offsetSampleMs[WS_CLOCK_SAMPLES] = {};
+    uint8_t clockSamples = 0;       // Anzahl gültiger Samples (bis WS_CLOCK_SAMPLES)
+    uint8_t clockNext = 0;
+    uint32_t rttUs = 0;             // geglättet (1/8 wie TCP-SRTT)
+    uint32_t rttMinUs = 0;          // Minimum im Fenster
+    int32_t clockOffsetMs = 0;
+    bool clockValid = false;
+    uint32_t oneWayUs = 0;          // geglättete Einweglatenz gestempelter Befehle
+    uint32_t lastOneWayMs = 0;
+    uint8_t rateDiv = 1;            // Telemetrie-Teiler aus der RTT (1 = volle Rate)
+    // Puffer zum Zusammensetzen; Nachrichten in einem Stück werden direkt aus dem Frame gelesen
+    size_t msgLen = 0;
+    bool msgOverflow = false;
+    uint8_t msgBuf[WS_MESSAGE_MAX];
+};
+
+// Empfangene Steuer-Frames je Format
+struct WSControlStats {
+    uint32_t json = 0;
+    uint32_t binary = 0;
+    uint32_t invalid = 0;
+    uint32_t stale = 0;   // binär: Sequenznummer nicht neuer als die zuletzt ausgeführte
+    uint32_t reassembled = 0; // aus mehreren Teilen zusammengesetzte Nachrichten
+    uint32_t oversize = 0;    // größer als WS_MESSAGE_MAX, verworfen
+    uint32_t unknownKeys = 0; // JSON-Schlüssel ohne Befehl
+};
+
+// WLAN-Zustand; nur der WifiRadio-Task wechselt ihn. Off = nie gestartet oder bis zum Neustart aus.
+enum class WifiState : uint8_t { Off, Starting, Up, Pausing, Paused };
+
+// Gemessene Übergänge des WifiRadio-Tasks
+struct WifiRadioStats {
+    uint32_t requests = 0;
+    uint32_t coalesced = 0;      // Anforderungen, die eine spätere noch in der Warteschlange überholt hat
+    uint32_t transitions = 0;
+    uint32_t lastQueueMs = 0;    // Anforderung bis Beginn der Umschaltung
+    uint32_t lastStartMs = 0;    // Starting -> Up
+    uint32_t maxStartMs = 0;
+    uint32_t lastPauseMs = 0;    // Pausing -> Paused/Off
+    uint32_t maxPauseMs = 0;
+    // STA: WiFi.begin() bis WL_CONNECTED (inkl. DHCP), nur erfolgreiche Verbindungen
+    uint32_t lastConnectMs = 0;
+    uint32_t maxConnectMs = 0;
+    uint32_t directConnects = 0; // mit gemerktem Kanal/BSSID, ohne Scan
+    uint32_t scanConnects = 0;   // voller Scan (kein Cache oder Direktversuch gescheitert)
+    uint32_t directMisses = 0;   // Direktversuch gescheitert, auf Scan zurückgefallen
+    bool staticIp = false;
+};
+
 struct ConnectedControllerInfo {
     bool connected = false;
     char mac[18] = {};
@@ -22,11 +151,19 @@ class WebServerManager {
 public:
     WebServerManager(TinkerThinkerBoard* board, ConfigManager* config);
     void init();
+    // Nur einreihen, kehren sofort zurück; der WifiRadio-Task schaltet nacheinander um
     void requestWifiDisable(bool untilRestart);
     void requestWifiEnable();
     void sendStatusUpdate();
-    bool isWifiDisabled() const { return wifiDisabledUntilRestart || wifiTemporarilyDisabled; }
+    bool isWifiDisabled() const { return getWifiState() != WifiState::Up; }
     bool isWifiDisabledUntilRestart() const { return wifiDisabledUntilRestart; }
+    WifiState getWifiState() const { return (WifiState)wifiState.load(); }
+    WifiRadioStats getWifiRadioStats() const;
+    // WS-Last, Stand der letzten Telemetrie-Runde
+    uint8_t getWsClientCount() const { return wsClientCount; }
+    uint16_t getWsTxQueueMax() const { return wsTxQueueMax; }
+    uint32_t getLastWsControlMs() const { return lastWsControlMs; }
+    static const char* wifiStateName(WifiState state);
 
     void notifyControllerConnected(int slot, const char* mac, const char* model);
     void notifyControllerDisconnected(int slot);
@@ -38,23 +175,68 @@ private:
     AsyncWebServer server;
     AsyncWebSocket ws;
     SemaphoreHandle_t wsMutex = xSemaphoreCreateMutex();
-    //Timeout als millisekunden seit dem letzten paket
-    unsigned long lastPacketTime = 0;
-    bool wifiDisabledUntilRestart = false;
-    bool wifiTemporarilyDisabled = false;
-    bool wifiShutdownInProgress = false;
-    bool wifiStartupInProgress = false;
+    std::atomic<bool> wifiDisabledUntilRestart{false};
     bool _otaError = false;
 
+    // Ein dauerhafter Task statt eines neuen Tasks je Umschaltung. Anforderungen kommen über die
+    // Queue; was sich beim Abholen schon angesammelt hat, wird zusammengefasst (die letzte zählt,
+    // "bis zum Neustart aus" gewinnt immer).
+    enum class WifiCommand : uint8_t { Enable, Pause, DisableUntilRestart };
+    struct WifiRequest {
+        WifiCommand cmd;
+        uint32_t atMs;
+    };
+    static const uint32_t WIFI_DISABLE_GRACE_MS = 150;   // Antwort auf POST /wifi/disable noch ausliefern
+    QueueHandle_t wifiQueue = nullptr;
+    std::atomic<uint8_t> wifiState{(uint8_t)WifiState::Off};
+    std::atomic<uint8_t> lastWifiCommand{(uint8_t)WifiCommand::Enable};
+    bool serverStarted = false;
+    // radioStats schreibt nur der WifiRadio-Task; nach jeder Umschaltung kopiert er sie unter
+    // radioStatsMutex nach radioStatsShared, die andere Tasks lesen. requests zählt der Aufrufer.
+    WifiRadioStats radioStats;
+    WifiRadioStats radioStatsShared;
+    SemaphoreHandle_t radioStatsMutex = xSemaphoreCreateMutex();
+    std::atomic<uint32_t> wifiRequests{0};
+    void publishRadioStats();
+    void postWifiCommand(WifiCommand cmd);
+    bool wifiStopPending(uint32_t waitMs);
+    void radioLoop();
+    void setWifiState(WifiState state);
+
+    // Zuletzt erfolgreicher AP im STA-Modus (NVS), damit der nächste Start ohne Scan direkt
+    // auf Kanal und BSSID verbindet. Gilt nur, solange die SSID gleich bleibt.
+    struct StaCache {
+        String ssid;
+        uint8_t bssid[6] = {0};
+        uint8_t channel = 0;
+        bool valid = false;
+    };
+    enum class StaResult : uint8_t { Connected, Failed, Aborted };
+    static const uint32_t STA_DIRECT_TIMEOUT_MS = 3000;
+    static const uint32_t STA_TIMEOUT_MS = 10000;
+    static constexpr const char* STA_CACHE_NS = "tt_wifi";
+    StaCache staCache;
+    bool staCacheLoaded = false;
+    void loadStaCache();
+    void saveStaCache(const String& ssid);
+    bool applyStaticIp();
+    StaResult connectSta(const String& ssid, const String& pass, const StaCache* direct, uint32_t timeoutMs);
+
     void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
                           AwsEventType type, void *arg, uint8_t *data, size_t len);
+    void handleWsMessage(AsyncWebSocketClient* client, uint8_t opcode, const uint8_t* data, size_t len);
+    void handleBinaryControl(AsyncWebSocketClient* client, const uint8_t* data, size_t len);
+    WSControlStats wsStats;
+    std::atomic<uint8_t> wsClientCount{0};
+    std::atomic<uint16_t> wsTxQueueMax{0};
+    std::atomic<uint32_t> lastWsControlMs{0};
+    WSControl::JsonArena wsJsonArena;   // nur im AsyncTCP-Task benutzt (alle WS-Events)
     void setupRoutes();
     void setupWebSocket();
-    void startWifi();
+    bool startWifi();   // false: STA-Aufbau wegen einer Pause abgebrochen
     void handleConfig(AsyncWebServerRequest* request);
     void disableWifiUntilRestart();
     void disableWifiInternal(bool permanent);
-    void enableWifiInternal();
 
     ConnectedControllerInfo connectedControllers[4];
     std::function<void()> whitelistApplyCallback;
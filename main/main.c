@@ -15,6 +15,8 @@
 #include <arduino_platform.h>
 #include <uni.h>
 
+#include "BootTimeline.h"
+
 //
 // Autostart
 //
@@ -32,6 +34,9 @@ int app_main(void) {
 #endif  // CONFIG_BLUEPAD32_USB_CONSOLE_ENABLE
 #endif  // CONFIG_ESP_CONSOLE_UART_NONE
 
+    // Ends in setup(): covers BTstack/Bluepad32 init and the Arduino bootstrap
+    boot_phase_begin("btstack");
+
     // Configure BTstack for ESP32 VHCI Controller
     btstack_init();
 
@@ -8,9 +8,12 @@
 #include <Bluepad32.h>
 #include <WiFi.h>
 #include "TinkerThinkerBoard.h"
+#include "BootTimeline.h"
+#include "RadioScheduler.h"
 #include "soc/soc.h"
 #include "soc/rtc_cntl_reg.h"
 #include "esp_bt.h"
+#include "esp_timer.h"
 #include <uni.h>
 
 // Removed DFPlayer and HardwareSerial includes
@@ -29,23 +32,85 @@ TinkerThinkerBoard board(&configManager);
 ControllerPtr myControllers[BP32_MAX_GAMEPADS];
 // Input binding processor
 #include "InputBindingManager.h"
+#include "WSControl.h"
 static InputBindingManager inputBindings(&board, &configManager);
 
 long timestampServo = 0;
 static uint32_t lastHeartbeatMs = 0;
 
-enum class RadioMode { Normal, BluetoothOnly, WifiOnly };
+// Funkzeit BT/WLAN: Modus, WLAN-Pause nach Connect und Such-Takt (RadioScheduler.h)
+class ArduinoRadioClock : public RadioClock {
+public:
+    uint32_t nowMs() override { return millis(); }
+};
+
+// Zuletzt verbundene Controller (nur im RAM). Nach einem Verlust werden sie gezielt zurückerwartet,
+// statt gleich wieder voll zu suchen; die Link-Keys dazu hält Bluepad32.
+struct KnownController {
+    bd_addr_t addr;
+    uint32_t lostAtMs;
+    bool used;
+    bool lost;
+};
+static KnownController knownControllers[BP32_MAX_GAMEPADS];
+static bd_addr_t controllerAddr[BP32_MAX_GAMEPADS];
+
+static KnownController* findKnownController(const bd_addr_t addr) {
+    for (KnownController& k : knownControllers) {
+        if (k.used && memcmp(k.addr, addr, sizeof(bd_addr_t)) == 0) return &k;
+    }
+    return nullptr;
+}
+
+// Verloren innerhalb von bt_reconnect_ms
+static bool knownControllerExpected(const KnownController& k, uint32_t nowMs) {
+    return k.lost && nowMs - k.lostAtMs < (uint32_t)configManager.getBtReconnectMs();
+}
+
+class Bp32ScanControl : public BtScanControl {
+public:
+    void setScanEnabled(bool on) override { BP32.enableNewBluetoothConnections(on); }
+    void disconnectAll() override {
+        for (int i = 0; i < BP32_MAX_GAMEPADS; i++) {
+            if (myControllers[i] && myControllers[i]->isConnected()) {
+                myControllers[i]->disconnect();
+            }
+        }
+    }
+    void setFastPageScan(bool on) override { uni_bt_set_fast_page_scan_safe(on); }
+    void reconnectKnown() override {
+        uint32_t now = millis();
+        for (const KnownController& k : knownControllers) {
+            if (knownControllerExpected(k, now)) uni_bt_reconnect_safe(k.addr);
+        }
+    }
+};
+
+class BoardWifiControl : public WifiControl {
+public:
+    void requestEnable() override { board.requestWifiEnable(); }
+    void requestPause() override { board.requestWifiDisable(false); }
+};
+
+static ArduinoRadioClock radioClock;
+static Bp32ScanControl btScanControl;
+static BoardWifiControl wifiControl;
+static RadioScheduler radioScheduler(radioClock, btScanControl, wifiControl);
 static RadioMode radioMode = RadioMode::Normal;
-static RadioMode lastAppliedMode = RadioMode::Normal;
-static bool radioModeAppliedOnce = false;
-static int modeStep = 0;
 static uint32_t modeButtonPressStartMs = 0;
 static bool modeButtonLongPressHandled = false;
 static const uint32_t modeButtonHoldToSwitchMs = 700;
-static uint32_t wifiPauseUntilMs = 0;
-static bool wifiPausedForBt = false;
-static const uint32_t wifiPauseOnConnectMs = 3000;
-static uint32_t scanRestartAfterMs = 0;   // Pause nach Disconnect bevor Scan neu startet
+static const uint32_t wsControlActiveMs = 1000;   // so lange gilt die Weboberfläche nach einem Befehl als aktiv
+// BT-Verbindungen: während der Bedienung kurzes Abfrageintervall ohne Sniff, sonst stromsparend
+// (Link-Policy in components/bluepad32/bt/uni_bt_bredr.c)
+static const uint32_t btLinkIdleAfterMs = 10000;  // so lange nach der letzten Eingabe/Motorbewegung gilt der Roboter als bedient
+static const int32_t btInputActiveDeadband = 32;  // Achsen/Trigger darüber zählen als Eingabe (Bereich ±512 bzw. 0..1023)
+static uint32_t lastActivityMs = 0;
+static bool btLinksActive = true;
+// Werksreset-Geste: Taste in diesem Fenster nach dem Start drücken und 10 s halten.
+// Abgefragt wird in loop(), der Start selbst wartet nicht mehr darauf.
+static const uint32_t startupResetArmMs = 2500;
+static uint32_t startupResetArmUntilMs = 0;
 
 static void setStatusLed(uint8_t r, uint8_t g, uint8_t b);
 static void applyRadioMode(RadioMode mode);
@@ -90,10 +155,10 @@ static String sanitizeDeviceName(String name) {
 
 template <typename TDoc>
 static void sendSerialJson(TDoc& doc) {
-    String out;
-    serializeJson(doc, out);
+    // Direkt auf die Schnittstelle serialisieren, ohne den Text vorher in einem String zu sammeln
     Serial.print("TTJSON:");
-    Serial.println(out);
+    serializeJson(doc, Serial);
+    Serial.println();
 }
 
 template <typename TDoc>
@@ -105,6 +170,66 @@ static void fillSerialInfo(TDoc& doc) {
     doc["speed_multiplier"] = board.getSpeedMultiplier();
     doc["wifi_mac"] = WiFi.macAddress();
     doc["bt_mac"] = formatBtMac();
+    doc["config_save_requests"] = configManager.getSaveRequests();
+    doc["config_save_writes"] = configManager.getSaveWrites();
+    doc["config_load_us"] = configManager.getLoadUs();
+    doc["config_load_source"] = configManager.getLoadSource();
+    WifiRadioStats radio = board.getWifiRadioStats();
+    JsonObject wifiRadio = doc["wifi_radio"].template to<JsonObject>();
+    wifiRadio["state"] = WebServerManager::wifiStateName(board.getWifiState());
+    wifiRadio["requests"] = radio.requests;
+    wifiRadio["coalesced"] = radio.coalesced;
+    wifiRadio["transitions"] = radio.transitions;
+    wifiRadio["last_queue_ms"] = radio.lastQueueMs;
+    wifiRadio["last_start_ms"] = radio.lastStartMs;
+    wifiRadio["max_start_ms"] = radio.maxStartMs;
+    wifiRadio["last_pause_ms"] = radio.lastPauseMs;
+    wifiRadio["max_pause_ms"] = radio.maxPauseMs;
+    wifiRadio["last_connect_ms"] = radio.lastConnectMs;
+    wifiRadio["max_connect_ms"] = radio.maxConnectMs;
+    wifiRadio["direct_connects"] = radio.directConnects;
+    wifiRadio["scan_connects"] = radio.scanConnects;
+    wifiRadio["direct_misses"] = radio.directMisses;
+    wifiRadio["static_ip"] = radio.staticIp;
+    const RadioSchedulerStats& sched = radioScheduler.getStats();
+    JsonObject btScan = doc["bt_scan"].template to<JsonObject>();
+    btScan["mode"] = RadioScheduler::modeName(radioScheduler.getMode());
+    btScan["policy"] = RadioScheduler::policyName(radioScheduler.getPolicy());
+    btScan["scanning"] = radioScheduler.isScanEnabled();
+    btScan["on_ms"] = sched.window.onMs;
+    btScan["off_ms"] = sched.window.offMs;
+    btScan["windows"] = sched.scanWindows;
+    btScan["paired_windows"] = sched.pairedWindows;
+    btScan["idle_windows"] = sched.idleWindows;
+    btScan["connects"] = sched.connects;
+    btScan["losses"] = sched.losses;
+    btScan["last_pair_ms"] = sched.lastPairMs;
+    btScan["scan_on_ms"] = sched.scanOnMs;
+    btScan["reconnecting"] = radioScheduler.isReconnecting();
+    btScan["reconnects"] = sched.reconnects;
+    btScan["reconnect_timeouts"] = sched.reconnectTimeouts;
+    btScan["last_reconnect_ms"] = sched.lastReconnectMs;
+    btScan["max_reconnect_ms"] = sched.maxReconnectMs;
+    btScan["direct_reconnects"] = sched.directReconnects;
+    // Link-Policy und Report-Takt je BR/EDR-Controller. Nur lesend aus dem BT-Task übernommen,
+    // ein einzelner Wert kann also mitten in einer Aktualisierung stehen.
+    JsonArray btLinks = doc["bt_links"].template to<JsonArray>();
+    for (int i = 0; i < CONFIG_BLUEPAD32_MAX_DEVICES; i++) {
+        const uni_hid_device_t* d = uni_hid_device_get_instance_for_idx(i);
+        if (!d || d->conn.state != UNI_BT_CONN_STATE_DEVICE_READY ||
+            d->conn.protocol != UNI_BT_CONN_PROTOCOL_BR_EDR) continue;
+        JsonObject link = btLinks.add<JsonObject>();
+        link["addr"] = bd_addr_to_str(d->conn.btaddr);
+        link["policy"] = uni_bt_conn_link_state_name(d->conn.link_state);
+        link["role"] = d->conn.role == HCI_ROLE_MASTER ? "master" : d->conn.role == HCI_ROLE_SLAVE ? "slave" : "?";
+        link["sniff_interval"] = d->conn.sniff_interval;
+        link["poll_latency_us"] = d->conn.poll_latency_us;
+        link["reports"] = d->conn.reports.count;
+        link["avg_interval_us"] = d->conn.reports.avg_interval_us;
+        link["max_gap_ms"] = d->conn.reports.max_gap_ms;
+        link["missed"] = d->conn.reports.missed;
+        link["periodic"] = d->conn.reports.periodic;
+    }
     doc["firmware"] = BP32.firmwareVersion();
     doc["uptime_ms"] = millis();
 }
@@ -112,36 +237,16 @@ static void fillSerialInfo(TDoc& doc) {
 template <typename TDoc>
 static void fillSerialConfig(TDoc& doc) {
     fillSerialInfo(doc);
-    doc["wifi_password"] = configManager.getWifiPassword();
-    doc["hotspot_password"] = configManager.getHotspotPassword();
-    doc["led_count"] = configManager.getLedCount();
-    doc["led_brightness"] = configManager.getLedBrightness();
-    doc["led_gamma"] = configManager.getLedGamma();
-    doc["ws_invert_x"] = configManager.getWsInvertX();
-    doc["ws_invert_y"] = configManager.getWsInvertY();
-    doc["ws_swap_sides"] = configManager.getWsSwapSides();
-    doc["bt_invert_x"] = configManager.getBtInvertX();
-    doc["bt_invert_y"] = configManager.getBtInvertY();
-    doc["bt_swap_axes"] = configManager.getBtSwapAxes();
-    doc["motor_left_gui"] = configManager.getMotorLeftGUI();
-    doc["motor_right_gui"] = configManager.getMotorRightGUI();
-    doc["drive_mixer"] = configManager.getDriveMixer();
-    doc["drive_turn_gain"] = configManager.getDriveTurnGain();
-    doc["drive_axis_deadband"] = configManager.getDriveAxisDeadband();
-    doc["motor_curve_type"] = configManager.getMotorCurveType();
-    doc["motor_curve_strength"] = configManager.getMotorCurveStrength();
-    doc["bt_scan_on_normal_ms"] = configManager.getBtScanOnNormal();
-    doc["bt_scan_off_normal_ms"] = configManager.getBtScanOffNormal();
-    doc["bt_scan_on_sta_ms"] = configManager.getBtScanOnSta();
-    doc["bt_scan_off_sta_ms"] = configManager.getBtScanOffSta();
-    doc["bt_scan_on_ap_ms"] = configManager.getBtScanOnAp();
-    doc["bt_scan_off_ap_ms"] = configManager.getBtScanOffAp();
+    // Alle Einstellungen aus dem Schema außer control_bindings/Whitelist (zu groß für eine Zeile)
+    configManager.exportFields(doc.template as<JsonObject>());
 }
 
 static void emitSerialReady() {
     JsonDocument doc;
     doc["event"] = "ready";
     fillSerialInfo(doc);
+    doc["boot_us"] = (uint32_t)esp_timer_get_time();
+    BootTimeline::toJson(doc["boot"].to<JsonArray>());
     sendSerialJson(doc);
 }
 
@@ -189,6 +294,22 @@ static void handleSerialCommandLine(const char* rawLine) {
         return;
     }
 
+    if (!strcmp(command, "get_boot")) {
+        // Startphasen erneut abfragen, z. B. wenn der WLAN-Start beim "ready" noch lief
+        resp["event"] = "boot";
+        BootTimeline::toJson(resp["boot"].to<JsonArray>());
+        sendSerialJson(resp);
+        return;
+    }
+
+    if (!strcmp(command, "export_config")) {
+        // Vollständige Konfiguration im config.json-Format (inkl. control_bindings)
+        resp["event"] = "config_export";
+        configManager.exportJson(resp["config"].to<JsonObject>());
+        sendSerialJson(resp);
+        return;
+    }
+
     if (!strcmp(command, "set_name")) {
         const char* requestedName = cmd["name"] | "";
         String newName = sanitizeDeviceName(String(requestedName));
@@ -199,7 +320,8 @@ static void handleSerialCommandLine(const char* rawLine) {
             return;
         }
         configManager.setHotspotSSID(newName);
-        bool saved = configManager.saveConfig();
+        configManager.requestSave();
+        bool saved = configManager.flush();   // Quittung erst, wenn es im Flash steht
         resp["event"] = saved ? "config_saved" : "error";
         resp["saved"] = saved;
         resp["reboot_required"] = true;
@@ -215,90 +337,11 @@ static void handleSerialCommandLine(const char* rawLine) {
             cfg = cmd.as<JsonObject>();
         }
 
-        bool touched = false;
-        bool reapplyHardware = false;
-        bool rebootRequired = false;
-
-        if (!cfg["wifi_mode"].isNull()) {
-            const char* mode = cfg["wifi_mode"] | "AP";
-            configManager.setWifiMode(String(mode));
-            touched = true;
-            rebootRequired = true;
-        }
-        if (!cfg["wifi_ssid"].isNull()) {
-            const char* rawSsid = cfg["wifi_ssid"] | "";
-            String ssid = String(rawSsid);
-            ssid.trim();
-            configManager.setWifiSSID(ssid);
-            touched = true;
-            rebootRequired = true;
-        }
-        if (!cfg["wifi_password"].isNull()) {
-            const char* rawPass = cfg["wifi_password"] | "";
-            String pass = String(rawPass);
-            pass.trim();
-            configManager.setWifiPassword(pass);
-            touched = true;
-            rebootRequired = true;
-        }
-        if (!cfg["hotspot_ssid"].isNull()) {
-            const char* rawHotspot = cfg["hotspot_ssid"] | "";
-            String ssid = sanitizeDeviceName(String(rawHotspot));
-            if (ssid.length()) {
-                configManager.setHotspotSSID(ssid);
-                touched = true;
-                rebootRequired = true;
-            }
-        }
-        if (!cfg["hotspot_password"].isNull()) {
-            const char* rawPass = cfg["hotspot_password"] | "";
-            configManager.setHotspotPassword(String(rawPass));
-            touched = true;
-            rebootRequired = true;
-        }
-        if (!cfg["ota_enabled"].isNull()) {
-            configManager.setOTAEnabled(cfg["ota_enabled"].as<bool>());
-            touched = true;
-        }
-        if (!cfg["led_count"].isNull()) {
-            configManager.setLedCount(cfg["led_count"].as<int>());
-            touched = true;
-            reapplyHardware = true;
-        }
-        if (!cfg["motor_left_gui"].isNull()) {
-            configManager.setMotorLeftGUI(constrain(cfg["motor_left_gui"].as<int>(), 0, 3));
-            touched = true;
-            reapplyHardware = true;
-        }
-        if (!cfg["motor_right_gui"].isNull()) {
-            configManager.setMotorRightGUI(constrain(cfg["motor_right_gui"].as<int>(), 0, 3));
-            touched = true;
-            reapplyHardware = true;
-        }
-        if (!cfg["bt_scan_on_normal_ms"].isNull()) {
-            configManager.setBtScanOnNormal(cfg["bt_scan_on_normal_ms"].as<int>());
-            touched = true;
-        }
-        if (!cfg["bt_scan_off_normal_ms"].isNull()) {
-            configManager.setBtScanOffNormal(cfg["bt_scan_off_normal_ms"].as<int>());
-            touched = true;
-        }
-        if (!cfg["bt_scan_on_sta_ms"].isNull()) {
-            configManager.setBtScanOnSta(cfg["bt_scan_on_sta_ms"].as<int>());
-            touched = true;
-        }
-        if (!cfg["bt_scan_off_sta_ms"].isNull()) {
-            configManager.setBtScanOffSta(cfg["bt_scan_off_sta_ms"].as<int>());
-            touched = true;
-        }
-        if (!cfg["bt_scan_on_ap_ms"].isNull()) {
-            configManager.setBtScanOnAp(cfg["bt_scan_on_ap_ms"].as<int>());
-            touched = true;
-        }
-        if (!cfg["bt_scan_off_ap_ms"].isNull()) {
-            configManager.setBtScanOffAp(cfg["bt_scan_off_ap_ms"].as<int>());
-            touched = true;
-        }
+        // Jedes Feld aus ConfigSchema.h (plus led_count/led_outputs/servo_settings) in einem Durchlauf
+        ConfigManager::ConfigChange change = configManager.applyJson(cfg);
+        bool touched = change.fields > 0;
+        bool reapplyHardware = change.sections & CFG_HARDWARE;
+        bool rebootRequired = change.sections & CFG_REBOOT;
 
         if (!touched) {
             resp["event"] = "error";
@@ -307,7 +350,8 @@ static void handleSerialCommandLine(const char* rawLine) {
             return;
         }
 
-        bool saved = configManager.saveConfig();
+        configManager.requestSave();
+        bool saved = configManager.flush();
         if (saved && reapplyHardware) {
             board.reApplyConfig();
         }
@@ -335,6 +379,23 @@ static void handleSerialCommandLine(const char* rawLine) {
         return;
     }
 
+    if (!strcmp(command, "bench_ws")) {
+        // Dekodier-Durchsatz der WS-Steuerformate (ohne Aktorik): {"cmd":"bench_ws","iterations":3000}
+        uint32_t iterations = constrain(cmd["iterations"] | 3000, 1, 100000);
+        WSControl::BenchResult r = WSControl::benchmark(iterations);
+        resp["event"] = "bench_ws";
+        resp["iterations"] = r.iterations;
+        resp["json_us"] = r.jsonUs;
+        resp["binary_us"] = r.binaryUs;
+        resp["json_fps"] = r.jsonUs ? (uint32_t)((uint64_t)r.iterations * 1000000ULL / r.jsonUs) : 0;
+        resp["binary_fps"] = r.binaryUs ? (uint32_t)((uint64_t)r.iterations * 1000000ULL / r.binaryUs) : 0;
+        resp["json_bytes_per_frame"] = r.jsonBytes / r.iterations;
+        resp["binary_bytes_per_frame"] = r.binaryBytes / r.iterations;
+        resp["json_heap_allocs"] = r.jsonHeapAllocs;
+        sendSerialJson(resp);
+        return;
+    }
+
     if (!strcmp(command, "reboot")) {
         resp["event"] = "restarting";
         sendSerialJson(resp);
@@ -407,9 +468,29 @@ void onConnectedController(ControllerPtr ctl) {
             board.notifyControllerConnected(i, mac, modelName.c_str());
             board.setLED(0, 0, 255, 0); // Green
             board.showLEDs();
-            if (radioMode == RadioMode::Normal) {
-                wifiPauseUntilMs = millis() + wifiPauseOnConnectMs;
+            memcpy(controllerAddr[i], properties.btaddr, sizeof(bd_addr_t));
+            uint32_t now = millis();
+            KnownController* known = findKnownController(properties.btaddr);
+            if (known && knownControllerExpected(*known, now) && radioScheduler.isReconnecting()) {
+                const uni_hid_device_t* d = uni_hid_device_get_instance_for_address(properties.btaddr);
+                bool direct = d && d->conn.direct_reconnect;
+                Console.printf("Controller back after %lu ms (%s)\n", (unsigned long)(now - known->lostAtMs),
+                               direct ? "direct page" : "page scan");
+                radioScheduler.onControllerReconnected(now - known->lostAtMs);
+            } else {
+                radioScheduler.onControllerConnected();
+            }
+            if (!known) {
+                // Freien Eintrag nehmen, sonst den am längsten verlorenen ersetzen
+                known = &knownControllers[0];
+                for (KnownController& k : knownControllers) {
+                    if (!k.used) { known = &k; break; }
+                    if (k.lost && (!known->lost || (int32_t)(k.lostAtMs - known->lostAtMs) < 0)) known = &k;
+                }
+                memcpy(known->addr, properties.btaddr, sizeof(bd_addr_t));
+                known->used = true;
             }
+            known->lost = false;
             break;
         }
     }
@@ -434,9 +515,13 @@ void onDisconnectedController(ControllerPtr ctl) {
             for (int j = 0; j < 4; j++) {
                 board.controlMotorStop(j);
             }
-            // BTstack braucht ~500ms um Disconnect vollständig abzuschliessen.
-            // Danach erst Scan neu starten, sonst kommt error=0x0c (Command Disallowed).
-            scanRestartAfterMs = millis() + 600;
+            KnownController* known = findKnownController(controllerAddr[i]);
+            if (known) {
+                known->lost = true;
+                known->lostAtMs = millis();
+            }
+            // Scan startet erst nach SCAN_RESTART_DELAY_MS neu (BTstack schliesst den Disconnect ab)
+            radioScheduler.onControllerDisconnected();
             break;
         }
     }
@@ -448,6 +533,15 @@ void onDisconnectedController(ControllerPtr ctl) {
 
 // Button/axis handling now driven by InputBindingManager
 
+// Irgendeine Taste, ein Stick oder Trigger außerhalb der Ruhelage. Bindings steuern auch Servos und
+// LEDs, daher zählt die Eingabe selbst und nicht nur, ob ein Motor läuft.
+static bool gamepadInputActive(ControllerPtr ctl) {
+    return ctl->buttons() || ctl->dpad() || ctl->miscButtons() ||
+           abs(ctl->axisX()) > btInputActiveDeadband || abs(ctl->axisY()) > btInputActiveDeadband ||
+           abs(ctl->axisRX()) > btInputActiveDeadband || abs(ctl->axisRY()) > btInputActiveDeadband ||
+           ctl->brake() > btInputActiveDeadband || ctl->throttle() > btInputActiveDeadband;
+}
+
 void processGamepad(ControllerPtr ctl) {
     // Dispatch to input binding manager
     int idx = findControllerIndex(ctl);
@@ -489,26 +583,38 @@ void processControllers() {
 
 // Arduino setup function. Runs in CPU 1
 void setup() {
+    boot_phase_end("btstack");
     WRITE_PERI_REG(RTC_CNTL_BROWN_OUT_REG, 0); //disable brownout detector
 
+    // GPIO39 is input-only on ESP32 and has no internal pull-up.
+    // The board uses external pull-up with active-low button wiring.
+    // Einmal abtasten: nur wer beim Start schon drückt, landet sofort in der Werksreset-Geste.
+    pinMode(MODE_BUTTON_PIN, INPUT);
+    bool modeHeldAtReset = digitalRead(MODE_BUTTON_PIN) == LOW;
+
     Serial.begin(115200);
 
     // DFPlayer initialization removed
 
+    boot_phase_begin("config");
     if (!configManager.init()) {
         Serial.println("Failed to init ConfigManager!");
     }
+    boot_phase_end("config");
+    boot_phase_begin("hardware");
     board.begin();
     boardReady = true;
-    // GPIO39 is input-only on ESP32 and has no internal pull-up.
-    // The board uses external pull-up with active-low button wiring.
-    pinMode(MODE_BUTTON_PIN, INPUT);
-    if (handleStartupReset()) {
+    boot_phase_end("hardware");
+    if (modeHeldAtReset && handleStartupReset()) {
         return;
     }
 
+    // WLAN startet hier im Hintergrund (WifiRadio-Task) und läuft parallel zum Rest
+    boot_phase_begin("services");
     board.startServices();
+    boot_phase_end("services");
 
+    boot_phase_begin("bluepad32");
     BP32.setup(&onConnectedController, &onDisconnectedController, true);
     BP32.enableVirtualDevice(false);
     BP32.enableBLEService(false);
@@ -526,46 +632,31 @@ void setup() {
     // nicht bei jedem normalen Boot – sonst schlägt die Re-Auth aller gepairten Controller fehl.
     // BP32.forgetBluetoothKeys(); // Removed: Causes pairing issues with clones
 
+    boot_phase_end("bluepad32");
+
     // Load input bindings from config
+    boot_phase_begin("bindings");
     inputBindings.reload();
+    boot_phase_end("bindings");
 
+    loadRadioTimings();
     applyRadioMode(radioMode);
+    startupResetArmUntilMs = millis() + startupResetArmMs;
     emitSerialReady();
 }
 
-// Arduino loop function. Runs in CPU 1.
-// Duty-cycle configuration for BT scanning (defaults overridden by ConfigManager)
-static uint32_t SCAN_ON_MS_NORMAL = 500;    // balanced when WiFi is idle
-static uint32_t SCAN_OFF_MS_NORMAL = 500;
-static uint32_t SCAN_ON_MS_STA_CONNECT = 150;  // give STA connect more airtime
-static uint32_t SCAN_OFF_MS_STA_CONNECT = 850;
-static uint32_t SCAN_ON_MS_AP_ACTIVE = 100;     // AP serving clients: keep scanning minimal
-static uint32_t SCAN_OFF_MS_AP_ACTIVE = 1900;
-
-static bool scanEnabled = false;
-static uint32_t nextToggleAt = 0;
-static uint32_t curOnMs = SCAN_ON_MS_NORMAL;
-static uint32_t curOffMs = SCAN_OFF_MS_NORMAL;
-static enum { PHASE_ON, PHASE_OFF } phase = PHASE_OFF;
-
 static void setStatusLed(uint8_t r, uint8_t g, uint8_t b) {
     if (!boardReady) return;
     board.setLED(0, r, g, b);
     board.showLEDs();
 }
 
+// Werksreset, wenn die Taste 10 s gehalten wird. Aufruf beim Start (Taste schon gedrückt) oder
+// aus loop() innerhalb von startupResetArmMs nach dem Start; blockiert nur, solange gedrückt.
 static bool handleStartupReset() {
     const uint32_t holdMs = 10000;
     const uint32_t stepMs = 250;
-    const uint32_t armWindowMs = 2500;
 
-    // Robust arming: allow a short window after boot where press can start.
-    // This avoids missing reset when boot/init timing shifts.
-    uint32_t armStart = millis();
-    while ((millis() - armStart) < armWindowMs) {
-        if (isModePressedStable()) break;
-        delay(10);
-    }
     if (!isModePressedStable()) {
         return false;
     }
@@ -596,47 +687,53 @@ static bool handleStartupReset() {
 
 static bool isModePressedStable() {
     // Majority vote over a few samples to filter bounce/noise on input-only GPIO39.
+    // ~2 ms statt 14 ms: die 10-s-Haltezeit filtert Prellen ohnehin.
     int lowCount = 0;
     for (int i = 0; i < 7; ++i) {
         if (digitalRead(MODE_BUTTON_PIN) == LOW) lowCount++;
-        delay(2);
+        delayMicroseconds(300);
     }
     return lowCount >= 5;
 }
 
 static void applyRadioMode(RadioMode mode) {
-    if (radioModeAppliedOnce && mode == lastAppliedMode) return;
-    radioModeAppliedOnce = true;
-    lastAppliedMode = mode;
-
-    if (mode == RadioMode::Normal) {
-        board.requestWifiEnable();
-        BP32.enableNewBluetoothConnections(false);
-        scanEnabled = false;
-        phase = PHASE_OFF;
-        nextToggleAt = millis();
-        setStatusLed(60, 60, 60); // dim white
-    } else if (mode == RadioMode::BluetoothOnly) {
-        board.requestWifiDisable(false);
-        BP32.enableNewBluetoothConnections(true);
-        scanEnabled = true;
-        phase = PHASE_ON;
-        setStatusLed(0, 0, 255);
-    } else if (mode == RadioMode::WifiOnly) {
-        // First drop BT connections, then disable scanning, then set color
-        for (int i = 0; i < BP32_MAX_GAMEPADS; i++) {
-            if (myControllers[i] && myControllers[i]->isConnected()) {
-                myControllers[i]->disconnect();
-            }
-        }
-        BP32.enableNewBluetoothConnections(false);
-        scanEnabled = false;
-        phase = PHASE_OFF;
-        board.requestWifiEnable();
-        setStatusLed(255, 120, 0);
-    }
+    if (!radioScheduler.setMode(mode)) return;
+    if (mode == RadioMode::Normal) setStatusLed(60, 60, 60); // dim white
+    else if (mode == RadioMode::BluetoothOnly) setStatusLed(0, 0, 255);
+    else setStatusLed(255, 120, 0);
+}
+
+// Wird ein Controller bedient (letzter Stand außerhalb der Ruhelage; ein gehaltener Stick meldet
+// sich bei manchen Controllern nicht neu) oder fährt ein Motor, bekommen die Controller-Verbindungen
+// kurze Abfrageintervalle; ist btLinkIdleAfterMs lang nichts davon passiert, dürfen sie in Sniff
+// gehen. Nur bei einem Wechsel an den BT-Task geben.
+static void updateBtLinkPolicy(uint32_t nowMs) {
+    bool inUse = false;
+    for (int i = 0; i < 4 && !inUse; i++) {
+        inUse = board.getMotorPWM(i) != 0;
+    }
+    for (int i = 0; i < BP32_MAX_GAMEPADS && !inUse; i++) {
+        ControllerPtr ctl = myControllers[i];
+        inUse = ctl && ctl->isConnected() && ctl->isGamepad() && gamepadInputActive(ctl);
+    }
+    if (inUse) lastActivityMs = nowMs;
+    bool active = inUse || (int32_t)(nowMs - lastActivityMs) < (int32_t)btLinkIdleAfterMs;
+    if (active == btLinksActive) return;
+    btLinksActive = active;
+    uni_bt_set_links_active_safe(active);
 }
 
+static void loadRadioTimings() {
+    ScanTimings t;
+    t.normal = {(uint32_t)configManager.getBtScanOnNormal(), (uint32_t)configManager.getBtScanOffNormal()};
+    t.staConnect = {(uint32_t)configManager.getBtScanOnSta(), (uint32_t)configManager.getBtScanOffSta()};
+    t.apActive = {(uint32_t)configManager.getBtScanOnAp(), (uint32_t)configManager.getBtScanOffAp()};
+    t.reconnectMs = (uint32_t)configManager.getBtReconnectMs();
+    radioScheduler.setTimings(t);
+    radioScheduler.setPolicy(configManager.getBtScanAdaptive() ? ScanPolicy::Adaptive : ScanPolicy::Fixed);
+}
+
+// Arduino loop function. Runs in CPU 1.
 void loop() {
     pollSerialCommands();
     // This call fetches all the controllers' data.
@@ -646,26 +743,27 @@ void loop() {
         processControllers();
     inputBindings.tick();
     // Refresh scan timings from config (lightweight)
-    SCAN_ON_MS_NORMAL       = configManager.getBtScanOnNormal();
-    SCAN_OFF_MS_NORMAL      = configManager.getBtScanOffNormal();
-    SCAN_ON_MS_STA_CONNECT  = configManager.getBtScanOnSta();
-    SCAN_OFF_MS_STA_CONNECT = configManager.getBtScanOffSta();
-    SCAN_ON_MS_AP_ACTIVE    = configManager.getBtScanOnAp();
-    SCAN_OFF_MS_AP_ACTIVE   = configManager.getBtScanOffAp();
+    loadRadioTimings();
 
     // Mode button handling (active-low, hold-to-switch for noise immunity)
     bool modeNow = (digitalRead(MODE_BUTTON_PIN) == LOW);
     uint32_t nowMs = millis();
+    if (startupResetArmUntilMs) {
+        if ((int32_t)(nowMs - startupResetArmUntilMs) >= 0) {
+            startupResetArmUntilMs = 0;
+        } else if (modeNow) {
+            // Innerhalb des Fensters gilt ein Druck als Werksreset-Geste, nicht als Moduswechsel
+            startupResetArmUntilMs = 0;
+            if (handleStartupReset()) return;
+            modeNow = false;
+        }
+    }
     if (modeNow) {
         if (modeButtonPressStartMs == 0) {
             modeButtonPressStartMs = nowMs;
             modeButtonLongPressHandled = false;
         } else if (!modeButtonLongPressHandled && (nowMs - modeButtonPressStartMs) >= modeButtonHoldToSwitchMs) {
-            modeStep = (modeStep + 1) % 4;
-            if (modeStep == 0) radioMode = RadioMode::Normal;
-            else if (modeStep == 1) radioMode = RadioMode::WifiOnly;
-            else if (modeStep == 2) radioMode = RadioMode::BluetoothOnly;
-            else radioMode = RadioMode::WifiOnly;
+            radioMode = radioScheduler.nextButtonMode();
             modeButtonLongPressHandled = true;
         }
     } else {
@@ -674,129 +772,26 @@ void loop() {
     }
     applyRadioMode(radioMode);
 
-    // Temporary WiFi pause to boost BT during connect (only in Normal mode)
-    // Kein enableNewBluetoothConnections(true) wenn Controller bereits verbunden –
-    // das Toggling stört BTstack und kann den PS3/DS3 zum Disconnect bringen.
-    bool anyControllerNow = false;
+    // WLAN-Pause nach Connect und BT-Such-Takt (RadioScheduler)
+    RadioSignals signals;
     for (int i = 0; i < BP32_MAX_GAMEPADS; i++) {
-        if (myControllers[i] && myControllers[i]->isConnected()) { anyControllerNow = true; break; }
+        if (myControllers[i] && myControllers[i]->isConnected()) { signals.anyController = true; break; }
     }
-    if (radioMode == RadioMode::Normal) {
-        uint32_t now = millis();
-        if (wifiPauseUntilMs > now) {
-            if (!wifiPausedForBt) {
-                board.requestWifiDisable(false);
-                if (!anyControllerNow)
-                    BP32.enableNewBluetoothConnections(true);
-                wifiPausedForBt = true;
-            }
-        } else if (wifiPausedForBt) {
-            board.requestWifiEnable();
-            wifiPausedForBt = false;
-        }
-    } else if (wifiPausedForBt) {
-        wifiPausedForBt = false;
-        wifiPauseUntilMs = 0;
-    }
-
-    // Determine current scenario and duty cycle settings
-    bool anyController = anyControllerNow;
-
     wifi_mode_t mode = WiFi.getMode();
-    bool staConnecting = (mode == WIFI_STA || mode == WIFI_AP_STA) && (WiFi.status() != WL_CONNECTED);
-    bool apActive = (mode == WIFI_AP || mode == WIFI_AP_STA) && (WiFi.softAPgetStationNum() > 0);
-    bool wifiDisabledUntilRestart = board.isWifiDisabledUntilRestart();
-
-    if (radioMode == RadioMode::BluetoothOnly) {
-        if (!scanEnabled) {
-            BP32.enableNewBluetoothConnections(true);
-            scanEnabled = true;
-        }
-        vTaskDelay(10);
-        return;
-    }
-
-    if (radioMode == RadioMode::WifiOnly) {
-        if (scanEnabled) {
-            BP32.enableNewBluetoothConnections(false);
-            scanEnabled = false;
-            phase = PHASE_OFF;
-        }
-        vTaskDelay(10);
-        return;
-    }
-
-    if (wifiDisabledUntilRestart) {
-        // Keep Bluetooth scanning fully enabled while Wi-Fi is down.
-        if (!anyController) {
-            if (!scanEnabled) {
-                BP32.enableNewBluetoothConnections(true);
-                scanEnabled = true;
-                phase = PHASE_ON;
-            }
-        } else if (scanEnabled) {
-            BP32.enableNewBluetoothConnections(false);
-            scanEnabled = false;
-            phase = PHASE_OFF;
-        }
+    signals.staConnecting = (mode == WIFI_STA || mode == WIFI_AP_STA) && (WiFi.status() != WL_CONNECTED);
+    signals.apActive = (mode == WIFI_AP || mode == WIFI_AP_STA) && (WiFi.softAPgetStationNum() > 0);
+    signals.wifiDisabledUntilRestart = board.isWifiDisabledUntilRestart();
+    signals.wsClients = board.getWsClientCount();
+    signals.wsTxQueue = board.getWsTxQueueMax();
+    uint32_t lastWsControlMs = board.getLastWsControlMs();
+    signals.wsControlActive = lastWsControlMs && millis() - lastWsControlMs < wsControlActiveMs;
+    radioScheduler.tick(signals);
+    updateBtLinkPolicy(nowMs);
+    if (radioMode != RadioMode::Normal || signals.wifiDisabledUntilRestart) {
         vTaskDelay(10);
         return;
     }
 
-    // Policy:
-    // - If a controller is already connected: don't scan.
-    // - Else if AP has clients: very low-duty scan.
-    // - Else if STA is connecting: low-duty scan.
-    // - Else: balanced scan.
-    uint32_t targetOn = SCAN_ON_MS_NORMAL;
-    uint32_t targetOff = SCAN_OFF_MS_NORMAL;
-    if (anyController) {
-        targetOn = 0; targetOff = 1000;  // keep scanning off
-    } else if (apActive) {
-        targetOn = SCAN_ON_MS_AP_ACTIVE; targetOff = SCAN_OFF_MS_AP_ACTIVE;
-    } else if (staConnecting) {
-        targetOn = SCAN_ON_MS_STA_CONNECT; targetOff = SCAN_OFF_MS_STA_CONNECT;
-    }
-
-    if (targetOn != curOnMs || targetOff != curOffMs) {
-        // Scenario changed: reset scheduler
-        curOnMs = targetOn; curOffMs = targetOff;
-        phase = PHASE_OFF;
-        scanEnabled = false;
-        BP32.enableNewBluetoothConnections(false);
-        nextToggleAt = millis() + curOffMs;
-    }
-
-    // Toggle scanning according to duty cycle (unless anyController)
-    uint32_t now = millis();
-    if (!anyController && now < scanRestartAfterMs) {
-        // Kurz nach Disconnect warten bevor Scan startet (verhindert 0x0c error)
-        vTaskDelay(10);
-        return;
-    }
-    if (!anyController) {
-        if (now >= nextToggleAt) {
-            if (phase == PHASE_OFF) {
-                // Turn scanning on for the on-duration
-                scanEnabled = (curOnMs > 0);
-                BP32.enableNewBluetoothConnections(scanEnabled);
-                phase = PHASE_ON;
-                nextToggleAt = now + (curOnMs > 0 ? curOnMs : curOffMs);
-            } else {
-                // Turn scanning off for the off-duration
-                scanEnabled = false;
-                BP32.enableNewBluetoothConnections(false);
-                phase = PHASE_OFF;
-                nextToggleAt = now + curOffMs;
-            }
-        }
-    } else if (scanEnabled) {
-        // Ensure scanning is off while a controller is connected
-        BP32.enableNewBluetoothConnections(false);
-        scanEnabled = false;
-        phase = PHASE_OFF;
-        nextToggleAt = now + 1000;
-    }
     //board.updateWebClients();
 
     // Heartbeat alle 5s – zeigt dass der ESP läuft
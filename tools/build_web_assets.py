@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Build the LittleFS web bundle from data/.
+
+- JS/CSS are gzipped and renamed by content hash into /a/ (e.g. /a/script.3fa2c1d0.js.gz).
+  The firmware serves /a/ with "Cache-Control: immutable", so browsers never ask again.
+- HTML pages get their references rewritten to the hashed names and are stored as <page>.html.gz.
+  The firmware answers them with the gzip CRC as ETag and "no-cache", i.e. a 304 when unchanged.
+- Everything else (config.json, images) is copied unchanged.
+
+Standalone:  python tools/build_web_assets.py [--src data] [--out build/webfs]
+PlatformIO:  extra_scripts = pre:tools/build_web_assets.py  (buildfs/uploadfs then use build/webfs)
+Embedded:    python tools/build_web_assets.py --embed WebAssetsData.cpp
+             writes the same bundle as a C++ table for main/WebAssets.h (CONFIG_TT_EMBED_WEB_UI);
+             main/CMakeLists.txt runs this during the firmware build.
+"""
+import argparse
+import gzip
+import hashlib
+import os
+import re
+import shutil
+import sys
+
+HASHED_EXTS = ('.js', '.css')
+PAGE_EXTS = ('.html',)
+HASHED_DIR = 'a'
+MIME_TYPES = {
+    '.html': 'text/html',
+    '.js': 'application/javascript',
+    '.css': 'text/css',
+    '.json': 'application/json',
+    '.png': 'image/png',
+    '.ico': 'image/x-icon',
+}
+
+
+class Asset:
+    """One file of the bundle, as served by the firmware."""
+
+    def __init__(self, path, data, gzipped, immutable):
+        self.path = path            # URL path without .gz, e.g. /a/script.3fa2c1d0.js
+        self.data = data            # stored bytes (gzip stream when gzipped)
+        self.gzipped = gzipped
+        self.immutable = immutable
+        ext = os.path.splitext(path)[1]
+        self.mime = MIME_TYPES.get(ext, 'application/octet-stream')
+
+    @property
+    def stored_name(self):
+        return self.path + ('.gz' if self.gzipped else '')
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:8]
+
+
+def gzip_bytes(data):
+    # mtime=0: same input, same bytes (and the same ETag) on every build
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def build_assets(src):
+    """Return (assets, renames) for all files in src; renames maps '/name' to '/a/name.<hash>.ext'."""
+    names = sorted(n for n in os.listdir(src) if os.path.isfile(os.path.join(src, n)))
+    assets = []
+    renames = {}
+    for name in names:
+        stem, ext = os.path.splitext(name)
+        if ext not in HASHED_EXTS:
+            continue
+        with open(os.path.join(src, name), 'rb') as f:
+            data = f.read()
+        path = '/%s/%s.%s%s' % (HASHED_DIR, stem, content_hash(data), ext)
+        renames['/' + name] = path
+        assets.append(Asset(path, gzip_bytes(data), True, True))
+
+    # src="script.js", href="/styles.css", src="/controls.js?v=7" -> hashed path
+    ref = re.compile(r'(src|href)="/?([^"?#/]+\.(?:js|css))(?:\?[^"]*)?"')
+
+    def rewrite(m):
+        target = renames.get('/' + m.group(2))
+        return '%s="%s"' % (m.group(1), target) if target else m.group(0)
+
+    for name in names:
+        stem, ext = os.path.splitext(name)
+        if ext in HASHED_EXTS:
+            continue
+        with open(os.path.join(src, name), 'rb') as f:
+            data = f.read()
+        if ext in PAGE_EXTS:
+            html = ref.sub(rewrite, data.decode('utf-8'))
+            assets.append(Asset('/' + name, gzip_bytes(html.encode('utf-8')), True, False))
+        else:
+            assets.append(Asset('/' + name, data, False, False))
+    return assets, renames
+
+
+def write_bundle(assets, out):
+    if os.path.isdir(out):
+        shutil.rmtree(out)
+    for a in assets:
+        target = os.path.join(out, a.stored_name.lstrip('/'))
+        os.makedirs(os.path.dirname(target), exist_ok=True)
+        with open(target, 'wb') as f:
+            f.write(a.data)
+
+
+# Device data, not UI: stays on LittleFS only
+NOT_EMBEDDED = ('/config.json',)
+
+
+def write_embedded(assets, out):
+    """Write assets as a path-sorted WebAsset table (see main/WebAssets.h)."""
+    embedded = sorted((a for a in assets if a.path not in NOT_EMBEDDED), key=lambda a: a.path)
+    lines = [
+        '// Generated by tools/build_web_assets.py from data/ - do not edit',
+        '#include "WebAssets.h"',
+        '',
+        '#if CONFIG_TT_EMBED_WEB_UI',
+        '',
+    ]
+    for i, a in enumerate(embedded):
+        lines.append('// %s (%d bytes%s)' % (a.path, len(a.data), ', gzip' if a.gzipped else ''))
+        lines.append('static const uint8_t asset%d[] = {' % i)
+        for off in range(0, len(a.data), 20):
+            lines.append('    ' + ','.join('0x%02x' % b for b in a.data[off:off + 20]) + ',')
+        lines.append('};')
+        lines.append('')
+    lines.append('const WebAsset WEB_ASSETS[] = {')
+    for i, a in enumerate(embedded):
+        lines.append('    { "%s", "%s", asset%d, sizeof(asset%d), "\\"%s\\"", %s, %s },' % (
+            a.path, a.mime, i, i, content_hash(a.data), 'true' if a.gzipped else 'false',
+            'true' if a.immutable else 'false'))
+    lines.append('};')
+    lines.append('const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);')
+    lines.append('')
+    lines.append('#endif')
+    lines.append('')
+    text = '\n'.join(lines)
+    # Unchanged output keeps the object file (and the incremental build) up to date
+    if os.path.isfile(out):
+        with open(out, 'r') as f:
+            if f.read() == text:
+                return embedded
+    os.makedirs(os.path.dirname(os.path.abspath(out)), exist_ok=True)
+    with open(out, 'w') as f:
+        f.write(text)
+    return embedded
+
+
+def report(src, assets):
+    raw = sum(os.path.getsize(os.path.join(src, n)) for n in os.listdir(src)
+              if os.path.isfile(os.path.join(src, n)))
+    stored = sum(len(a.data) for a in assets)
+    print('web assets: %d files, %d -> %d bytes (%.0f %%)' % (len(assets), raw, stored, 100.0 * stored / max(raw, 1)))
+    for a in assets:
+        print('  %-34s %7d %s' % (a.stored_name, len(a.data), 'immutable' if a.immutable else ''))
+
+
+def build(src, out, quiet=False):
+    assets, _ = build_assets(src)
+    write_bundle(assets, out)
+    if not quiet:
+        report(src, assets)
+    return assets
+
+
+def main(argv=None):
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--src', default=os.path.join(root, 'data'))
+    parser.add_argument('--out', default=os.path.join(root, 'build', 'webfs'))
+    parser.add_argument('--embed', metavar='CPP', help='write a C++ asset table instead of a LittleFS tree')
+    args = parser.parse_args(argv)
+    if args.embed:
+        assets, _ = build_assets(args.src)
+        embedded = write_embedded(assets, args.embed)
+        print('embedded web assets: %d files, %d bytes' % (len(embedded), sum(len(a.data) for a in embedded)))
+    else:
+        build(args.src, args.out)
+    return 0
+
+
+try:
+    Import('env')  # noqa: F821 - only defined under PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    project = env.subst('$PROJECT_DIR')
+    out = os.path.join(project, 'build', 'webfs')
+    build(os.path.join(project, 'data'), out)
+    env.Replace(PROJECT_DATA_DIR=out)
+elif __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,303 @@
+// Runs main/ConfigManager on the host against a scratch directory instead of LittleFS and checks
+// the schema-driven paths (main/ConfigSchema.h):
+//   load:      data/config.json is taken over once and replaced by /config.bin
+//   persist:   save -> load -> export gives the same JSON; a corrupted /config.bin falls back
+//   set:       applyJson clamps and trims, ignores unknown keys, reports only changed sections
+//   form:      applyForm with arrays as <key>_<i> and unchecked checkboxes
+//   export:    the streamed exportJson(Print&) matches the JsonDocument export for any chunk size,
+//              a change between two chunks aborts it
+//   static IP: wifi_static_ip / wifi_gateway / wifi_netmask / wifi_dns defaults and limits
+// and prints the load time of both formats.
+//
+// Build:  g++ -std=c++17 -O2 -Itools/config_host/stubs -Imain -Icomponents/ArduinoJson/src
+//             tools/config_host/config_host.cpp main/ConfigManager.cpp -o config_host
+// Usage:  ./config_host data/config.json
+#include "ConfigManager.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+HostSerial Serial;
+HostLittleFS LittleFS;
+
+static std::string fsDir;
+static int failures = 0;
+
+std::string hostFsPath(const char* path) { return fsDir + path; }
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                    \
+        }                                                                  \
+    } while (0)
+
+static bool copyFile(const char* from, const std::string& to) {
+    FILE* in = fopen(from, "rb");
+    if (!in) return false;
+    FILE* out = fopen(to.c_str(), "wb");
+    char buf[4096];
+    size_t n;
+    while (out && (n = fread(buf, 1, sizeof(buf), in)) > 0) fwrite(buf, 1, n, out);
+    fclose(in);
+    if (out) fclose(out);
+    return out != nullptr;
+}
+
+static void resetFs(const char* configJson) {
+    unlink(hostFsPath(ConfigManager::CONFIG_BIN_PATH).c_str());
+    copyFile(configJson, hostFsPath(ConfigManager::CONFIG_JSON_PATH));
+}
+
+static std::string exportDoc(ConfigManager& c) {
+    JsonDocument doc;
+    c.exportJson(doc.to<JsonObject>());
+    std::string s;
+    serializeJson(doc, s);
+    return s;
+}
+
+// Hands out bytes [from, from + len) of the export, like the chunked /getConfig response
+class WindowPrint : public Print {
+public:
+    WindowPrint(uint8_t* buf, size_t from, size_t len) : buf(buf), from(from), len(len) {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t n) override {
+        size_t skip = pos < from ? from - pos : 0;
+        if (skip < n && pos + skip < from + len) {
+            size_t at = pos + skip - from;
+            size_t count = std::min(n - skip, len - at);
+            memcpy(buf + at, data + skip, count);
+        }
+        pos += n;
+        if (pos >= from + len) setWriteError();
+        return n;
+    }
+    size_t filled() const { return pos <= from ? 0 : std::min(pos - from, len); }
+
+private:
+    uint8_t* buf;
+    size_t from, len;
+    size_t pos = 0;
+};
+
+static void testLoadAndPersist(const char* configJson) {
+    resetFs(configJson);
+    {
+        ConfigManager c;
+        CHECK(c.init());
+        CHECK(strcmp(c.getLoadSource(), "json") == 0);
+        CHECK(!LittleFS.exists(ConfigManager::CONFIG_JSON_PATH));
+        CHECK(LittleFS.exists(ConfigManager::CONFIG_BIN_PATH));
+        c.setWifiSSID("host");
+        c.setControlBindingsJson("[{\"a\":1}]");
+        c.requestSave();
+        c.flush();
+    }
+    std::string saved;
+    {
+        ConfigManager c;
+        CHECK(c.init());
+        CHECK(strcmp(c.getLoadSource(), "bin") == 0);
+        CHECK(c.getWifiSSID() == "host");
+        CHECK(c.getControlBindingsJson() == "[{\"a\":1}]");
+        saved = exportDoc(c);
+        CHECK(saved.find("\"control_bindings\":[{\"a\":1}]") != std::string::npos);
+
+        // Import replaces everything, the export of the result is the input again
+        JsonDocument in;
+        deserializeJson(in, saved);
+        in["wifi_ssid"] = "imported";
+        c.importJson(in.as<JsonObjectConst>());
+        c.saveConfig();
+    }
+    {
+        ConfigManager c;
+        c.init();
+        CHECK(c.getWifiSSID() == "imported");
+        CHECK(c.getControlBindingsJson() == "[{\"a\":1}]");
+    }
+
+    // One flipped byte: CRC mismatch, defaults instead of garbage
+    FILE* f = fopen(hostFsPath(ConfigManager::CONFIG_BIN_PATH).c_str(), "r+b");
+    fseek(f, 30, SEEK_SET);
+    int b = fgetc(f);
+    fseek(f, 30, SEEK_SET);
+    fputc(b ^ 0x55, f);
+    fclose(f);
+    ConfigManager c;
+    c.init();
+    CHECK(c.getWifiSSID() != "imported");
+}
+
+static void testApplyJson(const char* configJson) {
+    resetFs(configJson);
+    ConfigManager c;
+    CHECK(c.init());
+    JsonDocument in;
+    deserializeJson(in, R"({"wifi_ssid":"  net  ","led_brightness":999,"drive_mixer":"bogus","motor_left_gui":7,)"
+                        R"("led_outputs":[{"count":12}],"foo":1,"motor_invert":[true,false,true],"drive_turn_gain":"1.5"})");
+    String mixer = c.getDriveMixer();
+    ConfigManager::ConfigChange ch = c.applyJson(in.as<JsonObjectConst>());
+    CHECK(ch.fields == 7);   // "foo" is not a setting
+    CHECK(ch.sections & CFG_REBOOT);
+    CHECK(ch.sections & CFG_HARDWARE);
+    CHECK(c.getWifiSSID() == "net");
+    CHECK(c.getLedBrightness() == 255);
+    CHECK(c.getDriveMixer() == mixer);   // unknown enum value keeps the old one
+    CHECK(c.getMotorLeftGUI() == 3);
+    CHECK(c.getLedOutputCount(0) == 12);
+    CHECK(c.getMotorInvert(0) && !c.getMotorInvert(1) && c.getMotorInvert(2));
+    CHECK(c.getDriveTurnGain() == 1.5f);
+
+    ch = c.applyJson(in.as<JsonObjectConst>());
+    CHECK(ch.sections == 0);   // same values again: nothing to restart, reapply or save
+
+    c.setDriveTurnGain(9);
+    CHECK(c.getDriveTurnGain() == 2.5f);
+    String hotspot = c.getHotspotSSID();
+    c.setHotspotSSID("   ");   // CF_NONEMPTY
+    CHECK(c.getHotspotSSID() == hotspot);
+
+    JsonDocument fields;
+    c.exportFields(fields.to<JsonObject>());
+    CHECK(fields["control_bindings"].isNull());
+    CHECK(!fields["led_brightness"].isNull());
+}
+
+static void testApplyForm(const char* configJson) {
+    resetFs(configJson);
+    ConfigManager c;
+    CHECK(c.init());
+    ConfigManager::FormField form[] = {
+        {"wifi_mode", "STA"},     {"motor_invert_1", "on"},  {"motor_deadband_2", "77"},
+        {"led_count", "40"},      {"led_pin_1", "5"},        {"led_count_1", "8"},
+        {"led_order_1", "rgb"},   {"servo5_min", "600"},     {"servo5_max", "2400"},
+        {"drive_turn_gain", ""},  {"motor_curve_type", "expo"}, {"ota_enabled", "on"},
+    };
+    float gain = c.getDriveTurnGain();
+    ConfigManager::ConfigChange ch = c.applyForm(form, sizeof(form) / sizeof(form[0]));
+    CHECK(ch.fields == 12);
+    CHECK(c.getWifiMode() == "STA");
+    // Only motor_invert_1 was checked, the other boxes are off
+    CHECK(!c.getMotorInvert(0) && c.getMotorInvert(1) && !c.getMotorInvert(2));
+    CHECK(!c.getMotorSwap());
+    CHECK(c.getMotorDeadband(2) == 77);
+    CHECK(c.getLedCount() == 40);
+    CHECK(c.getLedOutputPin(1) == 5 && c.getLedOutputCount(1) == 8 && c.getLedOutputOrder(1) == "RGB");
+    CHECK(c.getServoMinPulsewidth(5) == 600 && c.getServoMaxPulsewidth(5) == 2400);
+    CHECK(c.getDriveTurnGain() == gain);   // empty text field: unchanged
+    CHECK(c.getMotorCurveType() == "expo");
+    CHECK(c.getOTAEnabled());
+
+    c.requestSave();
+    c.flush();
+    ConfigManager reloaded;
+    reloaded.init();
+    CHECK(exportDoc(reloaded) == exportDoc(c));
+}
+
+static void testStreamedExport(const char* configJson) {
+    resetFs(configJson);
+    ConfigManager c;
+    CHECK(c.init());
+    c.setWifiSSID("quote\" backslash\\ newline\n");
+    std::string expected = exportDoc(c);
+    static uint8_t buf[100000];
+    for (size_t chunk : {1, 7, 64, 1436, 100000}) {
+        std::string out;
+        for (;;) {
+            WindowPrint w(buf, out.size(), chunk);
+            c.exportJson(w, nullptr);
+            if (!w.filled()) break;
+            out.append((const char*)buf, w.filled());
+        }
+        JsonDocument parsed;
+        CHECK(!deserializeJson(parsed, out));
+        std::string normalized;
+        serializeJson(parsed, normalized);
+        CHECK(normalized == expected);
+    }
+
+    // A change between two chunks aborts the export instead of mixing two states
+    uint32_t gen = c.getGeneration();
+    WindowPrint first(buf, 0, 64);
+    CHECK(c.exportJson(first, nullptr, gen));
+    c.setLedBrightness(c.getLedBrightness() == 10 ? 11 : 10);
+    WindowPrint second(buf, 64, 64);
+    CHECK(!c.exportJson(second, nullptr, gen));
+    CHECK(second.filled() == 0);
+    gen = c.getGeneration();
+    c.setLedBrightness(c.getLedBrightness());   // unchanged value
+    CHECK(c.getGeneration() == gen);
+
+    std::string out;
+    WindowPrint w(buf, 0, sizeof(buf));
+    c.exportJson(w, "\"wifi_disabled_until_restart\":false");
+    out.assign((const char*)buf, w.filled());
+    JsonDocument parsed;
+    CHECK(!deserializeJson(parsed, out));
+    CHECK(parsed["wifi_disabled_until_restart"] == false);
+}
+
+static void testStaticIp(const char* configJson) {
+    resetFs(configJson);
+    ConfigManager c;
+    CHECK(c.init());
+    CHECK(c.getWifiStaticIp() == "");   // DHCP unless set
+    CHECK(c.getWifiNetmask() == "255.255.255.0");
+    JsonDocument in;
+    deserializeJson(in, R"({"wifi_static_ip":" 192.168.4.50 ","wifi_gateway":"192.168.4.1","wifi_netmask":"",)"
+                        R"("wifi_dns":"1.1.1.1.1.1.1.1.1.1"})");
+    ConfigManager::ConfigChange ch = c.applyJson(in.as<JsonObjectConst>());
+    CHECK(ch.sections == CFG_WIFI);
+    CHECK(c.getWifiStaticIp() == "192.168.4.50");
+    CHECK(c.getWifiGateway() == "192.168.4.1");
+    CHECK(c.getWifiNetmask() == "255.255.255.0");   // CF_NONEMPTY
+    CHECK(c.getWifiDns().length() <= 15);   // longer than any dotted quad
+}
+
+static void timeLoads(const char* configJson) {
+    const int runs = 200;
+    uint64_t binUs = 0, jsonUs = 0;
+    for (int i = 0; i < runs; i++) {
+        resetFs(configJson);
+        ConfigManager c;
+        c.loadConfig();
+        jsonUs += c.getLoadUs();
+    }
+    for (int i = 0; i < runs; i++) {
+        ConfigManager c;
+        c.loadConfig();
+        binUs += c.getLoadUs();
+    }
+    printf("load: json %.1f us, bin %.1f us (host, avg of %d)\n", jsonUs / (double)runs, binUs / (double)runs,
+           runs);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s data/config.json\n", argv[0]);
+        return 2;
+    }
+    char dir[] = "/tmp/config_host.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 2;
+    }
+    fsDir = dir;
+
+    testLoadAndPersist(argv[1]);
+    testApplyJson(argv[1]);
+    testApplyForm(argv[1]);
+    testStreamedExport(argv[1]);
+    testStaticIp(argv[1]);
+    timeLoads(argv[1]);
+
+    unlink(hostFsPath(ConfigManager::CONFIG_BIN_PATH).c_str());
+    unlink(hostFsPath(ConfigManager::CONFIG_JSON_PATH).c_str());
+    rmdir(dir);
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+// Host stand-ins for the Arduino/FreeRTOS pieces ConfigManager uses (tools/config_host only).
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+using std::isnan;
+
+#define constrain(a, lo, hi) ((a) < (lo) ? (lo) : ((a) > (hi) ? (hi) : (a)))
+
+inline uint32_t micros() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t millis() { return micros() / 1000; }
+
+class String : public std::string {
+public:
+    String() {}
+    String(const char* s) : std::string(s ? s : "") {}
+    String(const std::string& s) : std::string(s) {}
+    long toInt() const { return atol(c_str()); }
+    float toFloat() const { return atof(c_str()); }
+    unsigned length() const { return size(); }
+    void toUpperCase() { for (auto& c : *this) c = toupper(c); }
+    void trim() {
+        size_t b = find_first_not_of(" \t\r\n");
+        if (b == npos) { clear(); return; }
+        size_t e = find_last_not_of(" \t\r\n");
+        *this = String(std::string::substr(b, e - b + 1));
+    }
+    String substring(unsigned a, unsigned b) const { return String(std::string::substr(a, b - a)); }
+    void replace(const char* from, const char* to) {
+        std::string f(from), t(to);
+        for (size_t p = 0; (p = find(f, p)) != npos; p += t.size()) std::string::replace(p, f.size(), t);
+    }
+    void remove(unsigned i) { erase(i); }
+    // ArduinoJson serializes into String through these
+    size_t write(uint8_t c) { push_back((char)c); return 1; }
+    size_t write(const uint8_t* p, size_t n) { append((const char*)p, n); return n; }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* p, size_t n) {
+        for (size_t i = 0; i < n; i++) write(p[i]);
+        return n;
+    }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { char b[16]; snprintf(b, sizeof(b), "%d", v); return print(b); }
+    size_t printf(const char* f, ...) {
+        char b[256];
+        va_list a;
+        va_start(a, f);
+        vsnprintf(b, sizeof(b), f, a);
+        va_end(a);
+        return print(b);
+    }
+    int getWriteError() { return writeError; }
+    void clearWriteError() { writeError = 0; }
+
+protected:
+    void setWriteError(int err = 1) { writeError = err; }
+
+private:
+    int writeError = 0;
+};
+
+struct HostSerial {
+    void println(const char* s = "") { puts(s); }
+    void printf(const char* f, ...) { va_list a; va_start(a, f); vprintf(f, a); va_end(a); }
+};
+extern HostSerial Serial;
+
+// FreeRTOS: single-threaded on the host, the persist task is never started
+typedef void* SemaphoreHandle_t;
+typedef void* TaskHandle_t;
+#define portMAX_DELAY 0xffffffff
+#define pdTRUE 1
+#define pdMS_TO_TICKS(x) (x)
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return (void*)1; }
+inline int xSemaphoreTakeRecursive(SemaphoreHandle_t, uint32_t) { return 1; }
+inline int xSemaphoreGiveRecursive(SemaphoreHandle_t) { return 1; }
+inline int xTaskCreatePinnedToCore(void (*)(void*), const char*, int, void*, int, TaskHandle_t*, int) { return 1; }
+inline void xTaskNotifyGive(TaskHandle_t) {}
+inline uint32_t ulTaskNotifyTake(int, uint32_t) { return 0; }
@@ -0,0 +1,49 @@
+// LittleFS on a host directory; hostFsPath() maps "/config.bin" etc. into it (tools/config_host only).
+#pragma once
+#include <sys/stat.h>
+#include <cstdio>
+#include "Arduino.h"
+
+std::string hostFsPath(const char* path);
+
+class Stream {
+public:
+    virtual ~Stream() {}
+    virtual int read() = 0;
+    virtual size_t readBytes(char* buf, size_t n) = 0;
+};
+
+class File : public Stream {
+public:
+    File() {}
+    explicit File(FILE* f) : f(f) {}
+    explicit operator bool() const { return f; }
+    int read() override { return fgetc(f); }
+    size_t readBytes(char* buf, size_t n) override { return fread(buf, 1, n, f); }
+    size_t read(uint8_t* buf, size_t n) { return fread(buf, 1, n, f); }
+    size_t write(const uint8_t* buf, size_t n) { return fwrite(buf, 1, n, f); }
+    size_t size() {
+        long at = ftell(f);
+        fseek(f, 0, SEEK_END);
+        long end = ftell(f);
+        fseek(f, at, SEEK_SET);
+        return end;
+    }
+    void close() { if (f) fclose(f); f = nullptr; }
+
+private:
+    FILE* f = nullptr;
+};
+
+struct HostLittleFS {
+    bool begin(bool) { return true; }
+    File open(const char* path, const char* mode) {
+        return File(fopen(hostFsPath(path).c_str(), mode[0] == 'w' ? "wb" : "rb"));
+    }
+    bool exists(const char* path) { struct stat st; return stat(hostFsPath(path).c_str(), &st) == 0; }
+    bool remove(const char* path) { return ::remove(hostFsPath(path).c_str()) == 0; }
+    bool rename(const char* from, const char* to) {
+        return ::rename(hostFsPath(from).c_str(), hostFsPath(to).c_str()) == 0;
+    }
+};
+extern HostLittleFS LittleFS;
@@ -0,0 +1,3 @@
+#pragma once
+
+inline int esp_register_shutdown_handler(void (*)(void)) { return 0; }
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Measure web UI page loads against a running board, like a browser with a cache.
+
+For each page the HTML and every referenced script/stylesheet are fetched twice:
+  cold: empty cache
+  warm: second visit; immutable responses come from the cache, others are revalidated
+        with If-None-Match (a 304 carries no body)
+
+Usage:  python tools/measure_page_load.py [--host 192.168.4.1] [--pages / /config /controls /setup] [--runs 3]
+"""
+import argparse
+import gzip
+import http.client
+import re
+import time
+
+REF = re.compile(r'(?:src|href)="(/?[^"#:]+\.(?:js|css)(?:\?[^"]*)?)"')
+
+
+class Cache:
+    def __init__(self):
+        self.entries = {}   # path -> (etag, immutable, body)
+
+    def fetch(self, conn, path, stats):
+        cached = self.entries.get(path)
+        if cached and cached[1]:
+            stats['cached'] += 1
+            return cached[2]
+        headers = {'Accept-Encoding': 'gzip'}
+        if cached and cached[0]:
+            headers['If-None-Match'] = cached[0]
+        conn.request('GET', path, headers=headers)
+        resp = conn.getresponse()
+        body = resp.read()
+        stats['requests'] += 1
+        stats['bytes'] += len(body)
+        if resp.status == 304:
+            stats['not_modified'] += 1
+            return cached[2]
+        if resp.status != 200:
+            raise RuntimeError('%s -> HTTP %d' % (path, resp.status))
+        if resp.getheader('Content-Encoding') == 'gzip':
+            body = gzip.decompress(body)
+        cache_control = resp.getheader('Cache-Control') or ''
+        self.entries[path] = (resp.getheader('ETag'), 'immutable' in cache_control, body)
+        return body
+
+
+def load_page(host, page, cache):
+    stats = {'requests': 0, 'bytes': 0, 'not_modified': 0, 'cached': 0}
+    start = time.perf_counter()
+    conn = http.client.HTTPConnection(host, timeout=10)
+    try:
+        html = cache.fetch(conn, page, stats).decode('utf-8', 'replace')
+        for ref in REF.findall(html):
+            cache.fetch(conn, ref if ref.startswith('/') else '/' + ref, stats)
+    finally:
+        conn.close()
+    stats['ms'] = (time.perf_counter() - start) * 1000
+    return stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--host', default='192.168.4.1')
+    parser.add_argument('--pages', nargs='+', default=['/', '/config', '/controls', '/setup'])
+    parser.add_argument('--runs', type=int, default=3)
+    args = parser.parse_args()
+
+    print('%-10s %5s %8s %9s %5s %5s %8s' % ('page', 'load', 'requests', 'bytes', '304', 'cache', 'ms'))
+    for page in args.pages:
+        for run in range(args.runs):
+            cache = Cache()
+            for label in ('cold', 'warm'):
+                s = load_page(args.host, page, cache)
+                print('%-10s %5s %8d %9d %5d %5d %8.1f' % (
+                    page, label, s['requests'], s['bytes'], s['not_modified'], s['cached'], s['ms']))
+
+
+if __name__ == '__main__':
+    main()
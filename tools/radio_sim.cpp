@@ -0,0 +1,346 @@
+// Replays radio event traces against main/RadioScheduler on the host and compares scan policies.
+//
+// For every trace and policy (fixed, adaptive; "+rc" with the known-controller reconnect window,
+// without it reconnectMs = 0) it reports
+//   time-to-pair: controller enters pairing mode -> connected
+//   reconnect:    a lost controller is back in range -> connected
+//   WS latency:   web control frame sent -> delivered (Wi-Fi paused or shared with a BT scan)
+//   scan duty:    share of time the BT scan was on
+//
+// Build:  g++ -std=c++17 -O2 -Imain tools/radio_sim.cpp main/RadioScheduler.cpp -o radio_sim
+// Usage:  ./radio_sim [-v] tools/radio_traces/*.trace      (-v: print every pairing)
+//
+// Trace format, one event per line, time in ms from start ('#' starts a comment):
+//   <ms> pair [need_ms]    controller wants to connect; needs need_ms of scan-on time (default 80)
+//   <ms> lose              a connected controller drops out
+//   <ms> back [passive]    the lost controller is back and pages us; passive: it waits to be paged
+//                          (direct reconnect) or found by a scan
+//   <ms> ws <hz>           web client sends control frames at hz (0 = closed)
+//   <ms> ap_clients <n>    stations on the soft AP
+//   <ms> sta_connecting <0|1>
+//   <ms> mode <normal|bt|wifi>
+//   <ms> end               stop the run (default: 5 s after the last event)
+//
+// The radio model is deliberately simple: a frame sent while Wi-Fi is paused waits for the resume,
+// a frame sent during a scan window waits a pseudo-random share of the BT slots. A paging controller
+// gets through at our next page scan window (1.28 s apart, 320 ms with fast page scan) unless an
+// inquiry holds the radio (pessimistic: real controllers interleave some page scans); a direct page
+// reaches a passive controller after DIRECT_PAGE_MS.
+#include "RadioScheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t TICK_MS = 10;              // loop() cadence on the device
+const uint32_t WIFI_RESUME_MS = 300;      // pause -> STA/AP up again (direct reconnect)
+const uint32_t WS_BASE_LATENCY_MS = 4;
+const uint32_t WS_SCAN_PENALTY_MS = 40;   // worst extra wait while the BT scan holds the radio
+const uint32_t PAIR_GIVE_UP_MS = 60000;   // controllers leave pairing mode after about a minute
+const uint32_t DEFAULT_NEED_MS = 80;
+const uint32_t PAGE_SCAN_MS = 1280;       // BTstack default page scan interval
+const uint32_t FAST_PAGE_SCAN_MS = 320;   // uni_bt_bredr_set_fast_page_scan()
+const uint32_t DIRECT_PAGE_MS = 300;
+bool verbose = false;
+
+struct Event {
+    uint32_t at;
+    std::string what;
+    long arg;
+};
+
+struct Trace {
+    std::string name;
+    std::vector<Event> events;
+    uint32_t endMs = 0;
+};
+
+bool loadTrace(const char* path, Trace& trace) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    trace.name = path;
+    size_t slash = trace.name.find_last_of('/');
+    if (slash != std::string::npos) trace.name = trace.name.substr(slash + 1);
+    char line[256];
+    bool explicitEnd = false;
+    while (fgets(line, sizeof(line), f)) {
+        char* hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        unsigned long at;
+        char what[32];
+        char argText[32] = "";
+        int n = sscanf(line, "%lu %31s %31s", &at, what, argText);
+        if (n < 2) continue;
+        Event e = {(uint32_t)at, what, -1};
+        if (e.what == "mode") {
+            e.arg = !strcmp(argText, "bt") ? 1 : !strcmp(argText, "wifi") ? 2 : 0;
+        } else if (e.what == "back") {
+            e.arg = !strcmp(argText, "passive") ? 1 : 0;
+        } else if (n == 3) {
+            e.arg = strtol(argText, nullptr, 10);
+        }
+        if (e.what == "end") {
+            trace.endMs = e.at;
+            explicitEnd = true;
+            continue;
+        }
+        trace.events.push_back(e);
+    }
+    fclose(f);
+    std::stable_sort(trace.events.begin(), trace.events.end(),
+                     [](const Event& a, const Event& b) { return a.at < b.at; });
+    if (!explicitEnd) trace.endMs = (trace.events.empty() ? 0 : trace.events.back().at) + 5000;
+    return true;
+}
+
+class SimClock : public RadioClock {
+public:
+    uint32_t now = 0;
+    uint32_t nowMs() override { return now; }
+};
+
+class SimBt : public BtScanControl {
+public:
+    SimClock& clock;
+    bool scanning = false;
+    bool fastPageScan = false;
+    int disconnects = 0;
+    uint32_t directPageAt = 0;
+    bool directPaged = false;
+    explicit SimBt(SimClock& c) : clock(c) {}
+    void setScanEnabled(bool on) override { scanning = on; }
+    void disconnectAll() override { disconnects++; }
+    void setFastPageScan(bool on) override { fastPageScan = on; }
+    void reconnectKnown() override {
+        directPaged = true;
+        directPageAt = clock.now + DIRECT_PAGE_MS;
+    }
+};
+
+class SimWifi : public WifiControl {
+public:
+    SimClock& clock;
+    bool up = true;
+    uint32_t upAt = 0;
+    explicit SimWifi(SimClock& c) : clock(c) {}
+    void requestEnable() override {
+        if (up) return;
+        up = true;
+        upAt = clock.now + WIFI_RESUME_MS;
+    }
+    void requestPause() override { up = false; }
+    bool isUp(uint32_t now) const { return up && (int32_t)(now - upAt) >= 0; }
+};
+
+struct Pending {
+    uint32_t since;
+    uint32_t needMs;
+    uint32_t scanned;
+    bool returning;    // "back": a known controller
+    bool passive;
+    uint32_t phase;    // of its page attempts against our page scan windows
+};
+
+struct Result {
+    std::vector<uint32_t> pairMs;
+    int pairFailed = 0;
+    std::vector<uint32_t> reconnectMs;
+    int reconnectFailed = 0;
+    std::vector<uint32_t> wsLatency;
+    uint32_t scanOnMs = 0;
+    uint32_t totalMs = 0;
+};
+
+uint32_t percentile(std::vector<uint32_t> v, int p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, v.size() * p / 100)];
+}
+
+double mean(const std::vector<uint32_t>& v) {
+    if (v.empty()) return 0;
+    double sum = 0;
+    for (uint32_t x : v) sum += x;
+    return sum / v.size();
+}
+
+Result run(const Trace& trace, ScanPolicy policy, bool reconnect) {
+    SimClock clock;
+    SimBt bt(clock);
+    SimWifi wifi(clock);
+    RadioScheduler sched(clock, bt, wifi);
+    sched.setPolicy(policy);
+    ScanTimings timings;
+    if (!reconnect) timings.reconnectMs = 0;
+    sched.setTimings(timings);
+    const char* label = reconnect ? (policy == ScanPolicy::Adaptive ? "adaptive+rc" : "fixed+rc")
+                                  : RadioScheduler::policyName(policy);
+
+    Result r;
+    RadioMode mode = RadioMode::Normal;
+    sched.setMode(mode);
+    std::vector<Pending> pending;
+    int connected = 0;
+    int apClients = 0;
+    bool staConnecting = false;
+    uint32_t wsHz = 0;
+    uint32_t nextFrameAt = 0;
+    uint32_t lastControlAt = 0;
+    bool controlSeen = false;
+    std::vector<uint32_t> inFlight;   // delivery times of frames not yet delivered
+    std::vector<uint32_t> held;       // send times of frames waiting for Wi-Fi
+    uint32_t rng = 12345;
+    uint32_t lostAt = 0;
+    size_t next = 0;
+
+    for (clock.now = 0; clock.now <= trace.endMs; clock.now += TICK_MS) {
+        uint32_t now = clock.now;
+        while (next < trace.events.size() && trace.events[next].at <= now) {
+            const Event& e = trace.events[next++];
+            if (e.what == "pair") {
+                pending.push_back({now, e.arg > 0 ? (uint32_t)e.arg : DEFAULT_NEED_MS, 0, false, false, 0});
+            } else if (e.what == "back") {
+                rng = rng * 1103515245u + 12345u;
+                pending.push_back({now, DEFAULT_NEED_MS, 0, true, e.arg == 1, (rng >> 16) % PAGE_SCAN_MS});
+            } else if (e.what == "lose") {
+                if (connected > 0) {
+                    connected--;
+                    lostAt = now;
+                    bt.directPaged = false;
+                    sched.onControllerDisconnected();
+                }
+            } else if (e.what == "ws") {
+                wsHz = e.arg > 0 ? (uint32_t)e.arg : 0;
+                nextFrameAt = now;
+            } else if (e.what == "ap_clients") {
+                apClients = (int)e.arg;
+            } else if (e.what == "sta_connecting") {
+                staConnecting = e.arg != 0;
+            } else if (e.what == "mode") {
+                mode = e.arg == 1 ? RadioMode::BluetoothOnly : e.arg == 2 ? RadioMode::WifiOnly : RadioMode::Normal;
+                sched.setMode(mode);
+            } else {
+                fprintf(stderr, "%s: unknown event '%s' at %u ms\n", trace.name.c_str(), e.what.c_str(), e.at);
+            }
+        }
+
+        // Web client: frames over the tick; latency from the radio state at send time
+        while (wsHz && (int32_t)(now - nextFrameAt) >= 0) {
+            uint32_t sentAt = nextFrameAt;
+            if (!wifi.isUp(sentAt)) {
+                held.push_back(sentAt);   // delivered once Wi-Fi is back
+            } else {
+                uint32_t deliverAt = sentAt + WS_BASE_LATENCY_MS;
+                if (bt.scanning) {
+                    rng = rng * 1103515245u + 12345u;
+                    deliverAt += (rng >> 16) % (WS_SCAN_PENALTY_MS + 1);
+                }
+                r.wsLatency.push_back(deliverAt - sentAt);
+                inFlight.push_back(deliverAt);
+            }
+            lastControlAt = sentAt;
+            controlSeen = true;
+            nextFrameAt += 1000 / wsHz;
+        }
+        if (!held.empty() && wifi.isUp(now)) {
+            for (uint32_t sentAt : held) r.wsLatency.push_back(now - sentAt + WS_BASE_LATENCY_MS);
+            held.clear();
+        }
+        inFlight.erase(std::remove_if(inFlight.begin(), inFlight.end(),
+                                      [now](uint32_t t) { return (int32_t)(now - t) >= 0; }),
+                       inFlight.end());
+
+        // Controllers waiting to connect see the scan only while it is on; a returning controller
+        // also gets through our page scan (not while an inquiry runs) or a direct page
+        for (size_t i = 0; i < pending.size();) {
+            Pending& p = pending[i];
+            // A returning controller pages instead of being discoverable: the scan does not find it
+            if (bt.scanning && connected < 2 && (!p.returning || p.passive)) p.scanned += TICK_MS;
+            bool paged = false;
+            if (p.returning && connected < 2) {
+                uint32_t interval = bt.fastPageScan ? FAST_PAGE_SCAN_MS : PAGE_SCAN_MS;
+                if (!p.passive && !bt.scanning && (now - p.phase) % interval < TICK_MS) paged = true;
+                if (p.passive && bt.directPaged && (int32_t)(now - bt.directPageAt) >= 0) paged = true;
+            }
+            if (p.scanned >= p.needMs || paged) {
+                if (verbose) {
+                    printf("  %s %s: %s from %u ms connected after %u ms%s\n", trace.name.c_str(), label,
+                           p.returning ? "back" : "pair", p.since, now - p.since, paged ? " (page)" : "");
+                }
+                (p.returning ? r.reconnectMs : r.pairMs).push_back(now - p.since);
+                connected++;
+                if (sched.isReconnecting()) {
+                    sched.onControllerReconnected(now - lostAt);
+                } else {
+                    sched.onControllerConnected();
+                }
+                pending.erase(pending.begin() + i);
+            } else if (now - p.since > PAIR_GIVE_UP_MS) {
+                if (verbose) {
+                    printf("  %s %s: %s from %u ms gave up\n", trace.name.c_str(), label,
+                           p.returning ? "back" : "pair", p.since);
+                }
+                (p.returning ? r.reconnectFailed : r.pairFailed)++;
+                pending.erase(pending.begin() + i);
+            } else {
+                i++;
+            }
+        }
+
+        RadioSignals s;
+        s.anyController = connected > 0;
+        s.staConnecting = staConnecting && wifi.up;
+        s.apActive = apClients > 0 && wifi.up;
+        s.wsClients = wsHz ? 1 : 0;
+        s.wsTxQueue = (uint16_t)(inFlight.size() + held.size());
+        s.wsControlActive = controlSeen && now - lastControlAt < 1000;
+        sched.tick(s);
+        if (bt.scanning) r.scanOnMs += TICK_MS;
+        r.totalMs += TICK_MS;
+    }
+    for (const Pending& p : pending) (p.returning ? r.reconnectFailed : r.pairFailed)++;
+    return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int first = 1;
+    if (argc > 1 && !strcmp(argv[1], "-v")) {
+        verbose = true;
+        first = 2;
+    }
+    if (argc <= first) {
+        fprintf(stderr, "usage: %s [-v] <trace>...\n", argv[0]);
+        return 2;
+    }
+    printf("%-22s %-11s %5s %4s %8s %8s %4s %4s %7s %7s %7s %7s %6s\n", "trace", "policy", "pairs", "fail",
+           "ttp_avg", "ttp_max", "rc", "fail", "rc_avg", "rc_max", "ws_avg", "ws_p95", "scan%");
+    for (int i = first; i < argc; i++) {
+        Trace trace;
+        if (!loadTrace(argv[i], trace)) return 1;
+        for (bool reconnect : {false, true}) {
+            for (ScanPolicy policy : {ScanPolicy::Fixed, ScanPolicy::Adaptive}) {
+                Result r = run(trace, policy, reconnect);
+                printf("%-22s %-11s %5zu %4d %8.0f %8u %4zu %4d %7.0f %7u %7.1f %7u %6.1f\n", trace.name.c_str(),
+                       reconnect ? (policy == ScanPolicy::Adaptive ? "adaptive+rc" : "fixed+rc")
+                                 : RadioScheduler::policyName(policy),
+                       r.pairMs.size(), r.pairFailed, mean(r.pairMs),
+                       r.pairMs.empty() ? 0 : *std::max_element(r.pairMs.begin(), r.pairMs.end()),
+                       r.reconnectMs.size(), r.reconnectFailed, mean(r.reconnectMs),
+                       r.reconnectMs.empty() ? 0 : *std::max_element(r.reconnectMs.begin(), r.reconnectMs.end()),
+                       mean(r.wsLatency), percentile(r.wsLatency, 95),
+                       r.totalMs ? 100.0 * r.scanOnMs / r.totalMs : 0.0);
+            }
+        }
+    }
+    return 0;
+}